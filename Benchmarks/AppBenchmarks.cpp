@@ -0,0 +1,404 @@
+// The app's own hot paths: price history, table filtering and sorting,
+// snapshot publication, a whole refresh cycle, favorites persistence and
+// full ImGui table frames.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "CoinStreamDecoder.h"
+#include "CoinTable.h"
+#include "FavoritesFile.h"
+#include "HeadlessImGui.h"
+#include "MarketSnapshot.h"
+#include "PriceHistory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+constexpr size_t MAX_HISTORY_POINTS = 120;   // as in CryptoTracker.cpp
+
+// ---------------------------------------------------------------------
+// History
+// ---------------------------------------------------------------------
+
+// Steady state: the history is full, so every push also drops the oldest point.
+void historyPushFull(bench::State& state) {
+    std::vector<float> history(MAX_HISTORY_POINTS, 1.0f);
+    double price = 100.0;
+    state.measure([&] {
+        price += 0.01;
+        AppendPricePoint(history, price, MAX_HISTORY_POINTS);
+        bench::DoNotOptimize(history);
+    });
+}
+
+// One refresh: a point for every coin, through the symbol-keyed map.
+void historyRefresh(bench::State& state, size_t count) {
+    const auto coins = bench::syntheticCoins(count);
+    std::unordered_map<std::string, std::vector<float>> history;
+    for (const auto& coin : coins) history[coin.symbol].assign(MAX_HISTORY_POINTS, 1.0f);
+
+    state.measure([&] {
+        for (const auto& coin : coins) {
+            AppendPricePoint(history[coin.symbol], coin.current_price, MAX_HISTORY_POINTS);
+        }
+    }, static_cast<double>(count));
+}
+
+// ---------------------------------------------------------------------
+// Filtering and sorting
+// ---------------------------------------------------------------------
+
+void filterSearch(bench::State& state, size_t count, const char* search) {
+    const auto coins = bench::syntheticCoins(count);
+    std::string searchLower = search;
+    ToLowerAscii(searchLower);
+    size_t matched = 0;
+
+    state.measure([&] {
+        size_t hits = 0;
+        for (const auto& coin : coins) {
+            if (MatchesSearch(coin, searchLower)) ++hits;
+        }
+        matched = hits;
+    }, static_cast<double>(count));
+    state.counter("matched", static_cast<double>(matched));
+}
+
+void filterFavorites(bench::State& state, size_t count) {
+    const auto coins = bench::syntheticCoins(count);
+    std::unordered_set<std::string> favorites;
+    for (size_t i = 0; i < count; i += 50) favorites.insert(coins[i].symbol);
+
+    state.measure([&] {
+        size_t hits = 0;
+        for (const auto& coin : coins) {
+            if (favorites.count(coin.symbol)) ++hits;
+        }
+        bench::DoNotOptimize(hits);
+    }, static_cast<double>(count));
+}
+
+// Sorting row pointers the way a sortable table would; starts from the same
+// shuffled order every time.
+template <typename Less>
+void sortRows(bench::State& state, size_t count, Less less) {
+    const auto coins = bench::syntheticCoins(count);
+    std::vector<const CryptoCoin*> shuffled;
+    for (const auto& coin : coins) shuffled.push_back(&coin);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(3));
+
+    std::vector<const CryptoCoin*> rows;
+    state.measure([&] {
+        rows = shuffled;
+        std::sort(rows.begin(), rows.end(), less);
+        bench::DoNotOptimize(rows);
+    }, static_cast<double>(count));
+}
+
+void sortByMarketCap(bench::State& state, size_t count) {
+    sortRows(state, count, [](const CryptoCoin* a, const CryptoCoin* b) { return a->market_cap > b->market_cap; });
+}
+
+void sortByName(bench::State& state, size_t count) {
+    sortRows(state, count, [](const CryptoCoin* a, const CryptoCoin* b) { return a->name < b->name; });
+}
+
+// ---------------------------------------------------------------------
+// Snapshot publication (capture + serialize + swap), as DataFetcher does it
+// ---------------------------------------------------------------------
+
+void snapshotPublish(bench::State& state, size_t count) {
+    const auto coins = bench::syntheticCoins(count);
+    std::unordered_map<std::string, std::vector<float>> history;
+    for (const auto& coin : coins) history[coin.symbol].assign(MAX_HISTORY_POINTS, 1.0f);
+
+    SnapshotStore store;
+    unsigned long long version = 0;
+    size_t jsonBytes = 0, binaryBytes = 0;
+
+    state.measure([&] {
+        auto snap = std::make_shared<MarketSnapshot>();
+        snap->version = ++version;
+        snap->coins = coins;
+        for (const auto& entry : history) {
+            snap->history[entry.first] = std::make_shared<const std::vector<float>>(entry.second);
+        }
+        store.publish(std::move(snap));
+        SnapshotPtr current = store.current();
+        jsonBytes = current->json.size();
+        binaryBytes = current->binary.size();
+    }, static_cast<double>(count));
+    state.counter("json_bytes", static_cast<double>(jsonBytes));
+    state.counter("binary_bytes", static_cast<double>(binaryBytes));
+}
+
+// ---------------------------------------------------------------------
+// One full refresh as DataFetcher runs it once the body has arrived:
+// streaming decode, replace the coin list, history / staleness / universe
+// bookkeeping, capture and publish. allocs_per_op is the per-refresh
+// allocation count.
+// ---------------------------------------------------------------------
+
+void refreshCycle(bench::State& state, size_t count) {
+    const std::string body = bench::syntheticMarketsJson(count);
+    std::vector<CryptoCoin> coins;
+    std::unordered_map<std::string, std::vector<float>> history;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastUpdate;
+    SnapshotStore store;
+    unsigned long long version = 0;
+    constexpr size_t CHUNK = 16 * 1024;
+
+    state.measure([&] {
+        std::vector<CryptoCoin> newData;
+        CoinStreamDecoder decoder([&newData](CryptoCoin&& coin) { newData.push_back(std::move(coin)); });
+        for (size_t at = 0; at < body.size(); at += CHUNK) {
+            decoder.feed(body.data() + at, std::min(CHUNK, body.size() - at));
+        }
+        decoder.finish();
+
+        coins = newData;
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<std::string> changed;
+        for (const auto& coin : coins) {
+            changed.push_back(coin.symbol);
+            AppendPricePoint(history[coin.symbol], coin.current_price, MAX_HISTORY_POINTS);
+            lastUpdate[coin.symbol] = now;
+        }
+        std::unordered_set<std::string> universe;
+        for (const auto& coin : coins) universe.insert(coin.id);
+
+        auto snap = std::make_shared<MarketSnapshot>();
+        snap->version = ++version;
+        snap->coins = coins;
+        snap->history = store.current()->history;
+        for (const auto& symbol : changed) {
+            snap->history[symbol] = std::make_shared<const std::vector<float>>(history[symbol]);
+        }
+        store.publish(std::move(snap));
+    }, static_cast<double>(count));
+}
+
+// ---------------------------------------------------------------------
+// Favorites persistence
+// ---------------------------------------------------------------------
+
+std::filesystem::path scratchFile(const char* name) {
+    return std::filesystem::temp_directory_path() / "cryptotracker_bench" / name;
+}
+
+void favoritesWrite(bench::State& state, size_t count) {
+    std::unordered_set<std::string> favorites;
+    for (const auto& coin : bench::syntheticCoins(count)) favorites.insert(coin.symbol);
+    const auto path = scratchFile("favorites.txt");
+
+    state.measure([&] { WriteFavoritesFile(path, favorites); });
+    state.counter("file_bytes", static_cast<double>(std::filesystem::file_size(path)));
+    std::filesystem::remove(path);
+}
+
+void favoritesRead(bench::State& state, size_t count) {
+    std::unordered_set<std::string> favorites;
+    for (const auto& coin : bench::syntheticCoins(count)) favorites.insert(coin.symbol);
+    const auto path = scratchFile("favorites.txt");
+    WriteFavoritesFile(path, favorites);
+
+    state.measure([&] {
+        std::unordered_set<std::string> loaded;
+        ReadFavoritesFile(path, loaded);
+        bench::DoNotOptimize(loaded);
+    });
+    std::filesystem::remove(path);
+}
+
+// 10k rapid toggles through DebouncedFileWriter, as the UI makes them (list
+// under a mutex, requestSave() while holding it). p50/p99 are the UI-side
+// cost of one toggle. A second thread keeps re-reading favorites.txt and
+// checks that every version it sees is a complete list.
+void favoritesToggleBurst(bench::State& state) {
+    const auto coins = bench::syntheticCoins(1000);
+    std::unordered_set<std::string> universe;
+    for (const auto& coin : coins) universe.insert(coin.symbol);
+
+    const auto path = scratchFile("favorites_burst.txt");
+    std::filesystem::remove(path);
+    std::mutex dataMutex;
+    std::unordered_set<std::string> favorites;
+    DebouncedFileWriter writer(path, [&] {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        return FavoritesFileContent(favorites);
+    }, std::chrono::milliseconds(2), std::chrono::milliseconds(50));
+    writer.start();
+
+    std::atomic<bool> running{ true };
+    std::atomic<unsigned long long> reads{ 0 }, corrupt{ 0 };
+    std::thread reader([&] {
+        while (running) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) continue;
+            std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            bool ok = content.empty() || content.back() == '\n';
+            size_t begin = 0;
+            while (ok && begin < content.size()) {
+                size_t end = content.find('\n', begin);
+                ok = universe.count(content.substr(begin, end - begin)) > 0;
+                begin = end + 1;
+            }
+            ++reads;
+            if (!ok) ++corrupt;
+        }
+    });
+
+    const int toggles = state.quick() ? 2000 : 10000;
+    std::vector<double> toggleNs;
+    toggleNs.reserve(toggles);
+    std::mt19937 rng(5);
+    for (int i = 0; i < toggles; ++i) {
+        const std::string& symbol = coins[rng() % coins.size()].symbol;
+        const auto started = bench::Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(dataMutex);
+            if (!favorites.erase(symbol)) favorites.insert(symbol);
+            writer.requestSave();
+        }
+        toggleNs.push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - started).count());
+        if (i % 100 == 99) std::this_thread::sleep_for(std::chrono::milliseconds(5));   // bursts of 100 toggles
+    }
+    writer.flush();
+    running = false;
+    reader.join();
+
+    std::unordered_set<std::string> saved;
+    ReadFavoritesFile(path, saved);
+    const unsigned long long writes = writer.writes();
+    writer.stop();
+    std::filesystem::remove(path);
+
+    state.samples(std::move(toggleNs));
+    state.counter("toggles", toggles);
+    state.counter("writes", static_cast<double>(writes));
+    state.counter("file_reads_checked", static_cast<double>(reads.load()));
+    state.counter("corrupt_reads", static_cast<double>(corrupt.load()));
+    state.expect(corrupt == 0, "a reader saw a partial favorites file");
+    state.expect(saved == favorites, "favorites file does not match the final list after flush()");
+}
+
+// ---------------------------------------------------------------------
+// Headless ImGui frames of the real table code
+// ---------------------------------------------------------------------
+
+void tableFrame(bench::State& state, size_t count, const char* search) {
+    const auto coins = bench::syntheticCoins(count);
+    std::unordered_set<std::string> favorites;
+    for (size_t i = 0; i < count; i += 50) favorites.insert(coins[i].symbol);
+    std::unordered_map<std::string, std::vector<float>> history;
+    history[coins[0].symbol].assign(MAX_HISTORY_POINTS, 1.0f);
+    std::string selected = coins[0].symbol;
+
+    std::vector<CoinCellText> cells;
+    UpdateCoinCells(coins, cells, NumberFormat());
+
+    HeadlessImGui ui;
+    CoinTableModel model{ coins, cells, favorites, history, selected };
+    CoinTableFilter filter{ search, false };
+    CoinTableActions actions;
+    CoinTableCache cache;
+    size_t visible = 0;
+    actions.rowVisible = [&visible](const std::string&) { ++visible; };
+
+    size_t vertices = 0;
+    state.measure([&] {
+        visible = 0;
+        ui.frame([&] { DrawCoinTable(model, filter, actions, cache); });
+        vertices = static_cast<size_t>(ImGui::GetDrawData()->TotalVtxCount);
+    });
+    state.counter("rows_visible", static_cast<double>(visible));
+    state.counter("vertices", static_cast<double>(vertices));
+}
+
+// The zero-allocation budget: after a few warm-up frames, 1000 frames over
+// 10k coins (a search typed, one price ticking) must not touch the heap.
+void tableSteadyState(bench::State& state) {
+    auto coins = bench::syntheticCoins(10000);
+    std::unordered_set<std::string> favorites;
+    for (size_t i = 0; i < coins.size(); i += 50) favorites.insert(coins[i].symbol);
+    std::unordered_map<std::string, std::vector<float>> history;
+    history[coins[0].symbol].assign(MAX_HISTORY_POINTS, 1.0f);
+    std::string selected = coins[0].symbol;
+
+    std::vector<CoinCellText> cells;
+    UpdateCoinCells(coins, cells, NumberFormat());
+
+    HeadlessImGui ui;
+    CoinTableModel model{ coins, cells, favorites, history, selected };
+    CoinTableFilter filter{ "liquid staked", false };
+    CoinTableActions actions;
+    actions.rowVisible = [](const std::string&) {};
+    CoinTableCache cache;
+
+    auto frame = [&] { ui.frame([&] { DrawCoinTable(model, filter, actions, cache); }); };
+    for (int i = 0; i < 10; ++i) frame();
+
+    const int frames = state.quick() ? 100 : 1000;
+    std::vector<double> frameNs;
+    frameNs.reserve(frames);
+    alloc::Counts allocated;
+    for (int i = 0; i < frames; ++i) {
+        coins[i % 32].current_price *= 1.0001;   // a scheduler merge, formatted at capture
+        UpdateCoinCells(coins, cells, NumberFormat());
+        alloc::Scope scope;
+        const auto started = bench::Clock::now();
+        frame();
+        frameNs.push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - started).count());
+        const alloc::Counts delta = scope.delta();
+        allocated.allocations += delta.allocations;
+        allocated.bytes += delta.bytes;
+    }
+
+    state.samples(std::move(frameNs));
+    state.counter("frames", frames);
+    state.counter("allocations", static_cast<double>(allocated.allocations));
+    state.counter("alloc_bytes", static_cast<double>(allocated.bytes));
+    if (alloc::enabled()) state.expect(allocated.allocations == 0, "steady-state frames allocated");
+}
+
+} // namespace
+
+BENCHMARK("history/push_full", historyPushFull);
+BENCHMARK("history/refresh_1k", [](bench::State& s) { historyRefresh(s, 1000); });
+BENCHMARK("history/refresh_10k", [](bench::State& s) { historyRefresh(s, 10000); });
+
+BENCHMARK("filter/search_1k", [](bench::State& s) { filterSearch(s, 1000, "Bit"); });
+BENCHMARK("filter/search_10k", [](bench::State& s) { filterSearch(s, 10000, "Bit"); });
+BENCHMARK("filter/search_empty_10k", [](bench::State& s) { filterSearch(s, 10000, ""); });
+BENCHMARK("filter/favorites_10k", [](bench::State& s) { filterFavorites(s, 10000); });
+
+BENCHMARK("sort/market_cap_1k", [](bench::State& s) { sortByMarketCap(s, 1000); });
+BENCHMARK("sort/market_cap_10k", [](bench::State& s) { sortByMarketCap(s, 10000); });
+BENCHMARK("sort/name_10k", [](bench::State& s) { sortByName(s, 10000); });
+
+BENCHMARK("snapshot/publish_100", [](bench::State& s) { snapshotPublish(s, 100); });
+BENCHMARK("snapshot/publish_10k", [](bench::State& s) { snapshotPublish(s, 10000); });
+
+BENCHMARK("refresh/cycle_100", [](bench::State& s) { refreshCycle(s, 100); });
+BENCHMARK("refresh/cycle_1k", [](bench::State& s) { refreshCycle(s, 1000); });
+
+BENCHMARK("favorites/write_10", [](bench::State& s) { favoritesWrite(s, 10); });
+BENCHMARK("favorites/write_1k", [](bench::State& s) { favoritesWrite(s, 1000); });
+BENCHMARK("favorites/read_1k", [](bench::State& s) { favoritesRead(s, 1000); });
+BENCHMARK("favorites/toggle_10k_burst", favoritesToggleBurst);
+
+BENCHMARK("ui/frame_100", [](bench::State& s) { tableFrame(s, 100, ""); });
+BENCHMARK("ui/frame_1k", [](bench::State& s) { tableFrame(s, 1000, ""); });
+BENCHMARK("ui/frame_10k", [](bench::State& s) { tableFrame(s, 10000, ""); });
+BENCHMARK("ui/frame_10k_search", [](bench::State& s) { tableFrame(s, 10000, "bit"); });
+BENCHMARK("ui/steady_state_10k", tableSteadyState);
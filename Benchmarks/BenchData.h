@@ -0,0 +1,98 @@
+#pragma once
+
+#include "BenchHarness.h"
+#include "CryptoData.h"
+#include "Utf16.h"
+#include "json.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Inputs shared by the benchmarks: the captured coin_data.json response and
+// synthetic universes / payloads scaled from it.
+// -------------------------------------------------------------------------
+namespace bench {
+
+// coin_data.json as the /coins/markets array it was captured from (UTF-8).
+inline const std::string& coinDataJson() {
+    static const std::string json = [] {
+        const std::string path = dataDir() + "/coin_data.json";
+        std::ifstream file(path, std::ios::binary);
+        if (!file) throw std::runtime_error("cannot open " + path + " (use --data DIR)");
+        std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        const bool utf16 = bytes.size() >= 2 && static_cast<unsigned char>(bytes[0]) == 0xFF &&
+            static_cast<unsigned char>(bytes[1]) == 0xFE;
+        std::string text;
+        if (utf16) {
+            Utf16LeTranscoder transcoder;
+            transcoder.feed(bytes.data() + 2, bytes.size() - 2, text);
+            transcoder.finish(text);
+        }
+        nlohmann::json doc = nlohmann::json::parse(utf16 ? text : bytes);
+        if (doc.is_object() && doc.contains("value")) doc = doc["value"];   // PowerShell wrapper
+        return doc.dump();
+    }();
+    return json;
+}
+
+// /coins/markets payload with `count` coins, cycling the captured objects
+// (full CoinGecko schema) with unique ids and jittered prices.
+inline std::string syntheticMarketsJson(size_t count, std::uint32_t seed = 7) {
+    const nlohmann::json templates = nlohmann::json::parse(coinDataJson());
+    std::mt19937 rng(seed);
+    std::lognormal_distribution<double> jitter(0.0, 0.3);
+
+    nlohmann::json coins = nlohmann::json::array();
+    for (size_t i = 0; i < count; ++i) {
+        nlohmann::json coin = templates[i % templates.size()];
+        const std::string n = std::to_string(i);
+        coin["id"] = coin["id"].get<std::string>() + "-" + n;
+        coin["symbol"] = coin["symbol"].get<std::string>() + n;
+        coin["name"] = coin["name"].get<std::string>() + " " + n;
+        if (coin["current_price"].is_number()) {
+            coin["current_price"] = coin["current_price"].get<double>() * jitter(rng);
+        }
+        coins.push_back(std::move(coin));
+    }
+    return coins.dump();
+}
+
+// In-memory universe: long-tail prices (sub-cent to 5 digits) and market caps.
+inline std::vector<CryptoCoin> syntheticCoins(size_t count, std::uint32_t seed = 11) {
+    static const char* const names[] = {
+        "Bitcoin", "Ethereum", "Tether", "Solana", "Cardano", "Dogecoin", "Polkadot",
+        "Chainlink", "Litecoin", "Avalanche", "Uniswap", "Stellar", "Monero", "Cosmos",
+        // long enough to defeat the small-string buffer, as many real names are
+        "Wrapped Liquid Staked Ether", "Binance Bridged USDT", "Lido Staked Ether",
+    };
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> logPrice(-6.0, 5.0);
+    std::normal_distribution<double> change(0.0, 4.0);
+
+    std::vector<CryptoCoin> coins;
+    coins.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        CryptoCoin coin;
+        const std::string n = std::to_string(i);
+        const std::string base = names[i % (sizeof(names) / sizeof(names[0]))];
+        coin.id = "coin-" + n;
+        coin.symbol = "c" + n;
+        coin.name = base + " " + n;
+        coin.current_price = std::pow(10.0, logPrice(rng));
+        coin.price_change_24h = change(rng);
+        coin.market_cap = coin.current_price * (1e6 + static_cast<double>(rng() % 1000000) * 1e3);
+        coins.push_back(std::move(coin));
+    }
+    return coins;
+}
+
+} // namespace bench
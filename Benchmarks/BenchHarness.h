@@ -0,0 +1,165 @@
+#pragma once
+
+#include "AllocTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Minimal benchmark harness: no dependencies beyond the standard library
+// and the app's allocation counters (AllocTracker.h).
+//
+// A benchmark is a function taking a State. It either times an operation
+// with State::measure() or, for simulations and load tests that produce
+// their own latency samples, hands them to State::samples(). Extra numbers
+// (bytes, hit rates, ...) go into named counters. Everything ends up in
+// one Result per benchmark, printed as a table and written as JSON.
+// -------------------------------------------------------------------------
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the compiler from discarding a value that is computed but unused.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations = 0;
+    double nsPerOp = 0.0;          // mean
+    double p50Ns = 0.0;
+    double p99Ns = 0.0;
+    double itemsPerSecond = 0.0;   // ops/s x items per op
+    std::vector<std::pair<std::string, double>> counters;
+    std::vector<std::string> failures;   // State::expect() checks that did not hold
+};
+
+inline double percentile(std::vector<double>& values, double q) {
+    if (values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(q * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+class State {
+public:
+    State(Result& result, bool quick) : result_(result), quick_(quick) {}
+
+    // Shorter runs and smaller inputs (smoke test / CI)
+    bool quick() const { return quick_; }
+
+    // Runs `op` until enough time has passed. Calls are grouped into
+    // samples of at least ~50us so the clock cost stays negligible for tiny
+    // operations; p50/p99 are taken over the per-call time of each sample.
+    // Heap allocations made by `op` on this thread are reported per call.
+    template <typename Op>
+    void measure(Op&& op, double itemsPerOp = 1.0) {
+        const auto minTotal = std::chrono::milliseconds(quick_ ? 50 : 500);
+        const auto minSample = std::chrono::microseconds(50);
+
+        op();   // warm-up
+
+        std::uint64_t batch = 1;
+        for (;;) {
+            auto started = Clock::now();
+            for (std::uint64_t i = 0; i < batch; ++i) op();
+            if (Clock::now() - started >= minSample || batch >= (1u << 30)) break;
+            batch *= 2;
+        }
+
+        std::vector<double> perCall;
+        perCall.reserve(1024);
+        std::uint64_t calls = 0;
+        Clock::duration total{};
+        alloc::Counts allocated;
+        while (total < minTotal || perCall.size() < 5) {
+            alloc::Scope allocs;
+            auto started = Clock::now();
+            for (std::uint64_t i = 0; i < batch; ++i) op();
+            auto elapsed = Clock::now() - started;
+            const alloc::Counts delta = allocs.delta();
+            allocated.allocations += delta.allocations;
+            allocated.bytes += delta.bytes;
+            total += elapsed;
+            calls += batch;
+            perCall.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / batch);
+        }
+
+        result_.iterations = calls;
+        result_.nsPerOp = std::chrono::duration<double, std::nano>(total).count() / calls;
+        result_.p50Ns = percentile(perCall, 0.50);
+        result_.p99Ns = percentile(perCall, 0.99);
+        result_.itemsPerSecond = result_.nsPerOp > 0 ? itemsPerOp * 1e9 / result_.nsPerOp : 0.0;
+        if (alloc::enabled()) {
+            counter("allocs_per_op", static_cast<double>(allocated.allocations) / calls);
+            counter("alloc_bytes_per_op", static_cast<double>(allocated.bytes) / calls);
+        }
+    }
+
+    // Latency samples (ns) gathered by the benchmark itself.
+    void samples(std::vector<double> latenciesNs, double itemsPerSecond = 0.0) {
+        result_.iterations = latenciesNs.size();
+        double sum = 0.0;
+        for (double v : latenciesNs) sum += v;
+        result_.nsPerOp = latenciesNs.empty() ? 0.0 : sum / latenciesNs.size();
+        result_.p50Ns = percentile(latenciesNs, 0.50);
+        result_.p99Ns = percentile(latenciesNs, 0.99);
+        result_.itemsPerSecond = itemsPerSecond;
+    }
+
+    void counter(const std::string& name, double value) {
+        result_.counters.emplace_back(name, value);
+    }
+
+    // A property the run must have (e.g. an allocation budget). Failures are
+    // printed with the result and make the run exit non-zero.
+    void expect(bool ok, const std::string& what) {
+        if (!ok) result_.failures.push_back(what);
+    }
+
+private:
+    Result& result_;
+    bool quick_;
+};
+
+using BenchmarkFn = void (*)(State&);
+
+struct Benchmark {
+    std::string name;
+    BenchmarkFn fn;
+};
+
+inline std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+struct Registration {
+    Registration(const char* name, BenchmarkFn fn) { registry().push_back({ name, fn }); }
+};
+
+// Directory holding coin_data.json (set by main from --data)
+inline std::string& dataDir() {
+    static std::string dir;
+    return dir;
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_INNER(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_INNER(a, b)
+
+// BENCHMARK("group/name", Function) registers Function(bench::State&).
+#define BENCHMARK(name, fn) \
+    static bench::Registration BENCH_CONCAT(benchRegistration_, __LINE__)(name, fn)
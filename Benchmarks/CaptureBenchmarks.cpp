@@ -0,0 +1,186 @@
+// Saved responses in PowerShell's UTF-16LE envelope (CaptureLoader.h):
+// transcoding with and without the ASCII fast path, transcode + decode
+// over a multi-GB capture set, and the real coin_data.json.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "CaptureLoader.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t FILE_CHUNK = 1 << 20;   // as LoadCaptureFile reads
+constexpr size_t CAPTURE_COINS = 10000;
+
+// UTF-8 to UTF-16LE with a BOM: what Out-File writes.
+std::string toUtf16le(const std::string& utf8) {
+    std::string out = "\xFF\xFE";
+    auto unit = [&out](std::uint32_t u) {
+        out += static_cast<char>(u & 0xFF);
+        out += static_cast<char>(u >> 8);
+    };
+    for (size_t i = 0; i < utf8.size();) {
+        const unsigned char c = static_cast<unsigned char>(utf8[i]);
+        std::uint32_t cp;
+        int extra;
+        if (c < 0x80) { cp = c; extra = 0; }
+        else if (c < 0xE0) { cp = c & 0x1F; extra = 1; }
+        else if (c < 0xF0) { cp = c & 0x0F; extra = 2; }
+        else { cp = c & 0x07; extra = 3; }
+        for (int k = 1; k <= extra; ++k) cp = (cp << 6) | (static_cast<unsigned char>(utf8[i + k]) & 0x3F);
+        i += 1 + extra;
+        if (cp >= 0x10000) {
+            unit(0xD800 + ((cp - 0x10000) >> 10));
+            unit(0xDC00 + ((cp - 0x10000) & 0x3FF));
+        }
+        else {
+            unit(cp);
+        }
+    }
+    return out;
+}
+
+// A ConvertTo-Json style capture: indented, wrapped in {"value": [...]},
+// with the odd non-ASCII name so the slow path is exercised too.
+std::string syntheticCaptureUtf8(size_t coins, std::uint32_t seed) {
+    nlohmann::json list = nlohmann::json::parse(bench::syntheticMarketsJson(coins, seed));
+    for (size_t i = 0; i < list.size(); i += 97) {
+        list[i]["name"] = list[i]["name"].get<std::string>() + " \xC3\x9C\x62\x65r \xE2\x82\xBF \xF0\x9F\x9A\x80";
+    }
+    nlohmann::json capture = { { "value", list }, { "Count", list.size() } };
+    return capture.dump(4);
+}
+
+const std::string& captureUtf8() {
+    static const std::string text = syntheticCaptureUtf8(CAPTURE_COINS, 7);
+    return text;
+}
+
+const std::string& captureUtf16() {
+    static const std::string bytes = toUtf16le(captureUtf8());
+    return bytes;
+}
+
+void transcode(bench::State& state, bool asciiFastPath) {
+    const std::string& bytes = captureUtf16();
+    std::string out;
+    out.reserve(bytes.size());
+    state.measure([&] {
+        Utf16LeTranscoder transcoder(asciiFastPath);
+        out.clear();
+        for (size_t at = 0; at < bytes.size(); at += FILE_CHUNK) {
+            const size_t n = bytes.size() - at < FILE_CHUNK ? bytes.size() - at : FILE_CHUNK;
+            transcoder.feed(bytes.data() + at, n, out);
+        }
+        transcoder.finish(out);
+        bench::DoNotOptimize(out.data());
+    }, static_cast<double>(bytes.size()));
+    state.counter("input_mb", static_cast<double>(bytes.size()) / 1e6);
+    state.expect(out == "\xEF\xBB\xBF" + captureUtf8(), "transcodes back to the original UTF-8");
+}
+
+void transcodeFast(bench::State& state) { transcode(state, true); }
+void transcodeScalar(bench::State& state) { transcode(state, false); }
+
+// Transcode + envelope + decode over a capture set of several GB (256 MB
+// with --quick): a few distinct captures, replayed file after file in
+// 1 MB chunks the way LoadCaptureFile reads them. Throughput is input
+// bytes per second; latencies are per capture file.
+void loadCaptureSet(bench::State& state) {
+    std::vector<std::string> files;
+    for (std::uint32_t seed = 1; seed <= 4; ++seed) files.push_back(toUtf16le(syntheticCaptureUtf8(CAPTURE_COINS, seed)));
+    const double targetBytes = state.quick() ? 256e6 : 2.5e9;
+
+    std::vector<double> latencies;
+    double bytes = 0, coins = 0, priceSum = 0;
+    bool allDecoded = true;
+    const auto started = bench::Clock::now();
+    for (size_t f = 0; bytes < targetBytes; ++f) {
+        const std::string& file = files[f % files.size()];
+        const auto fileStarted = bench::Clock::now();
+        CaptureLoader loader([&](CryptoCoin&& coin) { priceSum += coin.current_price; });
+        for (size_t at = 0; at < file.size(); at += FILE_CHUNK) {
+            const size_t n = file.size() - at < FILE_CHUNK ? file.size() - at : FILE_CHUNK;
+            if (!loader.feed(file.data() + at, n)) break;
+        }
+        allDecoded = allDecoded && loader.finish() && loader.coinCount() == CAPTURE_COINS;
+        latencies.push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - fileStarted).count());
+        bytes += static_cast<double>(file.size());
+        coins += static_cast<double>(loader.coinCount());
+    }
+    const double seconds = std::chrono::duration<double>(bench::Clock::now() - started).count();
+    bench::DoNotOptimize(priceSum);
+
+    state.samples(std::move(latencies), bytes / seconds);
+    state.counter("capture_set_gb", bytes / 1e9);
+    state.counter("mb_per_s", bytes / 1e6 / seconds);
+    state.counter("coins_per_s", coins / seconds);
+    state.expect(allDecoded, "every capture decodes all of its coins");
+}
+
+// The checked-in capture, through the same loader, against the decoder on
+// its UTF-8 body.
+void coinDataFile(bench::State& state) {
+    const std::string path = bench::dataDir() + "/coin_data.json";
+    std::vector<CryptoCoin> loaded;
+    std::string error;
+    bool ok = false;
+    state.measure([&] {
+        loaded.clear();
+        ok = LoadCaptureFile(path, [&](CryptoCoin&& coin) { loaded.push_back(std::move(coin)); }, error);
+    });
+
+    std::vector<CryptoCoin> reference;
+    CoinStreamDecoder decoder([&](CryptoCoin&& coin) { reference.push_back(std::move(coin)); });
+    const std::string& body = bench::coinDataJson();
+    const bool decoded = decoder.feed(body.data(), body.size()) && decoder.finish();
+    bool same = ok && decoded && !loaded.empty() && loaded.size() == reference.size();
+    for (size_t i = 0; same && i < loaded.size(); ++i) {
+        same = loaded[i].id == reference[i].id && loaded[i].name == reference[i].name &&
+            loaded[i].current_price == reference[i].current_price &&
+            loaded[i].extras.last_updated == reference[i].extras.last_updated;
+    }
+    state.counter("coins", static_cast<double>(loaded.size()));
+    state.expect(same, "coin_data.json loads the same coins as its UTF-8 body (" + error + ")");
+
+    // Any chunking: one byte at a time splits every unit and surrogate pair.
+    auto loadBytewise = [](const std::string& bytes, size_t& count, std::string& why) {
+        CaptureLoader loader([](CryptoCoin&&) {});
+        for (char c : bytes) {
+            if (!loader.feed(&c, 1)) break;
+        }
+        const bool done = loader.finish();
+        count = loader.coinCount();
+        why = loader.error();
+        return done;
+    };
+    const std::string small = syntheticCaptureUtf8(200, 3);
+    size_t count = 0;
+    std::string why;
+    state.expect(loadBytewise(toUtf16le(small), count, why) && count == 200, "UTF-16 fed byte by byte: " + why);
+    state.expect(loadBytewise(small, count, why) && count == 200, "UTF-8 envelope: " + why);
+    state.expect(loadBytewise("\xEF\xBB\xBF" + bench::syntheticMarketsJson(50), count, why) && count == 50,
+        "bare UTF-8 list with a BOM: " + why);
+    state.expect(!loadBytewise(toUtf16le("{\"Count\": 0, \"other\": [1]}"), count, why) &&
+        !loadBytewise("{\"value\": 3}", count, why) && !loadBytewise("", count, why),
+        "envelopes without a \"value\" list are rejected");
+
+    std::string text;
+    Utf16LeTranscoder transcoder;
+    const std::string units("A\x00\x3D\xD8\x80\xDE\x00\xDC" "B\x00\x00\xD8", 12);   // A, U+1F680, lone low, B, lone high
+    for (char c : units) transcoder.feed(&c, 1, text);
+    transcoder.finish(text);
+    state.expect(text == "A\xF0\x9F\x9A\x80\xEF\xBF\xBD" "B\xEF\xBF\xBD", "surrogate pairs and unpaired surrogates");
+}
+
+} // namespace
+
+// Throughput (items/s) is UTF-16 input bytes per second.
+BENCHMARK("capture/transcode_ascii_fast_path", transcodeFast);
+BENCHMARK("capture/transcode_scalar", transcodeScalar);
+BENCHMARK("capture/load_set_multi_gb", loadCaptureSet);
+BENCHMARK("capture/coin_data_file", coinDataFile);
@@ -0,0 +1,101 @@
+// Display-currency conversion at capture time: scaling the price and market
+// cap columns (Currency.h) against copying the coin list per currency, and
+// parsing CoinGecko's exchange rate table.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "Currency.h"
+
+#include <cmath>
+#include <string>
+
+namespace {
+
+constexpr size_t COINS = 10000;
+constexpr size_t CURRENCIES = 10;
+
+const char* const CODES[CURRENCIES] = { "usd", "eur", "btc", "jpy", "gbp", "chf", "cad", "aud", "krw", "eth" };
+
+ExchangeRates syntheticRates() {
+    ExchangeRates rates;
+    const double perBtc[CURRENCIES] = { 64000.0, 59000.0, 1.0, 9.6e6, 50500.0, 56000.0, 87000.0, 96000.0, 8.7e7, 19.5 };
+    for (size_t c = 0; c < CURRENCIES; ++c) rates.set(CODES[c], perBtc[c]);
+    return rates;
+}
+
+std::vector<double> syntheticFactors() {
+    const ExchangeRates rates = syntheticRates();
+    std::vector<double> factors;
+    for (const char* code : CODES) factors.push_back(rates.factor(code));
+    return factors;
+}
+
+// The conversion CaptureSnapshot does: gather once, scale per currency.
+void convertColumns(bench::State& state) {
+    const auto coins = bench::syntheticCoins(COINS);
+    const auto factors = syntheticFactors();
+    CurrencyColumns columns;
+    state.measure([&] {
+        ConvertColumns(coins, factors, columns);
+        bench::DoNotOptimize(columns.prices.data());
+    }, static_cast<double>(COINS * CURRENCIES));
+
+    bool exact = true;
+    for (size_t c = 0; c < CURRENCIES && exact; ++c) {
+        for (size_t i = 0; i < COINS; ++i) {
+            if (columns.price(c)[i] != coins[i].current_price * factors[c] ||
+                columns.marketCap(c)[i] != coins[i].market_cap * factors[c]) {
+                exact = false;
+                break;
+            }
+        }
+    }
+    state.expect(exact, "every column equals base x factor");
+}
+
+// Baseline: one converted copy of the coin list per currency, looking the
+// rate up per coin.
+void copyPerCurrency(bench::State& state) {
+    const auto coins = bench::syntheticCoins(COINS);
+    const ExchangeRates rates = syntheticRates();
+    std::vector<std::vector<CryptoCoin>> converted(CURRENCIES);
+    state.measure([&] {
+        for (size_t c = 0; c < CURRENCIES; ++c) {
+            converted[c] = coins;
+            for (auto& coin : converted[c]) {
+                const double factor = rates.factor(CODES[c]);
+                coin.current_price *= factor;
+                coin.market_cap *= factor;
+            }
+        }
+        bench::DoNotOptimize(converted);
+    }, static_cast<double>(COINS * CURRENCIES));
+}
+
+// /api/v3/exchange_rates is ~60 currencies; the body is built to match.
+void parseRates(bench::State& state) {
+    std::string body = "{\"rates\":{";
+    for (int i = 0; i < 60; ++i) {
+        const std::string code = i < static_cast<int>(CURRENCIES) ? CODES[i] : "c" + std::to_string(i);
+        if (i > 0) body += ",";
+        body += "\"" + code + "\":{\"name\":\"Currency " + std::to_string(i) + "\",\"unit\":\"" + code +
+            "\",\"value\":" + std::to_string(1000.0 + i * 37.5) + ",\"type\":\"fiat\"}";
+    }
+    body += "}}";
+
+    ExchangeRates rates;
+    std::string error;
+    bool ok = false;
+    state.measure([&] { ok = rates.parse(body, error); });
+    state.counter("body_bytes", static_cast<double>(body.size()));
+    state.expect(ok && std::isfinite(rates.factor("eur")), "the synthetic table parses");
+    state.expect(!rates.parse("{\"rates\":{\"eur\":{\"value\":1}}}", error) && std::isfinite(rates.factor("eur")),
+        "a table without the base currency is rejected and keeps the old rates");
+}
+
+} // namespace
+
+// Throughput (items/s) is coin x currency conversions per second.
+BENCHMARK("fx/convert_columns_10k_x10", convertColumns);
+BENCHMARK("fx/copy_per_currency_10k_x10", copyPerCurrency);
+BENCHMARK("fx/parse_exchange_rates", parseRates);
@@ -0,0 +1,221 @@
+// JSON decode of /coins/markets bodies: the captured coin_data.json and
+// synthetic payloads with the same schema, scaled up.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "CoinStreamDecoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// Streaming decoder as APIClient drives it: the body arrives in chunks.
+void decodeStream(bench::State& state, const std::string& body, size_t chunkSize,
+    CoinFieldSet fields = CoinFieldSet::defaults()) {
+    size_t decoded = 0;
+    state.measure([&] {
+        size_t coins = 0;
+        CoinStreamDecoder decoder([&coins](CryptoCoin&& coin) {
+            bench::DoNotOptimize(coin);
+            ++coins;
+        }, fields);
+        for (size_t at = 0; at < body.size(); at += chunkSize) {
+            decoder.feed(body.data() + at, std::min(chunkSize, body.size() - at));
+        }
+        decoder.finish();
+        decoded = coins;
+    }, static_cast<double>(body.size()));
+    state.counter("coins", static_cast<double>(decoded));
+    state.counter("body_bytes", static_cast<double>(body.size()));
+}
+
+// Whole-body DOM parse, then one parseCoin per element (the pre-streaming path).
+void decodeDom(bench::State& state, const std::string& body) {
+    size_t decoded = 0;
+    state.measure([&] {
+        nlohmann::json doc = nlohmann::json::parse(body);
+        std::vector<CryptoCoin> coins;
+        coins.reserve(doc.size());
+        for (const auto& item : doc) coins.push_back(parseCoin(item));
+        bench::DoNotOptimize(coins);
+        decoded = coins.size();
+    }, static_cast<double>(body.size()));
+    state.counter("coins", static_cast<double>(decoded));
+    state.counter("body_bytes", static_cast<double>(body.size()));
+}
+
+const std::string& synthetic(size_t count) {
+    static std::string bodies[3];
+    size_t slot = count <= 100 ? 0 : count <= 1000 ? 1 : 2;
+    if (bodies[slot].empty()) bodies[slot] = bench::syntheticMarketsJson(count);
+    return bodies[slot];
+}
+
+constexpr size_t HTTP_CHUNK = 16 * 1024;   // httplib's read buffer
+
+// Decodes `body` once with `fields`; returns the coins.
+std::vector<CryptoCoin> decodeAll(const std::string& body, CoinFieldSet fields, unsigned long long* keyLookups = nullptr) {
+    std::vector<CryptoCoin> coins;
+    CoinStreamDecoder decoder([&coins](CryptoCoin&& coin) { coins.push_back(std::move(coin)); }, fields);
+    decoder.feed(body.data(), body.size());
+    if (!decoder.finish()) coins.clear();
+    if (keyLookups) *keyLookups = decoder.parser().keyLookups();
+    return coins;
+}
+
+// The objects of `body`, one string each (what the stream decoder buffers).
+std::vector<std::string> splitObjects(const std::string& body) {
+    std::vector<std::string> objects;
+    for (const auto& item : nlohmann::json::parse(body)) objects.push_back(item.dump());
+    return objects;
+}
+
+// Mean ns per object for CoinObjectParser with `fields` (best of `rounds`).
+double nsPerCoin(const std::vector<std::string>& objects, CoinFieldSet fields, int rounds) {
+    CoinObjectParser parser(fields);
+    std::string error;
+    double best = 0.0;
+    for (int r = 0; r < rounds; ++r) {
+        const auto started = bench::Clock::now();
+        for (const auto& object : objects) {
+            CryptoCoin coin;
+            parser.parse(object.data(), object.data() + object.size(), coin, error);
+            bench::DoNotOptimize(coin);
+        }
+        const double ns = std::chrono::duration<double, std::nano>(bench::Clock::now() - started).count() / objects.size();
+        if (r == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+// Extra parse cost of each optional field on top of the core row: one
+// counter per field, in ns per coin. Objects are pre-split so only the
+// field decoding is timed, not the element scan.
+void perFieldCost(bench::State& state) {
+    const auto objects = splitObjects(synthetic(1000));
+    const int rounds = state.quick() ? 15 : 50;
+    CoinObjectParser parser(CoinFieldSet::core());
+    std::string error;
+    state.measure([&] {
+        for (const auto& object : objects) {
+            CryptoCoin coin;
+            parser.parse(object.data(), object.data() + object.size(), coin, error);
+            bench::DoNotOptimize(coin);
+        }
+    }, static_cast<double>(objects.size()));   // also warms up
+
+    // Core and core + field alternate so drift hits both alike
+    double core = 0.0;
+    for (size_t i = 0; i < COIN_FIELD_COUNT; ++i) {
+        const CoinField field = static_cast<CoinField>(i);
+        if (CoinFieldSet::core().has(field)) continue;
+        double base = 0.0, with = 0.0;
+        for (int r = 0; r < rounds; ++r) {
+            const double b = nsPerCoin(objects, CoinFieldSet::core(), 1);
+            const double w = nsPerCoin(objects, CoinFieldSet::core().with(field), 1);
+            if (r == 0 || b < base) base = b;
+            if (r == 0 || w < with) with = w;
+        }
+        if (core == 0.0 || base < core) core = base;
+        state.counter(std::string(CoinFieldKey(field)) + "_ns", with - base);
+    }
+    state.counter("core_ns_per_coin", core);
+    const double all = nsPerCoin(objects, CoinFieldSet::all(), rounds);
+    state.counter("all_ns_per_coin", all);
+    state.counter("mean_optional_field_ns", (all - core) / (COIN_FIELD_COUNT - 6));   // 6 core fields
+}
+
+// Schema decode against the DOM for every field of the captured response,
+// and the key-order cache: only the first object's keys are looked up by name.
+void schemaMatchesDom(bench::State& state) {
+    const std::string& body = bench::coinDataJson();
+    unsigned long long lookups = 0;
+    std::vector<CryptoCoin> coins;
+    state.measure([&] { coins = decodeAll(body, CoinFieldSet::all(), &lookups); },
+        static_cast<double>(body.size()));
+
+    const nlohmann::json doc = nlohmann::json::parse(body);
+    bool same = coins.size() == doc.size() && !coins.empty();
+    for (size_t i = 0; same && i < coins.size(); ++i) {
+        const auto& item = doc[i];
+        const CryptoCoin& c = coins[i];
+        auto number = [&](const char* key, double got) {
+            const auto& v = item[key];
+            return v.is_null() ? std::isnan(got) : v.get<double>() == got;
+        };
+        auto text = [&](const char* key, const std::string& got) {
+            const auto& v = item[key];
+            return v.is_null() ? got.empty() : v.get<std::string>() == got;
+        };
+        auto date = [&](const char* key, std::int64_t got) {
+            const auto& v = item[key];
+            if (v.is_null()) return got == 0;
+            const std::string iso = v.get<std::string>();
+            std::int64_t expected = 0;
+            return ParseIso8601(iso.data(), iso.size(), expected) && expected == got;
+        };
+        same = c.id == item["id"] && c.symbol == item["symbol"] && c.name == item["name"]
+            && number("current_price", c.current_price) && number("market_cap", c.market_cap)
+            && number("price_change_percentage_24h", c.price_change_24h)
+            && text("image", c.extras.image) && number("market_cap_rank", c.extras.market_cap_rank)
+            && number("fully_diluted_valuation", c.extras.fully_diluted_valuation)
+            && number("total_volume", c.extras.total_volume) && number("high_24h", c.extras.high_24h)
+            && number("low_24h", c.extras.low_24h) && number("price_change_24h", c.extras.price_change_abs_24h)
+            && number("market_cap_change_24h", c.extras.market_cap_change_24h)
+            && number("market_cap_change_percentage_24h", c.extras.market_cap_change_percentage_24h)
+            && number("circulating_supply", c.extras.circulating_supply)
+            && number("total_supply", c.extras.total_supply) && number("max_supply", c.extras.max_supply)
+            && number("ath", c.extras.ath) && number("ath_change_percentage", c.extras.ath_change_percentage)
+            && date("ath_date", c.extras.ath_date) && number("atl", c.extras.atl)
+            && number("atl_change_percentage", c.extras.atl_change_percentage)
+            && date("atl_date", c.extras.atl_date) && date("last_updated", c.extras.last_updated);
+    }
+    state.counter("key_lookups", static_cast<double>(lookups));
+    state.counter("keys_per_coin", static_cast<double>(doc.empty() ? 0 : doc[0].size()));
+    state.expect(same, "every field matches the DOM parse");
+    state.expect(!doc.empty() && lookups == doc[0].size(), "keys are compared by name for the first object only");
+
+    const CryptoCoin escaped = [] {
+        std::vector<CryptoCoin> one = decodeAll(
+            "[{\"id\":\"a\",\"symbol\":\"a\",\"name\":\"Caf\\u00e9 \\ud83d\\ude80 \\\"Q\\\"\",\"current_price\":1.5}]",
+            CoinFieldSet::core());
+        return one.empty() ? CryptoCoin() : one[0];
+    }();
+    state.expect(escaped.name == "Caf\xc3\xa9 \xf0\x9f\x9a\x80 \"Q\"", "escapes decode to UTF-8");
+    state.expect(decodeAll("[{\"id\":\"a\",\"symbol\":\"a\",\"name\":\"A\",\"current_price\":null}]",
+        CoinFieldSet::core()).empty(), "a null required field fails the list");
+
+    // List punctuation is checked as strictly as the DOM parser does
+    auto parses = [](const std::string& body) {
+        CoinStreamDecoder decoder([](CryptoCoin&&) {}, CoinFieldSet::core());
+        decoder.feed(body.data(), body.size());
+        return decoder.finish();
+    };
+    const std::string coin = "{\"id\":\"a\",\"symbol\":\"a\",\"name\":\"A\",\"current_price\":1}";
+    state.expect(parses("[" + coin + " , " + coin + "]") && parses(" [ ] ") && parses("[" + coin + "]"),
+        "well-formed lists decode");
+    state.expect(!parses("[" + coin + coin + "]"), "a missing comma fails the list");
+    state.expect(!parses("[" + coin + ",," + coin + "]"), "a repeated comma fails the list");
+    state.expect(!parses("[" + coin + ",]") && !parses("[," + coin + "]") && !parses("[,]"),
+        "leading and trailing commas fail the list");
+}
+
+} // namespace
+
+// Throughput (items/s) is bytes/s of JSON body.
+BENCHMARK("decode/coin_data/stream", [](bench::State& s) { decodeStream(s, bench::coinDataJson(), HTTP_CHUNK); });
+BENCHMARK("decode/coin_data/stream_1k_chunks", [](bench::State& s) { decodeStream(s, bench::coinDataJson(), 1024); });
+BENCHMARK("decode/coin_data/dom", [](bench::State& s) { decodeDom(s, bench::coinDataJson()); });
+BENCHMARK("decode/synthetic_100/stream", [](bench::State& s) { decodeStream(s, synthetic(100), HTTP_CHUNK); });
+BENCHMARK("decode/synthetic_100/dom", [](bench::State& s) { decodeDom(s, synthetic(100)); });
+BENCHMARK("decode/synthetic_1k/stream", [](bench::State& s) { decodeStream(s, synthetic(1000), HTTP_CHUNK); });
+BENCHMARK("decode/synthetic_1k/dom", [](bench::State& s) { decodeDom(s, synthetic(1000)); });
+BENCHMARK("decode/synthetic_10k/stream", [](bench::State& s) { decodeStream(s, synthetic(10000), HTTP_CHUNK); });
+BENCHMARK("decode/synthetic_10k/dom", [](bench::State& s) { decodeDom(s, synthetic(10000)); });
+BENCHMARK("decode/fields/core_1k", [](bench::State& s) { decodeStream(s, synthetic(1000), HTTP_CHUNK, CoinFieldSet::core()); });
+BENCHMARK("decode/fields/defaults_1k", [](bench::State& s) { decodeStream(s, synthetic(1000), HTTP_CHUNK, CoinFieldSet::defaults()); });
+BENCHMARK("decode/fields/all_1k", [](bench::State& s) { decodeStream(s, synthetic(1000), HTTP_CHUNK, CoinFieldSet::all()); });
+BENCHMARK("decode/fields/per_field_1k", perFieldCost);
+BENCHMARK("decode/fields/schema_vs_dom", schemaMatchesDom);
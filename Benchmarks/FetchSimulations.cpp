@@ -0,0 +1,1152 @@
+// Fetch path against a local mock upstream, and virtual-time simulations of
+// the refresh policies.
+//
+//   fetch/slow_drip_*        first-coin latency and decoder memory while the
+//                            body trickles in (streaming vs whole-body parse)
+//   fetch/encoding_*         bytes on the wire and fetch CPU per encoding
+//   fetch/conditional_304    validator hit rate when upstream changes every
+//                            4th poll
+//   replay/record_*          recording overhead and capture round trip
+//   replay/pipeline_max      a recorded session replayed as fast as the
+//                            fetch/decode/apply/publish pipeline goes
+//   replay/pacing_20x        ReplayClock keeps recorded spacing at 20x
+//   history/backfill_*       selection to full graph via market_chart, and
+//                            the memory bound of the backfill LRU
+//   broker/*                 upstream hits when many callers ask at once
+//                            (RequestBroker: single-flight, ids= merging,
+//                            short-TTL cache)
+//   providers/*              tail latency of one provider vs hedged
+//                            requests over two, with injected slowness,
+//                            and failover by provider health
+//   sim/refresh_*            price error and staleness of the displayed
+//                            prices under the shared request quota
+
+#include "APIClient.h"
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "FeedCapture.h"
+#include "MarketChart.h"
+#include "MarketProviders.h"
+#include "MarketSnapshot.h"
+#include "PriceHistory.h"
+#include "RefreshScheduler.h"
+#include "RequestBroker.h"
+#include "RequestBudget.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+// httplib server on a free loopback port, stopped on destruction.
+class MockUpstream {
+public:
+    httplib::Server server;
+
+    bool start() {
+        port_ = server.bind_to_any_port("127.0.0.1");
+        if (port_ <= 0) return false;
+        thread_ = std::thread([this] { server.listen_after_bind(); });
+        server.wait_until_ready();
+        return true;
+    }
+
+    int port() const { return port_; }
+
+    ~MockUpstream() {
+        server.stop();
+        if (thread_.joinable()) thread_.join();
+    }
+
+private:
+    int port_ = 0;
+    std::thread thread_;
+};
+
+double msSince(bench::Clock::time_point started) {
+    return std::chrono::duration<double, std::milli>(bench::Clock::now() - started).count();
+}
+
+// ---------------------------------------------------------------------
+// Slow-drip upstream: the body arrives in 8 KB pieces, 2 ms apart
+// ---------------------------------------------------------------------
+constexpr size_t DRIP_PIECE = 8 * 1024;
+
+void slowDrip(bench::State& state, size_t coins) {
+    const std::string body = bench::syntheticMarketsJson(coins);
+
+    MockUpstream upstream;
+    upstream.server.Get("/api/v3/coins/markets", [&body](const httplib::Request&, httplib::Response& res) {
+        res.set_chunked_content_provider("application/octet-stream",   // no compression: keep the drip
+            [&body](size_t offset, httplib::DataSink& sink) {
+                if (offset >= body.size()) {
+                    sink.done();
+                    return true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                size_t len = std::min(DRIP_PIECE, body.size() - offset);
+                return sink.write(body.data() + offset, len);
+            });
+    });
+    if (!upstream.start()) return;
+
+    const int runs = state.quick() ? 2 : 5;
+    std::vector<double> totalNs;
+    double firstCoinMs = 0.0, totalMs = 0.0, domFirstCoinMs = 0.0;
+    size_t peakBuffer = 0;
+
+    for (int i = 0; i < runs; ++i) {
+        std::string status;
+        FetchStats stats;
+        APIClient::fetchFromHost("127.0.0.1", upstream.port(), APIClient::MARKETS_PATH, status, &stats);
+        firstCoinMs += stats.firstCoinMs / runs;
+        totalMs += stats.totalMs / runs;
+        peakBuffer = std::max(peakBuffer, stats.peakBufferBytes);
+        totalNs.push_back(stats.totalMs * 1e6);
+
+        // Whole-body path for comparison: nothing is usable before the last byte + parse
+        auto started = bench::Clock::now();
+        httplib::Client cli("127.0.0.1", upstream.port());
+        auto res = cli.Get(APIClient::MARKETS_PATH);
+        if (res) {
+            nlohmann::json doc = nlohmann::json::parse(res->body);
+            CryptoCoin first = parseCoin(doc.at(0));
+            bench::DoNotOptimize(first);
+        }
+        domFirstCoinMs += msSince(started) / runs;
+    }
+
+    state.samples(std::move(totalNs));
+    state.counter("stream_first_coin_ms", firstCoinMs);
+    state.counter("stream_total_ms", totalMs);
+    state.counter("stream_peak_buffer_bytes", static_cast<double>(peakBuffer));
+    state.counter("whole_body_first_coin_ms", domFirstCoinMs);
+    state.counter("whole_body_buffer_bytes", static_cast<double>(body.size()));
+}
+
+// ---------------------------------------------------------------------
+// Content-Encoding: identity vs what APIClient negotiates
+// ---------------------------------------------------------------------
+void encoding(bench::State& state, bool compressed) {
+    const std::string body = bench::syntheticMarketsJson(state.quick() ? 500 : 2000);
+
+    MockUpstream upstream;
+    // httplib compresses compressible types (application/json) when the
+    // client accepts it; octet-stream is always sent as is.
+    const char* type = compressed ? "application/json" : "application/octet-stream";
+    upstream.server.Get("/api/v3/coins/markets", [&body, type](const httplib::Request&, httplib::Response& res) {
+        res.set_content(body, type);
+    });
+    if (!upstream.start()) return;
+
+    FetchStats stats;
+    double cpuMs = 0.0;
+    size_t fetches = 0;
+    state.measure([&] {
+        std::string status;
+        APIClient::fetchFromHost("127.0.0.1", upstream.port(), APIClient::MARKETS_PATH, status, &stats);
+        cpuMs += stats.cpuMs;
+        ++fetches;
+    });
+
+    state.counter("bytes_on_wire", static_cast<double>(stats.bytesOnWire));
+    state.counter("bytes_decoded", static_cast<double>(stats.bytesReceived));
+    state.counter("compression_ratio", stats.bytesOnWire ? static_cast<double>(stats.bytesReceived) / stats.bytesOnWire : 0.0);
+    state.counter("cpu_ms_per_fetch", fetches ? cpuMs / fetches : 0.0);
+}
+
+// ---------------------------------------------------------------------
+// Conditional requests: upstream data changes every 4th poll
+// ---------------------------------------------------------------------
+void conditional304(bench::State& state) {
+    const std::string body = bench::syntheticMarketsJson(1000);
+    constexpr int POLLS_PER_CHANGE = 4;
+
+    MockUpstream upstream;
+    std::atomic<int> requests{ 0 };
+    std::atomic<bool> asked{ false };   // the last request sent If-None-Match
+    upstream.server.Get("/api/v3/coins/markets", [&](const httplib::Request& req, httplib::Response& res) {
+        int n = requests++;
+        asked = req.has_header("If-None-Match");
+        const std::string etag = "\"v" + std::to_string(n / POLLS_PER_CHANGE) + "\"";
+        res.set_header("ETag", etag);
+        if (req.get_header_value("If-None-Match") == etag) {
+            res.status = 304;
+            return;
+        }
+        res.set_content(body, "application/json");
+    });
+    if (!upstream.start()) return;
+
+    APIClient::clearValidators();
+    const ConditionalStats before = APIClient::conditionalStats();
+
+    const int polls = state.quick() ? 40 : 200;
+    std::vector<double> latencyNs;
+    double bytes = 0.0;
+    for (int i = 0; i < polls; ++i) {
+        std::string status;
+        FetchStats stats;
+        APIClient::fetchFromHost("127.0.0.1", upstream.port(), APIClient::MARKETS_PATH, status, &stats);
+        latencyNs.push_back(stats.totalMs * 1e6);
+        bytes += static_cast<double>(stats.bytesOnWire);
+    }
+
+    const ConditionalStats after = APIClient::conditionalStats();
+    double responses = static_cast<double>(after.responses - before.responses);
+    double notModified = static_cast<double>(after.notModified - before.notModified);
+
+    state.samples(std::move(latencyNs));
+    state.counter("hit_rate", responses > 0 ? notModified / responses : 0.0);
+    state.counter("cpu_saved_ms", after.cpuSavedMs - before.cpuSavedMs);
+    state.counter("bytes_on_wire_per_poll", bytes / polls);
+
+    // Rows decoded with another field set must not be kept by a 304
+    auto poll = [&] {
+        std::string status;
+        APIClient::fetchFromHost("127.0.0.1", upstream.port(), APIClient::MARKETS_PATH, status);
+        return asked.load();
+    };
+    const CoinFieldSet fields = APIClient::decodedFields();
+    const bool revalidated = poll();
+    APIClient::setDecodedFields(fields);
+    const bool sameSet = poll();
+    APIClient::setDecodedFields(CoinFieldSet::compact());
+    const bool changed = poll();
+    APIClient::setDecodedFields(fields);
+    state.expect(revalidated && sameSet && !changed, "changing the decoded fields drops the validators");
+}
+
+// ---------------------------------------------------------------------
+// Refresh policies in virtual time.
+//
+// Prices follow per-coin random walks with heterogeneous volatility and
+// occasional bursts (a stand-in for a recorded market trace). Every policy
+// runs on the same RequestBudget as the app (10 requests/min, a full
+// refresh every 60 s); they differ in how the remaining requests are spent:
+//   full_only    nothing but the full refresh
+//   round_robin  ids= batches of 50 on a fixed 5 s cadence, in turn
+//   scheduler    ids= batches chosen by RefreshScheduler (the app's lane)
+// Error is |log(shown / true)| in basis points, sampled every second.
+// ---------------------------------------------------------------------
+enum class Policy { FullOnly, RoundRobin, Scheduler };
+
+void refreshPolicy(bench::State& state, Policy policy) {
+    const size_t coins = state.quick() ? 100 : 250;
+    const size_t favorites = 10, visibleRows = 20;
+    const int seconds = state.quick() ? 1800 : 7200;
+    constexpr int FULL_REFRESH_SECONDS = 60, TICK_SECONDS = 5;
+    constexpr size_t BATCH = 50;
+
+    std::mt19937 rng(42);
+    std::lognormal_distribution<double> sigmaDist(std::log(1.8e-4), 0.8);
+    std::normal_distribution<double> shock(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    std::vector<std::string> ids(coins);
+    std::vector<double> sigma(coins), burst(coins, 1.0), truePrice(coins), shown(coins);
+    std::vector<int> lastRefresh(coins, 0);
+    for (size_t i = 0; i < coins; ++i) {
+        ids[i] = "coin-" + std::to_string(i);
+        sigma[i] = sigmaDist(rng);
+        truePrice[i] = shown[i] = 100.0;
+    }
+
+    const auto t0 = RefreshScheduler::Clock::now();
+    auto at = [t0](int second) { return t0 + std::chrono::seconds(second); };
+
+    RequestBudget budget(10, std::chrono::seconds(60), t0);
+    RefreshScheduler scheduler;
+    auto refresh = [&](size_t i, int t) {
+        shown[i] = truePrice[i];
+        lastRefresh[i] = t;
+        scheduler.observe(ids[i], shown[i], at(t));
+    };
+    for (size_t i = 0; i < coins; ++i) {
+        refresh(i, 0);
+        scheduler.setFavorite(ids[i], i < favorites);
+    }
+
+    std::unordered_map<std::string, size_t> indexOf;
+    for (size_t i = 0; i < coins; ++i) indexOf[ids[i]] = i;
+
+    int nextFull = FULL_REFRESH_SECONDS;
+    size_t roundRobin = 0;
+    double errorAll = 0.0, errorFav = 0.0, stalenessAll = 0.0;
+    std::vector<double> favStalenessNs;
+    unsigned long long requests = 0;
+
+    for (int t = 1; t <= seconds; ++t) {
+        // market moves; ~1 in 20 coins is in a 5x volatility burst at any time
+        for (size_t i = 0; i < coins; ++i) {
+            if (uniform(rng) < 1.0 / 600.0) burst[i] = burst[i] > 1.0 ? 1.0 : 5.0;
+            truePrice[i] *= std::exp(sigma[i] * burst[i] * shock(rng));
+        }
+
+        if (t >= nextFull && budget.tryAcquire(0, at(t))) {
+            ++requests;
+            for (size_t i = 0; i < coins; ++i) refresh(i, t);
+            nextFull = t + FULL_REFRESH_SECONDS;
+        }
+
+        if (policy != Policy::FullOnly && t % TICK_SECONDS == 0) {
+            for (size_t i = 0; i < visibleRows; ++i) scheduler.markVisible(ids[i], at(t));
+
+            std::vector<size_t> batch;
+            if (policy == Policy::RoundRobin) {
+                for (size_t k = 0; k < BATCH; ++k) batch.push_back(roundRobin++ % coins);
+            }
+            else {
+                for (const auto& id : scheduler.dueBatch(at(t), BATCH)) batch.push_back(indexOf[id]);
+            }
+            if (!batch.empty() && budget.tryAcquire(1, at(t))) {   // leave the full refresh its token
+                ++requests;
+                for (size_t i : batch) refresh(i, t);
+            }
+        }
+
+        for (size_t i = 0; i < coins; ++i) {
+            double err = std::fabs(std::log(shown[i] / truePrice[i])) * 1e4;
+            errorAll += err;
+            stalenessAll += t - lastRefresh[i];
+            if (i < favorites) {
+                errorFav += err;
+                favStalenessNs.push_back((t - lastRefresh[i]) * 1e9);
+            }
+        }
+    }
+
+    const double samples = static_cast<double>(seconds);
+    state.samples(std::move(favStalenessNs));
+    state.counter("error_bps_all", errorAll / (samples * coins));
+    state.counter("error_bps_favorites", errorFav / (samples * favorites));
+    state.counter("staleness_s_all", stalenessAll / (samples * coins));
+    state.counter("requests_per_min", requests * 60.0 / seconds);
+
+    if (policy == Policy::Scheduler) {
+        // A 304 for a due batch resets its age like a fresh price does
+        RefreshScheduler check;
+        check.observe("btc", 100.0, t0);
+        const auto stale = t0 + check.settings().maxAge;
+        const bool due = check.dueBatch(stale, BATCH).size() == 1;
+        check.touched("btc", stale);
+        state.expect(due && check.dueBatch(stale + std::chrono::seconds(TICK_SECONDS), BATCH).empty(),
+            "an unchanged (304) batch is not picked again on the next tick");
+    }
+}
+
+// ---------------------------------------------------------------------
+// Record / replay (FeedCapture.h)
+// ---------------------------------------------------------------------
+constexpr size_t MAX_HISTORY_POINTS = 120;   // as in CryptoTracker.cpp
+
+// A synthetic list whose quotes CoinGecko dated `seconds` into the session.
+std::string datedMarketsJson(size_t count, std::uint32_t seed, int seconds) {
+    nlohmann::json list = nlohmann::json::parse(bench::syntheticMarketsJson(count, seed));
+    char stamp[32];
+    std::snprintf(stamp, sizeof stamp, "2026-03-01T%02d:%02d:%02d.000Z", seconds / 3600, seconds / 60 % 60, seconds % 60);
+    for (auto& coin : list) coin["last_updated"] = stamp;
+    return list.dump();
+}
+std::string scratchCapture(const char* name) {
+    const auto dir = std::filesystem::temp_directory_path() / "cryptotracker_bench";
+    std::filesystem::create_directories(dir);
+    const auto path = dir / name;
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+// Live fetches against the mock upstream with recording on, then the
+// capture read back. Time per op is one recorded fetch.
+void recordRoundTrip(bench::State& state) {
+    const std::string body = bench::syntheticMarketsJson(1000);
+    MockUpstream upstream;
+    upstream.server.Get("/api/v3/coins/markets", [&body](const httplib::Request&, httplib::Response& res) {
+        res.set_header("ETag", "\"v1\"");
+        res.set_content(body, "application/octet-stream");
+    });
+    if (!upstream.start()) return;
+
+    const std::string path = scratchCapture("record.ctfeed");
+    auto recorder = std::make_shared<CaptureWriter>();
+    std::string error;
+    state.expect(recorder->open(path, error), "capture opens: " + error);
+    APIClient::clearValidators();   // every fetch a full 200
+    APIClient::setRecorder(recorder);
+    state.measure([&] {
+        APIClient::clearValidators();
+        std::string status;
+        APIClient::fetchFromHost("127.0.0.1", upstream.port(), APIClient::MARKETS_PATH, status);
+    }, static_cast<double>(body.size()));
+    APIClient::setRecorder(nullptr);
+    const size_t recorded = recorder->records();
+    recorder->close();
+
+    CaptureReader reader;
+    CapturedResponse response;
+    bool intact = reader.open(path, error);
+    std::int64_t lastOffset = -1;
+    while (intact && reader.next(response)) {
+        intact = response.status == 200 && response.body == body && response.path == APIClient::MARKETS_PATH &&
+            response.headers.find("ETag: \"v1\"") != std::string::npos && response.offsetNs > lastOffset;
+        lastOffset = response.offsetNs;
+    }
+    const auto fileBytes = std::filesystem::file_size(path);
+    state.counter("responses", static_cast<double>(recorded));
+    state.counter("capture_overhead_bytes", static_cast<double>(fileBytes) / recorded - static_cast<double>(body.size()));
+    state.expect(intact && !reader.truncated() && reader.records() == recorded,
+        "every response reads back with its status, headers, body and order");
+
+    // Reopening appends a later session; a torn final record is dropped.
+    recorder = std::make_shared<CaptureWriter>();
+    const bool reopened = recorder->open(path, error);
+    CapturedResponse extra = response;
+    extra.offsetNs = recorder->offsetOf(std::chrono::steady_clock::now());
+    recorder->append(extra);
+    recorder->close();
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+    CaptureReader torn;
+    size_t kept = 0;
+    bool later = true;
+    for (torn.open(path, error); torn.next(response); ++kept) later = later && response.offsetNs <= lastOffset;
+    state.expect(reopened && extra.offsetNs > lastOffset && kept == recorded && torn.truncated() && later,
+        "a new session appends after the last; a truncated record is ignored");
+    std::filesystem::remove(path);
+}
+
+// A recorded session - full lists with drifting prices, ids= batches in
+// between, rate updates - replayed with ReplayClock at max speed through
+// APIClient::replayMarkets and the apply/publish work the app does.
+// Latencies are per response; throughput is coins per second.
+void replayPipeline(bench::State& state) {
+    constexpr size_t COINS = 1000;
+    const int fullLists = state.quick() ? 30 : 200;
+    const std::string path = scratchCapture("session.ctfeed");
+    {
+        CaptureWriter writer;
+        std::string error;
+        writer.open(path, error);
+        CapturedResponse response;
+        response.status = 200;
+        response.headers = "Content-Type: application/json\n";
+        std::int64_t at = 0;
+        for (int i = 0; i < fullLists; ++i) {
+            response.offsetNs = at += 60000000000;   // a minute apart
+            response.path = APIClient::MARKETS_PATH;
+            response.body = datedMarketsJson(COINS, static_cast<std::uint32_t>(i + 1), i * 60);
+            writer.append(response);
+            if (i % 10 == 0) {
+                response.offsetNs = at + 1;
+                response.path = APIClient::EXCHANGE_RATES_PATH;
+                response.body = "{\"rates\":{\"usd\":{\"value\":64000}}}";
+                writer.append(response);
+            }
+            // The ids lane: 50 of the same coins, 5 s later
+            response.offsetNs = at + 5000000000;
+            response.path = APIClient::idsPath({ "bitcoin-0", "ethereum-1" });
+            response.body = datedMarketsJson(50, static_cast<std::uint32_t>(i + 1000), i * 60 + 5);
+            writer.append(response);
+        }
+    }
+
+    std::vector<CryptoCoin> coins;
+    std::unordered_map<std::string, std::vector<float>> history;
+    std::unordered_map<std::string, std::int64_t> quotedAt;
+    SnapshotStore store;
+    unsigned long long version = 0;
+    std::vector<double> latencies;
+    double decoded = 0, bytes = 0;
+    size_t failures = 0;
+
+    static const std::atomic<bool> running{ true };
+    CaptureReader reader;
+    std::string error;
+    reader.open(path, error);
+    ReplayClock clock(0.0);
+    CapturedResponse response;
+    const auto started = bench::Clock::now();
+    while (reader.next(response)) {
+        clock.waitFor(response.offsetNs, running);
+        const auto responseStarted = bench::Clock::now();
+        bytes += static_cast<double>(response.body.size());
+        if (response.path == APIClient::EXCHANGE_RATES_PATH) {
+            ExchangeRates rates;
+            failures += !rates.parse(response.body, error);
+            continue;
+        }
+        std::string status;
+        std::vector<CryptoCoin> data = APIClient::replayMarkets(response, status);
+        failures += data.empty();
+        decoded += static_cast<double>(data.size());
+
+        // As ApplyFullRefresh / MergeUpdates in the app
+        const bool full = response.path.find("&ids=") == std::string::npos;
+        if (full) coins = data;
+        std::vector<std::string> changed;
+        for (const auto& update : data) {
+            if (!AppendQuote(history[update.symbol], quotedAt[update.symbol], update.current_price,
+                update.extras.last_updated, MAX_HISTORY_POINTS)) {
+                continue;
+            }
+            changed.push_back(update.symbol);
+            if (full) continue;
+            for (auto& coin : coins) {
+                if (coin.id == update.id) {
+                    coin.current_price = update.current_price;
+                    coin.extras.last_updated = update.extras.last_updated;
+                    break;
+                }
+            }
+        }
+        auto snap = std::make_shared<MarketSnapshot>();
+        snap->version = ++version;
+        snap->coins = coins;
+        snap->history = store.current()->history;
+        for (const auto& symbol : changed) {
+            snap->history[symbol] = std::make_shared<const std::vector<float>>(history[symbol]);
+        }
+        store.publish(std::move(snap));
+        latencies.push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - responseStarted).count());
+    }
+    const double seconds = std::chrono::duration<double>(bench::Clock::now() - started).count();
+
+    state.samples(std::move(latencies), decoded / seconds);
+    state.counter("responses", static_cast<double>(reader.records()));
+    state.counter("responses_per_s", reader.records() / seconds);
+    state.counter("mb_per_s", bytes / 1e6 / seconds);
+    state.counter("recorded_minutes", fullLists);
+    state.expect(failures == 0 && !reader.truncated(), "every recorded response replays");
+    state.expect(decoded == static_cast<double>(fullLists) * (COINS + 50), "every recorded coin is decoded");
+    std::filesystem::remove(path);
+}
+
+// 11 records 100 ms apart at 20x should take ~50 ms.
+void replayPacing(bench::State& state) {
+    static const std::atomic<bool> running{ true };
+    std::vector<double> lateNs;
+    ReplayClock clock(20.0);
+    const auto started = bench::Clock::now();
+    for (int i = 0; i <= 10; ++i) {
+        const std::int64_t offset = 7000000000 + i * 100000000LL;
+        clock.waitFor(offset, running);
+        const double dueNs = (offset - 7000000000) / 20.0;
+        lateNs.push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - started).count() - dueNs);
+    }
+    const double totalMs = msSince(started);
+    state.samples(std::move(lateNs));
+    state.counter("total_ms", totalMs);
+    state.expect(totalMs >= 49.0 && totalMs < 150.0, "20x replays 1 s of records in ~50 ms");
+}
+
+// ---------------------------------------------------------------------
+// History backfill (MarketChart.h, MergeBackfill)
+// ---------------------------------------------------------------------
+constexpr size_t MAX_BACKFILLED_POINTS = 288 + MAX_HISTORY_POINTS;   // as in CryptoTracker.cpp
+constexpr size_t BACKFILL_LRU_COINS = 16;
+constexpr std::int64_t SELECTED_AT_MS = 1772366400000;   // 2026-03-01T12:00:00Z
+constexpr std::int64_t MINUTE_NS = 60000000000;
+
+// A day of 5-minute prices ending at SELECTED_AT_MS, as CoinGecko lays
+// out the body (three series, prices first).
+std::string marketChartJson(std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> step(0.0, 0.002);
+    std::string prices, caps;
+    double price = 100.0 + seed;
+    char pair[64];
+    for (int i = 287; i >= 0; --i) {
+        price *= 1.0 + step(rng);
+        const long long ms = SELECTED_AT_MS - i * 300000LL;
+        std::snprintf(pair, sizeof pair, "%s[%lld,%.6f]", prices.empty() ? "" : ",", ms, price);
+        prices += pair;
+        std::snprintf(pair, sizeof pair, "%s[%lld,%.1f]", caps.empty() ? "" : ",", ms, price * 19e6);
+        caps += pair;
+    }
+    return "{\"prices\":[" + prices + "],\"market_caps\":[" + caps + "],\"total_volumes\":[" + caps + "]}";
+}
+
+// Live points of a coin whose last `count` refreshes came a minute apart,
+// the newest just before the selection.
+std::vector<HistoryPoint> livePoints(size_t count) {
+    std::vector<HistoryPoint> live;
+    for (size_t i = count; i > 0; --i) {
+        live.push_back({ SELECTED_AT_MS * 1000000 - static_cast<std::int64_t>(i) * MINUTE_NS + 30000000000, 200.0 + i });
+    }
+    return live;
+}
+
+// A coin selected after `liveCount` refreshes: its chart fetched from the
+// mock upstream, decoded and merged in front of the live points. Time per
+// op is selection to full graph; the live-only figure is how long the
+// refresh loop alone takes to fill MAX_HISTORY_POINTS.
+void backfillTimeToGraph(bench::State& state) {
+    constexpr size_t LIVE = 20;
+    MockUpstream upstream;
+    upstream.server.Get(R"(/api/v3/coins/([^/]+)/market_chart)", [](const httplib::Request& req, httplib::Response& res) {
+        // octet-stream: the mock would otherwise compress every response itself
+        res.set_content(marketChartJson(static_cast<std::uint32_t>(req.matches[1].str().size())), "application/octet-stream");
+    });
+    if (!upstream.start()) return;
+
+    const std::vector<HistoryPoint> live = livePoints(LIVE);
+    std::vector<float> history;
+    std::vector<HistoryPoint> points;
+    std::string status;
+    bool fetched = true;
+    size_t prepended = 0;
+    state.measure([&] {
+        history.clear();
+        std::int64_t oldest = 0, last = 0;
+        for (const auto& p : live) {
+            if (history.empty()) oldest = p.quotedAt;
+            AppendQuote(history, last, p.price, p.quotedAt, MAX_BACKFILLED_POINTS);
+        }
+        fetched = APIClient::fetchMarketChartFromHost("127.0.0.1", upstream.port(), "bitcoin", points, status) && fetched;
+        prepended = MergeBackfill(history, oldest, last, points, MAX_BACKFILLED_POINTS);
+    });
+    state.counter("chart_points", static_cast<double>(points.size()));
+    state.counter("graph_points", static_cast<double>(history.size()));
+    state.counter("live_only_full_graph_s", MAX_HISTORY_POINTS * 60.0);
+
+    // The chart's points up to the oldest live one, then the live points:
+    // nothing the live history already covers comes in twice.
+    std::vector<float> expected;
+    for (const auto& p : points) {
+        if (p.quotedAt < live.front().quotedAt) expected.push_back(static_cast<float>(p.price));
+    }
+    for (const auto& p : live) expected.push_back(static_cast<float>(p.price));
+    state.expect(fetched && points.size() == 288 && points.back().quotedAt == SELECTED_AT_MS * 1000000,
+        "the chart decodes every 5-minute point: " + status);
+    state.expect(history == expected && prepended == 288 - 4, "backfill stops short of the oldest live point");
+
+    // Recorded charts replay to the same points
+    const std::string path = scratchCapture("chart.ctfeed");
+    auto recorder = std::make_shared<CaptureWriter>();
+    std::string error;
+    recorder->open(path, error);
+    APIClient::setRecorder(recorder);
+    APIClient::fetchMarketChartFromHost("127.0.0.1", upstream.port(), "ethereum", points, status);
+    APIClient::setRecorder(nullptr);
+    recorder->close();
+    CaptureReader reader;
+    CapturedResponse response;
+    std::vector<HistoryPoint> replayed;
+    const bool read = reader.open(path, error) && reader.next(response);
+    const bool same = read && APIClient::marketChartId(response.path) == "ethereum" &&
+        APIClient::replayMarketChart(response, replayed, status) && replayed.size() == points.size() &&
+        std::equal(replayed.begin(), replayed.end(), points.begin(), [](const HistoryPoint& a, const HistoryPoint& b) {
+            return a.quotedAt == b.quotedAt && a.price == b.price;
+        });
+    state.expect(same && APIClient::marketChartId(APIClient::MARKETS_PATH).empty(),
+        "a recorded chart replays to the same points");
+    std::filesystem::remove(path);
+}
+
+// Decode + merge without the socket, the decoder fed in odd chunk sizes,
+// then a user walking through 200 coins: the LRU keeps the backfilled
+// histories to BACKFILL_LRU_COINS.
+void backfillLruBound(bench::State& state) {
+    const std::string body = marketChartJson(3);
+    std::vector<HistoryPoint> points;
+    std::vector<float> history;
+    bool decoded = true;
+    state.measure([&] {
+        points.clear();
+        MarketChartDecoder decoder(points);
+        for (size_t at = 0; at < body.size(); at += 1337) {
+            decoder.feed(body.data() + at, std::min<size_t>(1337, body.size() - at));
+        }
+        decoded = decoder.finish() && decoded;
+        history.clear();
+        std::int64_t oldest = 0, last = 0;
+        MergeBackfill(history, oldest, last, points, MAX_BACKFILLED_POINTS);
+    }, static_cast<double>(body.size()));
+    state.expect(decoded && points.size() == 288 && history.size() == 288, "chunked chart decodes and merges");
+
+    std::vector<HistoryPoint> bytewise;
+    MarketChartDecoder oneByte(bytewise);
+    for (char c : body) oneByte.feed(&c, 1);
+    state.expect(oneByte.finish() && bytewise.size() == points.size() && bytewise[17].price == points[17].price,
+        "byte-at-a-time feeding decodes the same points");
+
+    auto decodes = [](const std::string& text, size_t& count) {
+        std::vector<HistoryPoint> out;
+        MarketChartDecoder decoder(out);
+        const bool ok = decoder.feed(text.data(), text.size()) && decoder.finish();
+        count = out.size();
+        return ok;
+    };
+    size_t count = 0;
+    state.expect(decodes("{\"prices\":[[1,2.5],[2,null],[3, 4]],\"market_caps\":[]}", count) && count == 2,
+        "null prices are skipped");
+    state.expect(!decodes("{\"prices\":[[1,2.5],[2]]}", count) && !decodes("{\"prices\":[[1,2", count) &&
+        !decodes("{\"total_volumes\":[]}", count) && !decodes("[]", count),
+        "malformed, truncated and price-less charts are rejected");
+
+    // Undated live points are left alone; a second backfill adds nothing.
+    std::vector<float> undated = { 1.0f, 2.0f };
+    std::int64_t unknown = 0, last = 0;
+    std::int64_t oldest = 0;
+    const bool untouched = MergeBackfill(undated, unknown, last, points, MAX_BACKFILLED_POINTS) == 0;
+    state.expect(untouched && MergeBackfill(history, oldest, last, points, MAX_BACKFILLED_POINTS) == 0,
+        "backfill never adds a point twice");
+
+    // As ApplyBackfill: the coin evicted from the LRU drops its history.
+    BackfillLru lru(BACKFILL_LRU_COINS);
+    std::unordered_map<std::string, std::vector<float>> histories;
+    size_t peakBackfilled = 0;
+    for (int i = 0; i < 200; ++i) {
+        const std::string symbol = "coin" + std::to_string(i % 40);
+        if (lru.contains(symbol)) {
+            lru.touch(symbol);
+            continue;
+        }
+        const std::string evicted = lru.insert(symbol);
+        if (!evicted.empty()) histories[evicted] = std::vector<float>();
+        std::int64_t o = 0, l = 0;
+        MergeBackfill(histories[symbol], o, l, points, MAX_BACKFILLED_POINTS);
+        size_t backfilled = 0;
+        for (const auto& entry : histories) backfilled += !entry.second.empty();
+        peakBackfilled = std::max(peakBackfilled, backfilled);
+    }
+    size_t bytes = 0;
+    for (const auto& entry : histories) bytes += entry.second.capacity() * sizeof(float);
+    state.counter("history_kb_after_200_selections", bytes / 1024.0);
+    state.expect(peakBackfilled == BACKFILL_LRU_COINS && lru.size() == BACKFILL_LRU_COINS,
+        "at most BACKFILL_LRU_COINS coins hold a backfilled day");
+}
+
+// ---------------------------------------------------------------------
+// Request broker (RequestBroker.h)
+// ---------------------------------------------------------------------
+constexpr auto BROKER_UPSTREAM_DELAY = std::chrono::milliseconds(50);   // keeps requests in flight
+
+// Runs `call(k)` on `callers` threads released together.
+template <typename Call>
+void concurrently(int callers, Call call) {
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> threads;
+    for (int k = 0; k < callers; ++k) {
+        threads.emplace_back([&, k] {
+            ++ready;
+            while (!go) std::this_thread::yield();
+            call(k);
+        });
+    }
+    while (ready < callers) std::this_thread::yield();
+    go = true;
+    for (auto& t : threads) t.join();
+}
+
+// 64 callers ask for the same markets list at once, through a broker with
+// no cache (coalescing alone), then the same without the broker. Time per
+// op is one round; the mock counts what reaches it.
+void coalesceIdentical(bench::State& state) {
+    constexpr int CALLERS = 64;
+    const std::string body = bench::syntheticMarketsJson(1000);
+    std::atomic<int> hits{ 0 }, chartHits{ 0 };
+    MockUpstream upstream;
+    upstream.server.new_task_queue = [] { return new httplib::ThreadPool(CALLERS); };
+    upstream.server.Get("/api/v3/coins/markets", [&](const httplib::Request&, httplib::Response& res) {
+        ++hits;
+        std::this_thread::sleep_for(BROKER_UPSTREAM_DELAY);
+        res.set_content(body, "application/octet-stream");
+    });
+    upstream.server.Get(R"(/api/v3/coins/([^/]+)/market_chart)", [&](const httplib::Request&, httplib::Response& res) {
+        ++chartHits;
+        std::this_thread::sleep_for(BROKER_UPSTREAM_DELAY);
+        res.set_content(marketChartJson(1), "application/octet-stream");
+    });
+    if (!upstream.start()) return;
+
+    RequestBroker broker(BrokerUpstream::host("127.0.0.1", upstream.port()), std::chrono::seconds(0));
+    int rounds = 0;
+    std::atomic<int> complete{ 0 };
+    state.measure([&] {
+        ++rounds;
+        concurrently(CALLERS, [&](int) {
+            std::string status;
+            if (broker.fetch(APIClient::MARKETS_PATH, status).size() == 1000) ++complete;
+        });
+    });
+    const int brokered = hits.load();
+
+    hits = 0;
+    concurrently(CALLERS, [&](int) {
+        std::string status;
+        APIClient::fetchFromHost("127.0.0.1", upstream.port(), APIClient::MARKETS_PATH, status);
+    });
+    const int direct = hits.load();
+
+    std::atomic<int> charts{ 0 };
+    concurrently(16, [&](int) {
+        std::vector<HistoryPoint> points;
+        std::string status;
+        if (broker.fetchMarketChart("bitcoin", points, status) && points.size() == 288) ++charts;
+    });
+
+    const BrokerStats stats = broker.stats();
+    state.counter("callers", CALLERS);
+    state.counter("upstream_hits_per_round", static_cast<double>(brokered) / rounds);
+    state.counter("upstream_hits_without_broker", direct);
+    state.expect(brokered == rounds && stats.upstream == static_cast<unsigned long long>(rounds) + 1,
+        "64 identical calls in flight reach upstream once");
+    state.expect(complete == rounds * CALLERS, "every caller gets the whole list");
+    state.expect(chartHits == 1 && charts == 16, "16 identical chart calls share one request");
+}
+
+// 32 callers with overlapping ids= windows over 175 coins, at once. Time
+// per op is one round; every id should go upstream exactly once, in a
+// handful of requests.
+void mergeOverlappingIds(bench::State& state) {
+    constexpr int CALLERS = 32;
+    constexpr int WINDOW = 20, STRIDE = 5;
+    constexpr int UNION = (CALLERS - 1) * STRIDE + WINDOW;
+    const nlohmann::json universe = nlohmann::json::parse(bench::syntheticMarketsJson(UNION));
+    std::unordered_map<std::string, std::string> rows;
+    std::vector<std::string> allIds;
+    for (const auto& coin : universe) {
+        allIds.push_back(coin["id"].get<std::string>());
+        rows[allIds.back()] = coin.dump();
+    }
+
+    std::atomic<int> hits{ 0 }, idsServed{ 0 };
+    MockUpstream upstream;
+    upstream.server.new_task_queue = [] { return new httplib::ThreadPool(CALLERS); };
+    upstream.server.Get("/api/v3/coins/markets", [&](const httplib::Request& req, httplib::Response& res) {
+        ++hits;
+        std::this_thread::sleep_for(BROKER_UPSTREAM_DELAY);
+        std::string body = "[";
+        const std::string ids = req.get_param_value("ids");
+        for (size_t at = 0; at <= ids.size();) {
+            size_t comma = ids.find(',', at);
+            if (comma == std::string::npos) comma = ids.size();
+            auto row = rows.find(ids.substr(at, comma - at));
+            if (row != rows.end()) {
+                if (body.size() > 1) body += ',';
+                body += row->second;
+                ++idsServed;
+            }
+            at = comma + 1;
+        }
+        res.set_content(body + "]", "application/octet-stream");
+    });
+    if (!upstream.start()) return;
+
+    RequestBroker broker(BrokerUpstream::host("127.0.0.1", upstream.port()), std::chrono::seconds(0),
+        std::chrono::milliseconds(5));
+    int rounds = 0;
+    std::atomic<int> exact{ 0 };
+    state.measure([&] {
+        ++rounds;
+        concurrently(CALLERS, [&](int k) {
+            const std::vector<std::string> ids(allIds.begin() + k * STRIDE, allIds.begin() + k * STRIDE + WINDOW);
+            std::string status;
+            const std::vector<CryptoCoin> got = broker.fetchIds(ids, status);
+            bool same = got.size() == ids.size();
+            for (size_t i = 0; same && i < got.size(); ++i) same = got[i].id == ids[i];
+            if (same) ++exact;
+        });
+    });
+
+    state.counter("callers", CALLERS);
+    state.counter("upstream_hits_per_round", static_cast<double>(hits.load()) / rounds);
+    state.counter("ids_sent_per_round", static_cast<double>(idsServed.load()) / rounds);
+    state.counter("ids_asked_per_round", CALLERS * WINDOW);
+    state.expect(idsServed == rounds * UNION, "overlapping ids= calls send every id once");
+    state.expect(hits.load() <= rounds * 4, "concurrent ids= calls are merged into a few requests");
+    state.expect(exact == rounds * CALLERS, "every caller gets its rows in the order it asked");
+}
+
+// Repeats within the TTL: an ids= call answered by a full list's rows,
+// without a token; the same call after the TTL goes upstream again.
+void ttlCache(bench::State& state) {
+    const std::string body = bench::syntheticMarketsJson(1000);
+    std::atomic<int> hits{ 0 };
+    MockUpstream upstream;
+    upstream.server.Get("/api/v3/coins/markets", [&](const httplib::Request&, httplib::Response& res) {
+        ++hits;
+        res.set_content(body, "application/octet-stream");
+    });
+    if (!upstream.start()) return;
+
+    const std::vector<std::string> ids = { "bitcoin-0", "ethereum-1", "tether-2" };
+    RequestBroker broker(BrokerUpstream::host("127.0.0.1", upstream.port()), std::chrono::seconds(60));
+    std::string status;
+    broker.fetch(APIClient::MARKETS_PATH, status);
+    int admits = 0;
+    size_t got = 0;
+    state.measure([&] {
+        got = broker.fetchIds(ids, status, nullptr, [&admits] { ++admits; return true; }).size();
+    });
+    const int cachedHits = hits.load();
+
+    RequestBroker shortLived(BrokerUpstream::host("127.0.0.1", upstream.port()), std::chrono::milliseconds(30));
+    shortLived.fetch(APIClient::MARKETS_PATH, status);
+    shortLived.fetch(APIClient::MARKETS_PATH, status);
+    const int withinTtl = hits.load() - cachedHits;
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    FetchStats stats;
+    const bool refetched = shortLived.fetchIds({ "bitcoin-0" }, status, &stats).size() == 1 && !stats.shared;
+
+    state.counter("cache_hits", static_cast<double>(broker.stats().cacheHits));
+    state.expect(cachedHits == 1 && admits == 0 && got == ids.size(),
+        "ids= calls are answered from the full list's rows without a request or a token");
+    state.expect(withinTtl == 1 && refetched && hits.load() == cachedHits + 2, "after the TTL the broker asks again");
+
+    RequestBroker refused(BrokerUpstream::host("127.0.0.1", upstream.port()), std::chrono::seconds(60));
+    const bool empty = refused.fetch(APIClient::MARKETS_PATH, status, nullptr, [] { return false; }).empty();
+    state.expect(empty && status == RequestBroker::NOT_ADMITTED && hits.load() == cachedHits + 2,
+        "a call its admit refuses is not sent");
+
+    // An upstream that throws: every caller sharing the request sees the
+    // exception, and the next call sends a request of its own
+    std::atomic<bool> throwing{ true };
+    BrokerUpstream flaky = BrokerUpstream::host("127.0.0.1", upstream.port());
+    flaky.coins = [&throwing, plain = flaky.coins](const std::string& path, std::string& msg, FetchStats* st) {
+        std::this_thread::sleep_for(BROKER_UPSTREAM_DELAY);
+        if (throwing) throw std::runtime_error("upstream blew up");
+        return plain(path, msg, st);
+    };
+    RequestBroker throwingBroker(flaky, std::chrono::seconds(0));
+    std::atomic<int> thrown{ 0 };
+    concurrently(8, [&](int k) {
+        std::string msg;
+        try {
+            if (k % 2) throwingBroker.fetch(APIClient::MARKETS_PATH, msg);
+            else throwingBroker.fetchIds(ids, msg);
+        }
+        catch (const std::runtime_error&) {
+            ++thrown;
+        }
+    });
+    throwing = false;
+    std::string after;
+    const bool recovered = throwingBroker.fetch(APIClient::MARKETS_PATH, after).size() == 1000 &&
+        throwingBroker.fetchIds(ids, after).size() == ids.size();
+    state.expect(thrown == 8 && recovered, "an upstream exception reaches every waiting caller and leaves no dead flight");
+}
+
+// ---------------------------------------------------------------------
+// Market providers (MarketProviders.h): a CoinGecko mock and an exchange
+// ticker mock, each with a few requests made slow
+// ---------------------------------------------------------------------
+constexpr size_t PROVIDER_COINS = 100;
+constexpr auto PROVIDER_FAST = std::chrono::milliseconds(4);
+constexpr auto PROVIDER_SLOW = std::chrono::milliseconds(300);
+constexpr unsigned PROVIDER_SLOW_PERCENT = 3;
+
+// Same requests slow on every run; `salt` gives each mock its own ones.
+bool injectedSlow(unsigned request, unsigned salt) {
+    return ((request + salt) * 2654435761u >> 16) % 100 < PROVIDER_SLOW_PERCENT;
+}
+
+struct ProviderMocks {
+    MockUpstream coinGecko;
+    MockUpstream exchange;
+    std::atomic<unsigned> coinGeckoHits{ 0 }, exchangeHits{ 0 };
+    std::atomic<bool> coinGeckoDown{ false };
+    std::atomic<bool> conditionalAsked{ false };   // last CoinGecko request sent If-None-Match
+    std::string marketsBody;
+    std::string tickerBody;
+    nlohmann::json tickers;
+
+    bool start() {
+        marketsBody = bench::syntheticMarketsJson(PROVIDER_COINS);
+        tickers = nlohmann::json::array();
+        for (const auto& coin : nlohmann::json::parse(marketsBody)) {
+            if (!coin["current_price"].is_number()) continue;   // not listed on the exchange
+            std::string symbol = coin["symbol"].get<std::string>();
+            for (char& c : symbol) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            char last[32], high[32];
+            std::snprintf(last, sizeof last, "%.8f", coin["current_price"].get<double>() * 1.01);
+            std::snprintf(high, sizeof high, "%.8f", coin["current_price"].get<double>() * 1.05);
+            tickers.push_back({ { "symbol", symbol + "USDT" }, { "lastPrice", last }, { "priceChangePercent", "2.500" },
+                { "highPrice", high }, { "lowPrice", last }, { "quoteVolume", "123456.78000000" },
+                { "closeTime", SELECTED_AT_MS } });
+        }
+        tickers.push_back({ { "symbol", "NOTACOINUSDT" }, { "lastPrice", "1.00000000" } });
+        tickerBody = tickers.dump();
+
+        coinGecko.server.Get("/api/v3/coins/markets", [this](const httplib::Request& req, httplib::Response& res) {
+            const unsigned n = coinGeckoHits++;
+            conditionalAsked = req.has_header("If-None-Match");
+            if (coinGeckoDown) {
+                res.status = 500;
+                return;
+            }
+            std::this_thread::sleep_for(injectedSlow(n, 0) ? PROVIDER_SLOW : PROVIDER_FAST);
+            res.set_header("ETag", "\"markets\"");
+            res.set_content(marketsBody, "application/octet-stream");
+        });
+        exchange.server.Get(TickerAdapter::TICKER_PATH, [this](const httplib::Request&, httplib::Response& res) {
+            const unsigned n = exchangeHits++;
+            std::this_thread::sleep_for(injectedSlow(n, 7919) ? PROVIDER_SLOW : PROVIDER_FAST * 2);
+            res.set_content(tickerBody, "application/octet-stream");
+        });
+        return coinGecko.start() && exchange.start();
+    }
+
+    std::vector<MarketProvider> providers() {
+        return DefaultProviders(std::make_shared<TickerAdapter>("127.0.0.1", exchange.port(), false),
+            BrokerUpstream::host("127.0.0.1", coinGecko.port()));
+    }
+};
+
+// Sequential full-list fetches; latency samples are per fetch.
+void providerTail(bench::State& state, bool hedged) {
+    ProviderMocks mocks;
+    if (!mocks.start()) return;
+    std::vector<MarketProvider> providers = mocks.providers();
+    if (!hedged) providers.resize(1);
+    HedgedProviders hedge(std::move(providers));
+
+    std::string status;
+    for (int i = 0; i < 16; ++i) hedge.fetch(APIClient::MARKETS_PATH, status);   // learn latencies
+    const HedgeStats warm = hedge.hedgeStats();
+    const unsigned warmHits = mocks.coinGeckoHits + mocks.exchangeHits;
+
+    const int fetches = state.quick() ? 200 : 1000;
+    const size_t traceBuffers = trace::registry().buffers().size();
+    std::vector<double> latencies;
+    int complete = 0;
+    const auto started = bench::Clock::now();
+    for (int i = 0; i < fetches; ++i) {
+        const auto fetchStarted = bench::Clock::now();
+        if (hedge.fetch(APIClient::MARKETS_PATH, status).size() == PROVIDER_COINS) ++complete;
+        latencies.push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - fetchStarted).count());
+    }
+    const double seconds = std::chrono::duration<double>(bench::Clock::now() - started).count();
+    std::this_thread::sleep_for(PROVIDER_SLOW);   // let losing requests land in the hit counts
+
+    const HedgeStats stats = hedge.hedgeStats();
+    const double extra = static_cast<double>(mocks.coinGeckoHits + mocks.exchangeHits - warmHits) - fetches;
+    const double maxMs = *std::max_element(latencies.begin(), latencies.end()) / 1e6;
+    std::vector<double> sorted = latencies;
+    std::sort(sorted.begin(), sorted.end());
+    const double p99Ms = sorted[sorted.size() * 99 / 100] / 1e6;
+
+    state.samples(std::move(latencies), fetches / seconds);
+    state.counter("max_ms", maxMs);
+    state.counter("hedge_rate", static_cast<double>(stats.hedges - warm.hedges) / fetches);
+    state.counter("extra_requests_per_fetch", extra / fetches);
+    state.expect(complete == fetches, "every fetch returns the whole list");
+    state.expect(trace::registry().buffers().size() == traceBuffers, "fetches add no threads (or trace buffers)");
+    if (hedged) {
+        state.expect(p99Ms < PROVIDER_SLOW.count() / 3.0, "hedging keeps p99 well under the injected stall");
+        state.expect(extra / fetches < 0.15, "hedges stay rare (under 15% extra requests)");
+    }
+    else {
+        state.expect(p99Ms >= PROVIDER_SLOW.count() * 0.9, "one provider's stalls show up in p99");
+    }
+}
+
+// CoinGecko answers once, then fails: the first failures fail over to the
+// exchange, which then leads the ranking while CoinGecko cools down. Time
+// per op is a fetch answered by the exchange.
+void providerFailover(bench::State& state) {
+    ProviderMocks mocks;
+    if (!mocks.start()) return;
+    HedgeOptions options;
+    options.failuresToCool = 3;
+    options.coolDown = std::chrono::minutes(5);
+    HedgedProviders hedge(mocks.providers(), options);
+
+    std::string status;
+    const std::vector<CryptoCoin> reference = hedge.fetch(APIClient::MARKETS_PATH, status);
+    APIClient::fetchFromHost("127.0.0.1", mocks.coinGecko.port(), APIClient::MARKETS_PATH, status);
+    const bool validatorKept = mocks.conditionalAsked;
+    APIClient::fetchFromHost("127.0.0.1", mocks.coinGecko.port(), APIClient::MARKETS_PATH, status);
+    mocks.coinGeckoDown = true;
+    std::vector<CryptoCoin> repriced;
+    for (int i = 0; i < 6; ++i) repriced = hedge.fetch(APIClient::MARKETS_PATH, status);
+    const unsigned coinGeckoHits = mocks.coinGeckoHits - 2;   // less the two direct requests
+    const HedgeStats failed = hedge.hedgeStats();
+    const std::vector<ProviderStatus> ranked = hedge.status();
+
+    size_t got = 0;
+    state.measure([&] { got = hedge.fetch(APIClient::MARKETS_PATH, status).size(); });
+
+    state.counter("failovers", static_cast<double>(failed.failovers));
+    state.expect(reference.size() == PROVIDER_COINS && repriced.size() == PROVIDER_COINS && got == PROVIDER_COINS,
+        "the exchange answers with CoinGecko's rows while CoinGecko is down");
+    state.expect(coinGeckoHits == 1 + 3 && failed.failovers == 3,
+        "three failures fail over, then CoinGecko is no longer asked");
+    state.expect(ranked.size() == 2 && ranked[0].name == "Binance" && ranked[1].cooling && ranked[1].failures == 3,
+        "the cooling provider drops to the end of the ranking");
+
+    bool mapped = repriced.size() == reference.size();
+    for (size_t i = 0; mapped && i < repriced.size(); ++i) {
+        const CryptoCoin& was = reference[i];
+        const CryptoCoin& now = repriced[i];
+        if (was.current_price <= 0.0) {   // unlisted: CoinGecko's row as it was
+            mapped = now.id == was.id && now.current_price == was.current_price &&
+                now.extras.last_updated == was.extras.last_updated;
+            continue;
+        }
+        mapped = now.id == was.id && std::abs(now.current_price - was.current_price * 1.01) <= was.current_price * 1e-6 &&
+            std::abs(now.market_cap - was.market_cap * 1.01) <= was.market_cap * 1e-6 + 1.0 &&
+            now.price_change_24h == 2.5 && now.extras.total_volume == 123456.78 &&
+            now.extras.last_updated == SELECTED_AT_MS * 1000000;
+    }
+    state.expect(mapped, "ticker fields map onto the CoinGecko rows (price, cap, change, volume, time)");
+
+    HedgedProviders down({ mocks.providers()[0] }, options);
+    std::string why;
+    state.expect(down.fetch(APIClient::MARKETS_PATH, why).empty() && why.rfind("All providers failed: CoinGecko: ", 0) == 0,
+        "all providers failing is reported with each one's reason");
+
+    // The app now holds the exchange's rows: CoinGecko's ETag no longer
+    // describes them, so the next CoinGecko request is unconditional
+    mocks.coinGeckoDown = false;
+    APIClient::fetchFromHost("127.0.0.1", mocks.coinGecko.port(), APIClient::MARKETS_PATH, status);
+    state.expect(validatorKept && !mocks.conditionalAsked, "validators are dropped when another provider's reply wins");
+    APIClient::clearValidators();
+}
+
+} // namespace
+
+BENCHMARK("fetch/slow_drip_1k", [](bench::State& s) { slowDrip(s, 1000); });
+BENCHMARK("fetch/encoding_identity", [](bench::State& s) { encoding(s, false); });
+#if defined(CPPHTTPLIB_BROTLI_SUPPORT)
+BENCHMARK("fetch/encoding_br", [](bench::State& s) { encoding(s, true); });
+#elif defined(CPPHTTPLIB_ZLIB_SUPPORT)
+BENCHMARK("fetch/encoding_gzip", [](bench::State& s) { encoding(s, true); });
+#endif
+BENCHMARK("fetch/conditional_304", conditional304);
+
+// Throughput: body bytes/s (record), coins/s (replay); pacing p50/p99 are lateness.
+BENCHMARK("replay/record_roundtrip_1k", recordRoundTrip);
+BENCHMARK("replay/pipeline_max", replayPipeline);
+BENCHMARK("replay/pacing_20x", replayPacing);
+
+// Time per op is selection to full graph (fetch + decode + merge); the LRU
+// bench's throughput is chart bytes decoded and merged per second.
+BENCHMARK("history/backfill_time_to_full_graph", backfillTimeToGraph);
+BENCHMARK("history/backfill_lru_bound", backfillLruBound);
+
+// Time per op is one round of concurrent calls (a cached ids= call for ttl_cache).
+BENCHMARK("broker/coalesce_identical_64", coalesceIdentical);
+BENCHMARK("broker/merge_overlapping_ids", mergeOverlappingIds);
+BENCHMARK("broker/ttl_cache", ttlCache);
+
+// p50/p99 are per fetch (single_provider vs hedged_two_providers);
+// failover_health's time per op is a fetch from the fallback provider.
+BENCHMARK("providers/single_provider", [](bench::State& s) { providerTail(s, false); });
+BENCHMARK("providers/hedged_two_providers", [](bench::State& s) { providerTail(s, true); });
+BENCHMARK("providers/failover_health", providerFailover);
+
+// p50/p99 are favorites' staleness; counters carry the price error.
+BENCHMARK("sim/refresh_full_only", [](bench::State& s) { refreshPolicy(s, Policy::FullOnly); });
+BENCHMARK("sim/refresh_round_robin", [](bench::State& s) { refreshPolicy(s, Policy::RoundRobin); });
+BENCHMARK("sim/refresh_scheduler", [](bench::State& s) { refreshPolicy(s, Policy::Scheduler); });
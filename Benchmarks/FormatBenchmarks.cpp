@@ -0,0 +1,66 @@
+// Table cell text: formatting every visible-eligible row per frame (the
+// old ImGui::Text path) against text prepared at snapshot capture.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "CoinText.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+constexpr size_t ROWS = 10000;
+
+// What each frame used to do: printf the price and change of every row.
+void perFramePrintf(bench::State& state) {
+    const auto coins = bench::syntheticCoins(ROWS);
+    char price[32], change[16];
+    state.measure([&] {
+        for (const auto& coin : coins) {
+            std::snprintf(price, sizeof(price), "$%.2f", coin.current_price);
+            std::snprintf(change, sizeof(change), coin.price_change_24h >= 0 ? "+%.2f%%" : "%.2f%%", coin.price_change_24h);
+            bench::DoNotOptimize(price);
+            bench::DoNotOptimize(change);
+        }
+    }, static_cast<double>(ROWS));
+}
+
+// What each frame does now: hand over prepared text (TextUnformatted only
+// has to find its end).
+void perFrameCached(bench::State& state) {
+    const auto coins = bench::syntheticCoins(ROWS);
+    std::vector<CoinCellText> cells;
+    UpdateCoinCells(coins, cells, NumberFormat());
+    state.measure([&] {
+        size_t chars = 0;
+        for (const auto& cell : cells) chars += std::strlen(cell.priceText) + std::strlen(cell.changeText);
+        bench::DoNotOptimize(chars);
+    }, static_cast<double>(ROWS));
+}
+
+// Capture-time cost: `changed` coins moved since the last capture.
+void captureUpdate(bench::State& state, size_t changed) {
+    auto coins = bench::syntheticCoins(ROWS);
+    std::vector<CoinCellText> cells;
+    const NumberFormat format;
+    UpdateCoinCells(coins, cells, format);
+    size_t next = 0;
+    state.measure([&] {
+        for (size_t i = 0; i < changed; ++i) {
+            CryptoCoin& coin = coins[next++ % ROWS];
+            coin.current_price *= 1.0001;
+            coin.price_change_24h += 0.01;
+            coin.market_cap *= 1.0001;
+        }
+        UpdateCoinCells(coins, cells, format);
+    }, static_cast<double>(changed));
+}
+
+} // namespace
+
+// Throughput (items/s) is rows per second.
+BENCHMARK("format/per_frame_printf_10k", perFramePrintf);
+BENCHMARK("format/per_frame_cached_10k", perFrameCached);
+BENCHMARK("format/capture_all_changed_10k", [](bench::State& s) { captureUpdate(s, ROWS); });
+BENCHMARK("format/capture_50_changed_10k", [](bench::State& s) { captureUpdate(s, 50); });
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "AllocTracker.h"
+#include "imgui.h"
+
+// -------------------------------------------------------------------------
+// ImGui context without a window or GPU: frames are built and tessellated
+// into draw lists exactly as in the app, then dropped. Texture requests
+// from the font atlas are acknowledged without uploading anything.
+// -------------------------------------------------------------------------
+class HeadlessImGui {
+public:
+    HeadlessImGui(float width = 1280.0f, float height = 800.0f) {
+        previous_ = ImGui::GetCurrentContext();
+        if (alloc::enabled()) ImGui::SetAllocatorFunctions(alloc::countedMalloc, alloc::countedFree);
+        context_ = ImGui::CreateContext();
+        ImGui::SetCurrentContext(context_);
+
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = ImVec2(width, height);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+        ImGui::StyleColorsDark();
+    }
+
+    ~HeadlessImGui() {
+        ImGui::DestroyContext(context_);
+        ImGui::SetCurrentContext(previous_);
+    }
+
+    HeadlessImGui(const HeadlessImGui&) = delete;
+    HeadlessImGui& operator=(const HeadlessImGui&) = delete;
+
+    // One full frame: the app's "Dashboard" window around `body`.
+    template <typename Body>
+    void frame(Body&& body) {
+        ImGui::SetCurrentContext(context_);
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0, 0));
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin("Dashboard", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoResize);
+        body();
+        ImGui::End();
+        ImGui::Render();
+        acknowledgeTextures();
+    }
+
+private:
+    static void acknowledgeTextures() {
+        for (ImTextureData* tex : ImGui::GetPlatformIO().Textures) {
+            if (tex->Status == ImTextureStatus_WantCreate || tex->Status == ImTextureStatus_WantUpdates) {
+                tex->SetTexID(static_cast<ImTextureID>(1));
+                tex->SetStatus(ImTextureStatus_OK);
+            }
+            else if (tex->Status == ImTextureStatus_WantDestroy) {
+                tex->SetTexID(ImTextureID_Invalid);
+                tex->SetStatus(ImTextureStatus_Destroyed);
+            }
+        }
+    }
+
+    ImGuiContext* previous_ = nullptr;
+    ImGuiContext* context_ = nullptr;
+};
@@ -0,0 +1,171 @@
+// The decoder's number path (JsonNumber.h) against strtod and plain
+// std::from_chars, over every numeric token of a 100k-coin response, plus
+// bit-exactness against strtod.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "JsonNumber.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Token {
+    const char* begin;
+    const char* end;
+};
+
+// The numeric values of a 100k-coin /coins/markets body: every value that
+// follows a key and starts like a number. Built once; the tokens point into
+// the cached body.
+const std::vector<Token>& numericTokens(size_t* bodyBytes = nullptr) {
+    static const std::string body = bench::syntheticMarketsJson(100000);
+    static const std::vector<Token> tokens = [] {
+        std::vector<Token> out;
+        const char* p = body.data();
+        const char* end = p + body.size();
+        while ((p = static_cast<const char*>(std::memchr(p, ':', static_cast<size_t>(end - p)))) != nullptr) {
+            ++p;
+            if (p < end && (*p == '-' || (*p >= '0' && *p <= '9')) && p[-2] == '"') {
+                const char* q = p;
+                while (q < end && *q != ',' && *q != '}' && *q != ']') ++q;
+                out.push_back({ p, q });
+            }
+        }
+        return out;
+    }();
+    if (bodyBytes) *bodyBytes = body.size();
+    return tokens;
+}
+
+double tokenBytes(const std::vector<Token>& tokens) {
+    double bytes = 0;
+    for (const auto& t : tokens) bytes += static_cast<double>(t.end - t.begin);
+    return bytes;
+}
+
+template <typename Parse>
+void parseTokens(bench::State& state, Parse parse) {
+    size_t bodyBytes = 0;
+    const auto& tokens = numericTokens(&bodyBytes);
+    std::vector<double> values(tokens.size());
+    size_t failures = 0;
+    state.measure([&] {
+        failures = 0;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            if (!parse(tokens[i], values[i])) ++failures;
+        }
+        bench::DoNotOptimize(values.data());
+    }, static_cast<double>(tokens.size()));
+    state.counter("numbers", static_cast<double>(tokens.size()));
+    state.counter("numeric_bytes_share", tokenBytes(tokens) / static_cast<double>(bodyBytes));
+    state.expect(failures == 0, "every numeric token parses");
+}
+
+bool viaJsonNumber(const Token& t, double& out) {
+    return ParseJsonNumber(t.begin, t.end, out) == t.end;
+}
+
+// What the decoder did before: the body is NUL-terminated, so strtod stops
+// at the delimiter.
+bool viaStrtod(const Token& t, double& out) {
+    char* parsed = nullptr;
+    out = std::strtod(t.begin, &parsed);
+    return parsed == t.end;
+}
+
+bool viaFromChars(const Token& t, double& out) {
+    const auto result = std::from_chars(t.begin, t.end, out);
+    return result.ec == std::errc() && result.ptr == t.end;
+}
+
+void jsonNumber(bench::State& state) {
+    parseTokens(state, viaJsonNumber);
+
+    const auto& tokens = numericTokens();
+    size_t mismatches = 0;
+    for (const auto& t : tokens) {
+        double fast = 0, reference = 0;
+        viaJsonNumber(t, fast);
+        viaStrtod(t, reference);
+        if (std::memcmp(&fast, &reference, sizeof fast) != 0) ++mismatches;
+    }
+    state.expect(mismatches == 0, "same bits as strtod on every token");
+}
+
+void strtodBaseline(bench::State& state) {
+    parseTokens(state, viaStrtod);
+}
+
+void fromCharsBaseline(bench::State& state) {
+    parseTokens(state, viaFromChars);
+}
+
+// Round-trip and edge cases across every route of the parser: short and
+// 17-digit decimals, integers past 2^53, extreme exponents, subnormals.
+void exactness(bench::State& state) {
+    std::vector<std::string> cases = {
+        "0", "-0", "0.0", "1", "-1", "0.1", "0.3", "64000.5", "0.00001234", "1e22", "1e23",
+        "9007199254740992", "9007199254740993", "18446744073709551615", "123456789012345678901234",
+        "1.7976931348623157e308", "2.2250738585072014e-308", "4.9406564584124654e-324",
+        "1E5", "1e+5", "1.5e-7", "0.000000000000000000000000001", "2.5e-23", "123.456e-2",
+    };
+    std::mt19937_64 rng(45);
+    std::uniform_real_distribution<double> logMagnitude(-12.0, 16.0);
+    char buffer[64];
+    for (int i = 0; i < 20000; ++i) {
+        const double v = std::pow(10.0, logMagnitude(rng)) * (i % 7 == 0 ? -1 : 1);
+        std::snprintf(buffer, sizeof buffer, "%.17g", v);
+        cases.push_back(buffer);
+        const auto shortest = std::to_chars(buffer, buffer + sizeof buffer, v);
+        cases.emplace_back(buffer, shortest.ptr);
+        std::snprintf(buffer, sizeof buffer, "%.2f", v);   // how prices usually arrive
+        cases.push_back(buffer);
+        cases.push_back(std::to_string(rng() >> (i % 64)));
+    }
+
+    size_t mismatches = 0;
+    double sink = 0;
+    state.measure([&] {
+        for (const auto& c : cases) {
+            double value = 0;
+            ParseJsonNumber(c.data(), c.data() + c.size(), value);
+            sink += value;
+        }
+        bench::DoNotOptimize(sink);
+    }, static_cast<double>(cases.size()));
+    for (const auto& c : cases) {
+        double value = 0;
+        const char* end = ParseJsonNumber(c.data(), c.data() + c.size(), value);
+        const double reference = std::strtod(c.c_str(), nullptr);
+        if (end != c.data() + c.size() || std::memcmp(&value, &reference, sizeof value) != 0) ++mismatches;
+    }
+    state.counter("cases", static_cast<double>(cases.size()));
+    state.expect(mismatches == 0, "every case matches strtod bit for bit");
+
+    double untouched = 42.0;
+    bool rejected = true;
+    for (const char* bad : { "", "-", "+1", ".5", "1.", "1e", "1e+", "-x", "inf", "nan", "1e400" }) {
+        rejected = rejected && ParseJsonNumber(bad, bad + std::strlen(bad), untouched) == nullptr;
+    }
+    state.expect(rejected && untouched == 42.0, "non-JSON and out-of-range numbers are rejected");
+    const char* hex = "0x10";
+    state.expect(ParseJsonNumber(hex, hex + 4, untouched) == hex + 1 && untouched == 0.0,
+        "a token ends where the JSON grammar does");
+}
+
+} // namespace
+
+// Throughput (items/s) is numbers parsed per second.
+BENCHMARK("number/json_number_100k", jsonNumber);
+BENCHMARK("number/strtod_100k", strtodBaseline);
+BENCHMARK("number/from_chars_100k", fromCharsBaseline);
+BENCHMARK("number/exactness", exactness);
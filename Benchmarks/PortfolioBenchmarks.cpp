@@ -0,0 +1,122 @@
+// Portfolio valuation: PortfolioBook's incremental updates (only holdings
+// of the coins that moved) against re-summing every holding per refresh,
+// plus the size and speed of the portfolios.dat format.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "Portfolio.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr size_t PORTFOLIOS = 1000;
+constexpr size_t HOLDINGS = 500;   // per portfolio
+constexpr size_t COINS = 2000;
+
+struct Fixture {
+    std::vector<CryptoCoin> coins = bench::syntheticCoins(COINS);
+    PortfolioBook book;
+
+    Fixture() {
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<size_t> coin(0, COINS - 1);
+        std::uniform_real_distribution<double> quantity(0.01, 100.0);
+        for (size_t p = 0; p < PORTFOLIOS; ++p) {
+            size_t index = book.addPortfolio("Portfolio " + std::to_string(p), p % 10 == 9);
+            for (size_t h = 0; h < HOLDINGS; ++h) {
+                const CryptoCoin& c = coins[coin(rng)];
+                const double q = quantity(rng);
+                book.addHolding(index, c.id, q, q * c.current_price);
+            }
+        }
+        for (const auto& c : coins) book.updatePrice(c.id, c.current_price);
+    }
+
+    // Moves `count` prices, round robin, as one refresh would.
+    void tick(size_t count, size_t& next) {
+        for (size_t i = 0; i < count; ++i) {
+            CryptoCoin& c = coins[next++ % COINS];
+            c.current_price *= (next & 1) ? 1.0007 : 0.9993;
+            book.updatePrice(c.id, c.current_price);
+        }
+    }
+};
+
+// Every portfolio's value summed from scratch (what the incremental totals
+// must agree with).
+std::vector<double> rescan(const PortfolioBook& book) {
+    std::vector<double> values;
+    values.reserve(book.portfolios().size());
+    for (const auto& p : book.portfolios()) {
+        double value = 0.0;
+        for (const auto& h : p.holdings) value += book.holdingValue(h);
+        values.push_back(value);
+    }
+    return values;
+}
+
+bool matchesRescan(const PortfolioBook& book) {
+    const auto exact = rescan(book);
+    for (size_t i = 0; i < exact.size(); ++i) {
+        const double got = book.portfolios()[i].value;
+        if (std::fabs(got - exact[i]) > 1e-9 * std::max(1.0, std::fabs(exact[i]))) return false;
+    }
+    return true;
+}
+
+void incremental(bench::State& state, size_t changed) {
+    Fixture f;
+    size_t next = 0;
+    state.measure([&] { f.tick(changed, next); }, static_cast<double>(changed));
+    state.counter("holdings", static_cast<double>(PORTFOLIOS * HOLDINGS));
+    state.expect(matchesRescan(f.book), "incremental values match a full rescan");
+}
+
+// The baseline: after a refresh, re-sum every holding of every portfolio.
+void fullRescan(bench::State& state) {
+    Fixture f;
+    size_t next = 0;
+    state.measure([&] {
+        f.tick(50, next);
+        for (size_t i = 0; i < f.book.portfolios().size(); ++i) f.book.revalue(i);
+    }, 50.0);
+    state.expect(matchesRescan(f.book), "revalued totals match a full rescan");
+}
+
+void serialize(bench::State& state) {
+    Fixture f;
+    std::string data;
+    state.measure([&] {
+        data = f.book.serialize();
+        bench::DoNotOptimize(data);
+    });
+    state.counter("bytes", static_cast<double>(data.size()));
+    state.counter("bytes_per_holding", static_cast<double>(data.size()) / (PORTFOLIOS * HOLDINGS));
+}
+
+void deserialize(bench::State& state) {
+    Fixture f;
+    const std::string data = f.book.serialize();
+    PortfolioBook loaded;
+    state.measure([&] {
+        bool ok = loaded.deserialize(data);
+        bench::DoNotOptimize(ok);
+    }, static_cast<double>(PORTFOLIOS * HOLDINGS));
+    state.expect(loaded.serialize() == data, "deserialize(serialize()) round-trips");
+    state.expect(!loaded.deserialize(data.substr(0, data.size() / 2)), "a truncated file is rejected");
+    state.expect(loaded.portfolios().size() == PORTFOLIOS, "a rejected file leaves the book unchanged");
+}
+
+} // namespace
+
+// 1000 portfolios x 500 holdings over 2000 coins. Throughput (items/s) is
+// price updates per second for the update benchmarks, holdings per second
+// for deserialize.
+BENCHMARK("portfolio/update_50_changed", [](bench::State& s) { incremental(s, 50); });
+BENCHMARK("portfolio/update_all_changed", [](bench::State& s) { incremental(s, COINS); });
+BENCHMARK("portfolio/full_rescan_50_changed", fullRescan);
+BENCHMARK("portfolio/serialize", serialize);
+BENCHMARK("portfolio/deserialize", deserialize);
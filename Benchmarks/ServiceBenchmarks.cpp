@@ -0,0 +1,347 @@
+// Serving side: local HTTP API under load, delta fan-out, the shared-memory
+// table, and the cost of recording metrics and trace spans.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "DeltaFeed.h"
+#include "LocalApiServer.h"
+#include "MarketSnapshot.h"
+#include "Metrics.h"
+#include "SharedMarketData.h"
+#include "Trace.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::shared_ptr<MarketSnapshot> makeSnapshot(const std::vector<CryptoCoin>& coins, unsigned long long version) {
+    auto snap = std::make_shared<MarketSnapshot>();
+    snap->version = version;
+    snap->coins = coins;
+    return snap;
+}
+
+// ---------------------------------------------------------------------
+// Local API load test: `clients` keep-alive connections hammering
+// /api/v1/snapshot for a fixed time. p50/p99 are per-request latency.
+// Clients ask for identity encoding: with CPPHTTPLIB_BROTLI_SUPPORT the
+// server would otherwise recompress the JSON on every request, which is
+// what fetch/encoding_br already measures.
+// ---------------------------------------------------------------------
+void apiLoad(bench::State& state, int clients, const char* path) {
+    SnapshotStore store;
+    DeltaFeed feed;
+    store.publish(makeSnapshot(bench::syntheticCoins(100), 1));
+
+    LocalApiServer server(store, feed, static_cast<size_t>(clients) + 8);
+    if (!server.start("127.0.0.1", 0)) return;
+
+    const auto duration = std::chrono::milliseconds(state.quick() ? 500 : 2000);
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<unsigned long long> failures{ 0 };
+    std::vector<std::thread> threads;
+
+    const auto started = bench::Clock::now();
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            const httplib::Headers headers = { { "Accept-Encoding", "identity" } };
+            httplib::Client cli("127.0.0.1", server.port());
+            cli.set_keep_alive(true);
+            cli.set_connection_timeout(5);
+            cli.set_read_timeout(5);
+            while (bench::Clock::now() - started < duration) {
+                auto sent = bench::Clock::now();
+                auto res = cli.Get(path, headers);
+                if (!res || res->status != 200) {
+                    ++failures;
+                    continue;
+                }
+                latencies[c].push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - sent).count());
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    const double seconds = std::chrono::duration<double>(bench::Clock::now() - started).count();
+    server.stop();
+
+    std::vector<double> all;
+    for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    const double requests = static_cast<double>(all.size());
+    state.samples(std::move(all), requests / seconds);
+    state.counter("clients", clients);
+    state.counter("requests", requests);
+    state.counter("failures", static_cast<double>(failures.load()));
+}
+
+// ---------------------------------------------------------------------
+// Delta fan-out: one publisher, `subscribers` threads blocked in
+// DeltaFeed::waitAfter (what every SSE / long-poll connection does).
+// p50/p99 are publish -> wake-up latency per delivered delta.
+// ---------------------------------------------------------------------
+void deltaFanout(bench::State& state, int subscribers) {
+    const int deltas = state.quick() ? 20 : 100;
+    DeltaFeed feed(64);
+    std::vector<bench::Clock::time_point> pushedAt(deltas + 2);
+    std::vector<std::vector<double>> latencies(subscribers);
+    std::atomic<int> ready{ 0 };
+
+    auto coins = bench::syntheticCoins(100);
+    auto prev = makeSnapshot(coins, 1);
+    feed.push(MarketSnapshot(), *prev);   // subscribers start at version 1
+
+    std::vector<std::thread> threads;
+    for (int s = 0; s < subscribers; ++s) {
+        threads.emplace_back([&, s] {
+            unsigned long long cursor = 1;
+            latencies[s].reserve(deltas);
+            ++ready;
+            for (;;) {
+                DeltaFeed::Batch batch = feed.waitAfter(cursor, std::chrono::milliseconds(2000));
+                auto now = bench::Clock::now();
+                if (batch.closed) return;
+                if (batch.resync) return;   // counted below as missing deliveries
+                for (const auto& msg : batch.messages) {
+                    latencies[s].push_back(std::chrono::duration<double, std::nano>(now - pushedAt[msg->version]).count());
+                    cursor = msg->version;
+                }
+                if (cursor >= static_cast<unsigned long long>(deltas) + 1) return;
+            }
+        });
+    }
+    while (ready < subscribers) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    const auto started = bench::Clock::now();
+    for (int d = 0; d < deltas; ++d) {
+        for (size_t i = 0; i < 5; ++i) coins[(d * 5 + i) % coins.size()].current_price *= 1.001;
+        auto next = makeSnapshot(coins, prev->version + 1);
+        pushedAt[next->version] = bench::Clock::now();
+        feed.push(*prev, *next);
+        prev = next;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto& t : threads) t.join();
+    const double seconds = std::chrono::duration<double>(bench::Clock::now() - started).count();
+    feed.shutdown();
+
+    std::vector<double> all;
+    for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    const double expected = static_cast<double>(subscribers) * deltas;
+    const double delivered = static_cast<double>(all.size());
+    state.samples(std::move(all), delivered / seconds);
+    state.counter("subscribers", subscribers);
+    state.counter("delivered_ratio", delivered / expected);
+    state.counter("resyncs", static_cast<double>(feed.resyncs()));
+
+    // A cursor from before a restart (ahead of the feed) resyncs at once
+    DeltaFeed restarted(64);
+    const auto asked = bench::Clock::now();
+    const bool emptyFeed = restarted.waitAfter(static_cast<unsigned long long>(deltas), std::chrono::seconds(5)).resync;
+    restarted.push(MarketSnapshot(), *makeSnapshot(coins, 1));
+    const bool aheadOfRing = restarted.waitAfter(static_cast<unsigned long long>(deltas), std::chrono::seconds(5)).resync;
+    state.expect(emptyFeed && aheadOfRing && bench::Clock::now() - asked < std::chrono::seconds(1),
+        "a cursor newer than the feed gets a resync, not empty batches");
+}
+
+// ---------------------------------------------------------------------
+// Shared-memory table
+// ---------------------------------------------------------------------
+struct SharedTable {
+    SharedMarketWriter writer;
+    SharedMarketReader reader;
+    std::vector<CryptoCoin> coins;
+    unsigned long long version = 0;
+
+    bool open(size_t count) {
+        coins = bench::syntheticCoins(count);
+        if (!writer.open()) return false;
+        publish();
+        return reader.open();
+    }
+
+    void publish() {
+        for (auto& coin : coins) coin.current_price *= 1.0001;
+        writer.publish(*makeSnapshot(coins, ++version));
+    }
+};
+
+void shmRead(bench::State& state, bool concurrentWriter) {
+    SharedTable table;
+    if (!table.open(1000)) return;
+
+    SharedMarketReader::Handle handle = 0;
+    table.reader.find(table.coins[500].id.c_str(), handle);
+
+    std::atomic<bool> running{ true };
+    std::atomic<unsigned long long> publishes{ 0 };
+    std::thread writer;
+    if (concurrentWriter) {
+        writer = std::thread([&] {
+            while (running) {
+                table.publish();
+                ++publishes;
+            }
+        });
+    }
+
+    SharedQuote quote;
+    state.measure([&] {
+        table.reader.read(handle, quote);
+        bench::DoNotOptimize(quote);
+    });
+
+    running = false;
+    if (writer.joinable()) writer.join();
+    if (concurrentWriter) {
+        state.counter("writer_publishes", static_cast<double>(publishes.load()));
+        return;
+    }
+
+    // A writer that died mid-write leaves the sequence odd: readers give up
+    shm_market::Mapping crashed;
+    if (!crashed.create()) return;
+    std::atomic<std::uint64_t>& seq = crashed.segment()->header.seq;
+    seq.fetch_add(1);
+    const auto asked = bench::Clock::now();
+    std::uint64_t version = 0;
+    const bool gaveUp = !table.reader.read(handle, quote) && !table.reader.version(version) &&
+        !table.reader.find(table.coins[500].id.c_str(), handle);
+    const auto waited = bench::Clock::now() - asked;
+    seq.fetch_add(1);
+    state.expect(gaveUp && waited < std::chrono::seconds(1), "readers give up on a writer stuck mid-write");
+    state.expect(table.reader.read(handle, quote) && quote.price == table.coins[500].current_price,
+        "and read again once the sequence is even");
+}
+
+// A universe that keeps changing: 1000 coins per publish, 500 of them new
+// each time, so the segment runs out of fresh slots after ~30 publishes
+// and has to reuse those of coins that left. Time per op is one publish.
+void shmSlotReuse(bench::State& state) {
+    SharedTable table;
+    if (!table.open(1000)) return;
+    const std::vector<CryptoCoin> base = bench::syntheticCoins(1000);
+    size_t round = 0;
+    bool allFit = true;
+    state.measure([&] {
+        ++round;
+        for (size_t i = 0; i < base.size(); ++i) {
+            table.coins[i] = base[i];
+            table.coins[i].id = base[i].id + "-" + std::to_string(round + i / 500);
+        }
+        allFit = table.writer.publish(*makeSnapshot(table.coins, ++table.version)) && allFit;
+    }, static_cast<double>(base.size()));
+
+    SharedMarketReader::Handle handle = 0;
+    SharedQuote quote{};
+    const bool found = table.reader.find(table.coins[999].id.c_str(), handle) && table.reader.read(handle, quote);
+    state.counter("publishes", static_cast<double>(round));
+    state.counter("ids_seen", static_cast<double>(1000 + 500 * round));
+    state.expect(round * 500 < shm_market::CAPACITY || (allFit && table.writer.droppedCoins() == 0),
+        "slots of coins that left are reused once the segment is full");
+    state.expect(found && quote.active && quote.id == table.coins[999].id && quote.price == table.coins[999].current_price,
+        "the newest coins are readable");
+}
+
+// Writer cost for 1000 coins, alone or with `readers` threads polling.
+void shmPublish(bench::State& state, int readers) {
+    SharedTable table;
+    if (!table.open(1000)) return;
+
+    std::atomic<bool> running{ true };
+    std::atomic<unsigned long long> reads{ 0 };
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            SharedMarketReader::Handle handle = 0;
+            table.reader.find(table.coins[r * 100].id.c_str(), handle);
+            SharedQuote quote;
+            unsigned long long n = 0;
+            while (running) {
+                table.reader.read(handle, quote);
+                ++n;
+            }
+            reads += n;
+        });
+    }
+
+    state.measure([&] { table.publish(); }, static_cast<double>(table.coins.size()));
+
+    running = false;
+    for (auto& t : threads) t.join();
+    state.counter("readers", readers);
+    if (readers) state.counter("reads", static_cast<double>(reads.load()));
+}
+
+// ---------------------------------------------------------------------
+// Instrumentation cost
+// ---------------------------------------------------------------------
+void metricsCounter(bench::State& state) {
+    metrics::Counter counter;
+    state.measure([&] { counter.add(); });
+}
+
+void metricsHistogram(bench::State& state) {
+    metrics::Histogram histogram;
+    std::uint64_t value = 12345;
+    state.measure([&] {
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        histogram.recordNanos(value >> 40);
+    });
+}
+
+void metricsScopedTimer(bench::State& state) {
+    metrics::Histogram histogram;
+    state.measure([&] { metrics::ScopedTimer timer(histogram); });
+}
+
+// Four threads recording into the same histogram (shared cache lines).
+void metricsHistogramContended(bench::State& state) {
+    metrics::Histogram histogram;
+    std::atomic<bool> running{ true };
+    std::vector<std::thread> others;
+    for (int t = 0; t < 3; ++t) {
+        others.emplace_back([&] {
+            std::uint64_t v = 1000;
+            while (running) histogram.recordNanos(v++ & 0xFFFF);
+        });
+    }
+    std::uint64_t v = 1000;
+    state.measure([&] { histogram.recordNanos(v++ & 0xFFFF); });
+    running = false;
+    for (auto& t : others) t.join();
+}
+
+void traceSpan(bench::State& state) {
+    state.measure([] { CT_TRACE_SCOPE("bench", "span"); });
+
+    // Short-lived threads take over the buffers of exited ones
+    const size_t before = trace::registry().buffers().size();
+    for (int i = 0; i < 100; ++i) {
+        std::thread([] { CT_TRACE_SCOPE("bench", "short-lived thread"); }).join();
+    }
+    const size_t grown = trace::registry().buffers().size() - before;
+    state.counter("buffers_for_100_threads", static_cast<double>(grown));
+    state.expect(grown <= 1, "exited threads' trace buffers are reused");
+}
+
+} // namespace
+
+BENCHMARK("api/snapshot_load_50_clients", [](bench::State& s) { apiLoad(s, 50, "/api/v1/snapshot"); });
+BENCHMARK("api/snapshot_load_200_clients", [](bench::State& s) { apiLoad(s, 200, "/api/v1/snapshot"); });
+BENCHMARK("api/snapshot_bin_load_200_clients", [](bench::State& s) { apiLoad(s, 200, "/api/v1/snapshot.bin"); });
+BENCHMARK("api/delta_fanout_1000_subscribers", [](bench::State& s) { deltaFanout(s, 1000); });
+
+BENCHMARK("shm/read", [](bench::State& s) { shmRead(s, false); });
+BENCHMARK("shm/read_with_writer", [](bench::State& s) { shmRead(s, true); });
+BENCHMARK("shm/publish_1k", [](bench::State& s) { shmPublish(s, 0); });
+BENCHMARK("shm/publish_1k_4_readers", [](bench::State& s) { shmPublish(s, 4); });
+BENCHMARK("shm/slot_reuse", shmSlotReuse);
+
+BENCHMARK("metrics/counter_add", metricsCounter);
+BENCHMARK("metrics/histogram_record", metricsHistogram);
+BENCHMARK("metrics/histogram_record_contended", metricsHistogramContended);
+BENCHMARK("metrics/scoped_timer", metricsScopedTimer);
+BENCHMARK("trace/span", traceSpan);
@@ -0,0 +1,199 @@
+// ISO-8601 timestamps (Timestamp.h) against the library routes to the same
+// number, and the history dedup they enable.
+
+#include "BenchData.h"
+#include "BenchHarness.h"
+#include "CoinStreamDecoder.h"
+#include "PriceHistory.h"
+#include "Timestamp.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr size_t MAX_HISTORY_POINTS = 120;   // as in CryptoTracker.cpp
+
+// The date columns of a 1k-coin response, as served.
+std::vector<std::string> sampleTimestamps() {
+    const nlohmann::json doc = nlohmann::json::parse(bench::syntheticMarketsJson(1000));
+    std::vector<std::string> out;
+    for (const auto& coin : doc) {
+        for (const char* key : { "last_updated", "ath_date", "atl_date" }) {
+            if (coin.contains(key) && coin[key].is_string()) out.push_back(coin[key].get<std::string>());
+        }
+    }
+    return out;
+}
+
+std::int64_t utcSeconds(std::tm& tm) {
+#ifdef _WIN32
+    return static_cast<std::int64_t>(_mkgmtime(&tm));
+#else
+    return static_cast<std::int64_t>(timegm(&tm));
+#endif
+}
+
+// ".686Z" after the seconds: fraction digits to nanoseconds. Both library
+// routes stop at the seconds, so they share this.
+bool fractionAndZulu(const char* p, std::int64_t& nanos) {
+    nanos = 0;
+    if (*p == '.') {
+        std::int64_t scale = 100000000;
+        for (++p; *p >= '0' && *p <= '9'; ++p, scale /= 10) nanos += (*p - '0') * scale;
+    }
+    return *p == 'Z' && p[1] == '\0';
+}
+
+#ifndef _WIN32
+bool parseStrptime(const std::string& text, std::int64_t& epochNanos) {
+    std::tm tm{};
+    const char* rest = strptime(text.c_str(), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::int64_t nanos;
+    if (!rest || !fractionAndZulu(rest, nanos)) return false;
+    epochNanos = utcSeconds(tm) * 1000000000 + nanos;
+    return true;
+}
+#endif
+
+bool parseGetTime(const std::string& text, std::int64_t& epochNanos) {
+    std::istringstream in(text);
+    in.imbue(std::locale::classic());
+    std::tm tm{};
+    in >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if (in.fail()) return false;
+    std::string rest;
+    std::getline(in, rest);
+    std::int64_t nanos;
+    if (!fractionAndZulu(rest.c_str(), nanos)) return false;
+    epochNanos = utcSeconds(tm) * 1000000000 + nanos;
+    return true;
+}
+
+template <typename Parse>
+void parseAll(bench::State& state, Parse parse) {
+    const auto samples = sampleTimestamps();
+    std::vector<std::int64_t> parsed(samples.size());
+    size_t failures = 0;
+    state.measure([&] {
+        failures = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            if (!parse(samples[i], parsed[i])) ++failures;
+        }
+        bench::DoNotOptimize(parsed.data());
+    }, static_cast<double>(samples.size()));
+    state.counter("timestamps", static_cast<double>(samples.size()));
+    state.expect(failures == 0, "every sample timestamp parses");
+
+    // All routes must land on the same instant.
+    bool agree = true;
+    for (size_t i = 0; i < samples.size() && agree; ++i) {
+        std::int64_t reference = 0;
+        agree = ParseIso8601(samples[i].data(), samples[i].size(), reference) && reference == parsed[i];
+    }
+    state.expect(agree, "agrees with ParseIso8601 on every sample");
+}
+
+void parseFixed(bench::State& state) {
+    parseAll(state, [](const std::string& text, std::int64_t& out) {
+        return ParseIso8601(text.data(), text.size(), out);
+    });
+
+    auto parses = [](const char* text, std::int64_t& out) {
+        return ParseIso8601(text, std::char_traits<char>::length(text), out);
+    };
+    std::int64_t t = 0;
+    state.expect(parses("1970-01-01T00:00:00Z", t) && t == 0, "the epoch is 0");
+    state.expect(parses("2024-02-29T12:00:00.5Z", t) && t == 1709208000500000000, "leap day with a fraction");
+    state.expect(parses("2024-02-29T14:30:00+02:30", t) && t == 1709208000000000000 &&
+        parses("2024-02-29T09:30:00-0230", t) && t == 1709208000000000000, "zone offsets are applied");
+    state.expect(parses("1969-12-31T23:59:59.000000001Z", t) && t == -999999999, "pre-epoch instants");
+    const std::int64_t kept = t;
+    state.expect(!parses("2024-13-01T00:00:00Z", t) && !parses("2023-02-29T00:00:00Z", t) &&
+        !parses("2024-04-31T00:00:00Z", t) && !parses("2024-01-01T24:00:00Z", t) &&
+        !parses("2024-01-01T00:00:00.Z", t) && !parses("2024-01-01T00:00:00Zjunk", t) &&
+        !parses("2024-01-01", t) && !parses("not a timestamp at all", t) && t == kept,
+        "invalid dates and trailing junk are rejected, leaving the output alone");
+}
+
+#ifndef _WIN32
+void parseStrptimeBench(bench::State& state) {
+    parseAll(state, parseStrptime);
+}
+#endif
+
+void parseGetTimeBench(bench::State& state) {
+    parseAll(state, parseGetTime);
+}
+
+// Polling faster than CoinGecko recomputes quotes returns the same
+// last_updated again; those repeats must not become history points.
+void historyDedup(bench::State& state) {
+    const auto samples = sampleTimestamps();
+    std::vector<std::int64_t> quotes;
+    for (const auto& text : samples) {
+        std::int64_t t;
+        if (ParseIso8601(text.data(), text.size(), t)) quotes.push_back(t);
+    }
+    std::vector<float> history;
+    std::int64_t lastQuotedAt = 0;
+    size_t appended = 0;
+    // Each quote is seen three times: twice repeated, then once stale.
+    state.measure([&] {
+        history.clear();
+        lastQuotedAt = 0;
+        appended = 0;
+        std::int64_t at = 0;
+        for (std::int64_t q : quotes) {
+            at += 1 + (q & 0xffff);   // rising, like successive last_updated values
+            appended += AppendQuote(history, lastQuotedAt, 100.0, at, MAX_HISTORY_POINTS);
+            appended += AppendQuote(history, lastQuotedAt, 100.0, at, MAX_HISTORY_POINTS);
+            appended += AppendQuote(history, lastQuotedAt, 100.0, at - 1, MAX_HISTORY_POINTS);
+        }
+        bench::DoNotOptimize(history);
+    }, static_cast<double>(quotes.size() * 3));
+    state.expect(appended == quotes.size(), "repeated and older quotes are skipped");
+
+    std::int64_t unknown = 0;
+    std::vector<float> undated;
+    const bool both = AppendQuote(undated, unknown, 1.0, 0, MAX_HISTORY_POINTS) &&
+        AppendQuote(undated, unknown, 1.0, 0, MAX_HISTORY_POINTS);
+    state.expect(both && undated.size() == 2, "undated quotes are always appended");
+
+    // Either "Market Details" setting decodes the quote time, so a body
+    // served twice adds its points once
+    const std::string& body = bench::coinDataJson();
+    for (CoinFieldSet fields : { CoinFieldSet::defaults(), CoinFieldSet::compact() }) {
+        std::unordered_map<std::string, std::vector<float>> prices;
+        std::unordered_map<std::string, std::int64_t> last;
+        size_t added = 0, coins = 0;
+        for (int poll = 0; poll < 2; ++poll) {
+            CoinStreamDecoder decoder([&](CryptoCoin&& coin) {
+                added += AppendQuote(prices[coin.id], last[coin.id], coin.current_price,
+                    coin.extras.last_updated, MAX_HISTORY_POINTS);
+                if (poll == 0) ++coins;
+            }, fields);
+            decoder.feed(body.data(), body.size());
+            decoder.finish();
+        }
+        state.expect(coins > 0 && added == coins,
+            std::string("a repeated body is skipped with market details ") + (fields.has(CoinField::High24h) ? "on" : "off"));
+    }
+}
+
+} // namespace
+
+// Throughput (items/s) is timestamps parsed per second.
+BENCHMARK("timestamp/parse_fixed", parseFixed);
+#ifndef _WIN32
+BENCHMARK("timestamp/strptime_timegm", parseStrptimeBench);
+#endif
+BENCHMARK("timestamp/get_time_istringstream", parseGetTimeBench);
+BENCHMARK("timestamp/history_dedup", historyDedup);
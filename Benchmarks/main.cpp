@@ -0,0 +1,188 @@
+// CryptoTracker benchmark suite.
+//
+//   CryptoTrackerBench [--filter TEXT] [--quick] [--list]
+//                      [--json FILE] [--baseline FILE] [--data DIR]
+//
+// Prints a table. --json writes the results so two builds can be compared:
+//   { "schema": 1, "compiler": ..., "optimized": ...,
+//     "benchmarks": [ { "name", "iterations", "ns_per_op", "p50_ns", "p99_ns",
+//                       "items_per_second", "counters": { ... }, "failures": [ ... ] } ] }
+// --baseline FILE adds the ns_per_op change against such a file.
+// Exits with 1 if any benchmark's State::expect() checks failed.
+
+#include "AllocTracker.h"
+#include "BenchHarness.h"
+#include "json.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+
+#ifndef CRYPTOTRACKER_SOURCE_DIR
+#define CRYPTOTRACKER_SOURCE_DIR "../CryptoTracker"
+#endif
+
+CT_ALLOCATION_HOOKS()
+
+namespace {
+
+nlohmann::json toJson(const std::vector<bench::Result>& results) {
+    nlohmann::json list = nlohmann::json::array();
+    for (const auto& r : results) {
+        nlohmann::json counters = nlohmann::json::object();
+        for (const auto& c : r.counters) counters[c.first] = c.second;
+        list.push_back({
+            { "name", r.name },
+            { "iterations", r.iterations },
+            { "ns_per_op", r.nsPerOp },
+            { "p50_ns", r.p50Ns },
+            { "p99_ns", r.p99Ns },
+            { "items_per_second", r.itemsPerSecond },
+            { "counters", counters },
+            { "failures", r.failures },
+        });
+    }
+
+#if defined(__clang__)
+    const std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    const std::string compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    const std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    const std::string compiler = "unknown";
+#endif
+
+    return {
+        { "schema", 1 },
+        { "compiler", compiler },
+#ifdef NDEBUG
+        { "optimized", true },
+#else
+        { "optimized", false },
+#endif
+        { "benchmarks", list },
+    };
+}
+
+std::string formatNs(double ns) {
+    char buf[32];
+    if (ns >= 1e9) std::snprintf(buf, sizeof(buf), "%.2f s", ns / 1e9);
+    else if (ns >= 1e6) std::snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+    else if (ns >= 1e3) std::snprintf(buf, sizeof(buf), "%.2f us", ns / 1e3);
+    else std::snprintf(buf, sizeof(buf), "%.1f ns", ns);
+    return buf;
+}
+
+void printResult(const bench::Result& r, const std::map<std::string, double>& baseline) {
+    std::printf("%-44s %12s %12s %12s", r.name.c_str(), formatNs(r.nsPerOp).c_str(),
+        formatNs(r.p50Ns).c_str(), formatNs(r.p99Ns).c_str());
+    if (r.itemsPerSecond > 0) std::printf(" %12.4g/s", r.itemsPerSecond);
+    else std::printf(" %14s", "");
+
+    auto it = baseline.find(r.name);
+    if (it != baseline.end() && it->second > 0) {
+        std::printf("  %+6.1f%%", (r.nsPerOp / it->second - 1.0) * 100.0);
+    }
+    std::printf("\n");
+
+    for (const auto& c : r.counters) {
+        std::printf("    %-40s %.6g\n", c.first.c_str(), c.second);
+    }
+    for (const auto& f : r.failures) {
+        std::printf("    FAILED: %s\n", f.c_str());
+    }
+    std::fflush(stdout);
+}
+
+std::map<std::string, double> loadBaseline(const std::string& path) {
+    std::map<std::string, double> nsByName;
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "cannot read baseline %s\n", path.c_str());
+        return nsByName;
+    }
+    nlohmann::json doc = nlohmann::json::parse(file, nullptr, false);
+    if (doc.is_discarded() || !doc.contains("benchmarks")) {
+        std::fprintf(stderr, "baseline %s is not a benchmark result file\n", path.c_str());
+        return nsByName;
+    }
+    for (const auto& b : doc["benchmarks"]) {
+        nsByName[b.value("name", "")] = b.value("ns_per_op", 0.0);
+    }
+    return nsByName;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter, jsonPath, baselinePath;
+    bool quick = false, list = false;
+    bench::dataDir() = CRYPTOTRACKER_SOURCE_DIR;
+
+    for (int i = 1; i < argc; ++i) {
+        auto value = [&](const char* flag) -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", flag);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (!std::strcmp(argv[i], "--filter")) filter = value("--filter");
+        else if (!std::strcmp(argv[i], "--json")) jsonPath = value("--json");
+        else if (!std::strcmp(argv[i], "--baseline")) baselinePath = value("--baseline");
+        else if (!std::strcmp(argv[i], "--data")) bench::dataDir() = value("--data");
+        else if (!std::strcmp(argv[i], "--quick")) quick = true;
+        else if (!std::strcmp(argv[i], "--list")) list = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--filter TEXT] [--quick] [--list] [--json FILE] "
+                "[--baseline FILE] [--data DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    auto benchmarks = bench::registry();
+    std::sort(benchmarks.begin(), benchmarks.end(),
+        [](const bench::Benchmark& a, const bench::Benchmark& b) { return a.name < b.name; });
+
+    if (list) {
+        for (const auto& b : benchmarks) std::printf("%s\n", b.name.c_str());
+        return 0;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!baselinePath.empty()) baseline = loadBaseline(baselinePath);
+
+    std::printf("%-44s %12s %12s %12s %14s\n", "benchmark", "mean/op", "p50", "p99", "throughput");
+    std::vector<bench::Result> results;
+    size_t failed = 0;
+    for (const auto& b : benchmarks) {
+        if (!filter.empty() && b.name.find(filter) == std::string::npos) continue;
+
+        bench::Result result;
+        result.name = b.name;
+        bench::State state(result, quick);
+        b.fn(state);
+        printResult(result, baseline);
+        if (!result.failures.empty()) ++failed;
+        results.push_back(std::move(result));
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        out << toJson(results).dump(2) << "\n";
+        if (!out) {
+            std::fprintf(stderr, "cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+    }
+    if (failed) {
+        std::fprintf(stderr, "%zu benchmark(s) failed their checks\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -1,36 +1,395 @@
 ﻿#pragma once
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include "json.hpp"
 #include "CryptoData.h"
+#include "CoinStreamDecoder.h"
+#include "Currency.h"
+#include "FeedCapture.h"
+#include "MarketChart.h"
+#include "Trace.h"
+#include "TrackerMetrics.h"
 
 #pragma warning(push)
 #pragma warning(disable: 4996)
 #include "httplib.h"
 #pragma warning(pop)
 
+#include <atomic>
+#include <chrono>
+#include <ctime>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
+#ifdef _WIN32
 // Link the native Windows Internet library
 #pragma comment(lib, "wininet.lib")
+#endif
 
 using json = nlohmann::json;
 
+// Timing / size figures for one fetch, filled in when the caller asks.
+struct FetchStats {
+    size_t bytesOnWire = 0;       // body bytes as sent (compressed if encoded)
+    size_t bytesReceived = 0;     // body bytes handed to the decoder
+    std::string contentEncoding;  // "gzip", "br", ... or empty
+    double cpuMs = 0.0;           // fetch thread CPU time for the request
+    size_t peakBufferBytes = 0;   // largest single coin object buffered
+    double firstCoinMs = 0.0;     // request start -> first decoded coin
+    double totalMs = 0.0;         // request start -> end of body
+    bool notModified = false;     // HTTP 304: previous snapshot still current
+    bool shared = false;          // answered by RequestBroker from another call's request or its cache
+
+    // Phase split of totalMs (see TrackerMetrics)
+    double dnsMs = 0.0;           // request start -> socket created
+    double connectMs = 0.0;       // socket -> response headers (TCP, TLS, server wait)
+    double transferMs = 0.0;      // headers -> end of body, excluding parseMs
+    double parseMs = 0.0;         // time spent in the decoder
+};
+
+// Running totals for conditional (ETag / Last-Modified) requests.
+struct ConditionalStats {
+    unsigned long long responses = 0;    // 200 + 304 answers
+    unsigned long long notModified = 0;  // 304 answers
+    double cpuSavedMs = 0.0;             // estimated download+decode CPU skipped
+
+    double hitRate() const {
+        return responses ? static_cast<double>(notModified) / responses : 0.0;
+    }
+};
+
+// Serves one recorded response (FeedCapture.h) to APIClient::fetchMarkets or
+// fetchChart in place of an httplib client: same callbacks, body handed over in chunks
+// the size httplib uses, no socket.
+class ReplayClient {
+public:
+    static constexpr size_t CHUNK_BYTES = 16 * 1024;
+
+    explicit ReplayClient(const CapturedResponse& response) : response_(response) {}
+
+    void set_socket_options(httplib::SocketOptions options) { socketOptions_ = std::move(options); }
+
+    template <typename ResponseHandler, typename ContentReceiver, typename Progress>
+    httplib::Result Get(const std::string&, const httplib::Headers&, ResponseHandler onResponse,
+        ContentReceiver onContent, Progress onProgress) {
+        if (socketOptions_) socketOptions_(socket_t{});
+        auto res = std::make_unique<httplib::Response>();
+        res->status = response_.status;
+        size_t line = 0;
+        while (line < response_.headers.size()) {
+            size_t end = response_.headers.find('\n', line);
+            if (end == std::string::npos) end = response_.headers.size();
+            const size_t colon = response_.headers.find(':', line);
+            if (colon < end) {
+                const size_t value = response_.headers.find_first_not_of(' ', colon + 1);
+                res->headers.emplace(response_.headers.substr(line, colon - line),
+                    value < end ? response_.headers.substr(value, end - value) : std::string());
+            }
+            line = end + 1;
+        }
+        if (!onResponse(*res)) return httplib::Result(nullptr, httplib::Error::Canceled);
+
+        const std::string& body = response_.body;
+        for (size_t at = 0; at < body.size(); at += CHUNK_BYTES) {
+            const size_t n = body.size() - at < CHUNK_BYTES ? body.size() - at : CHUNK_BYTES;
+            if (!onContent(body.data() + at, n)) return httplib::Result(nullptr, httplib::Error::Canceled);
+            onProgress(at + n, body.size());
+        }
+        return httplib::Result(std::move(res), httplib::Error::Success);
+    }
+
+private:
+    const CapturedResponse& response_;
+    httplib::SocketOptions socketOptions_;
+};
+
 class APIClient {
 public:
+    // vs_currency is BASE_CURRENCY (Currency.h); other currencies are
+    // derived from the exchange rates instead of fetched.
+    static inline const std::string MARKETS_PATH = [] {
+        std::string path =
+            "/api/v3/coins/markets"
+            "?vs_currency=";
+        path += BASE_CURRENCY;
+        path +=
+            "&order=market_cap_desc"
+            "&per_page=10"
+            "&page=1"
+            "&sparkline=false";
+        return path;
+    }();
+
+    static constexpr const char* EXCHANGE_RATES_PATH = "/api/v3/exchange_rates";
+
+    // Market rows for an explicit set of CoinGecko ids (e.g. "bitcoin").
+    static std::string idsPath(const std::vector<std::string>& ids) {
+        std::string path =
+            "/api/v3/coins/markets"
+            "?vs_currency=";
+        path += BASE_CURRENCY;
+        path += "&ids=";
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (i > 0) path += "%2C";   // URL-encoded ','
+            path += ids[i];
+        }
+        path += "&sparkline=false";
+        return path;
+    }
+
+    // Price series of one coin over the last day (5-minute points), for
+    // backfilling its history graph.
+    static std::string marketChartPath(const std::string& id) {
+        std::string path = "/api/v3/coins/" + id + "/market_chart?vs_currency=";
+        path += BASE_CURRENCY;
+        path += "&days=1";
+        return path;
+    }
+
+    // The coin id of a marketChartPath(), or an empty string for any other path.
+    static std::string marketChartId(const std::string& path) {
+        static const std::string prefix = "/api/v3/coins/";
+        static const std::string suffix = "/market_chart?";
+        if (path.compare(0, prefix.size(), prefix) != 0) return std::string();
+        const size_t end = path.find(suffix, prefix.size());
+        if (end == std::string::npos || end == prefix.size()) return std::string();
+        return path.substr(prefix.size(), end - prefix.size());
+    }
+
+    // ---------------------------------------------------------------------
+    // Encodings we can decode, depending on how httplib was built
+    // (CPPHTTPLIB_BROTLI_SUPPORT / CPPHTTPLIB_ZLIB_SUPPORT). httplib only
+    // adds this header by itself when it buffers the body, so the streaming
+    // path has to send it explicitly. Decompression then happens chunk by
+    // chunk inside httplib before the data reaches our content receiver.
+    // ---------------------------------------------------------------------
+    static std::string acceptEncoding() {
+        std::string encodings;
+#ifdef CPPHTTPLIB_BROTLI_SUPPORT
+        encodings = "br";
+#endif
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+        if (!encodings.empty()) encodings += ", ";
+        encodings += "gzip, deflate";
+#endif
+        return encodings;
+    }
+
     // ---------------------------------------------------------------------
     // Main function used by your app: fetches top coins from CoinGecko
     // using HTTPLIB SSL
     // ---------------------------------------------------------------------
-    static std::vector<CryptoCoin> fetchTopCoins(std::string& statusMsg) {
+    static std::vector<CryptoCoin> fetchTopCoins(std::string& statusMsg,
+        FetchStats* stats = nullptr) {
+        return fetchFromCoinGecko(MARKETS_PATH, statusMsg, stats);
+    }
+
+    // Any /coins/markets path (MARKETS_PATH, idsPath), for RequestBroker.
+    static std::vector<CryptoCoin> fetchPath(const std::string& path, std::string& statusMsg,
+        FetchStats* stats = nullptr) {
+        return fetchFromCoinGecko(path, statusMsg, stats);
+    }
+
+    // ---------------------------------------------------------------------
+    // Targeted refresh of a few coins via the ids= filter (favorites lane).
+    // ---------------------------------------------------------------------
+    static std::vector<CryptoCoin> fetchCoinsByIds(const std::vector<std::string>& ids,
+        std::string& statusMsg, FetchStats* stats = nullptr) {
+        return fetchFromCoinGecko(idsPath(ids), statusMsg, stats);
+    }
+
+    // ---------------------------------------------------------------------
+    // One coin's last-day price series (marketChartPath), decoded into
+    // `points` oldest first. Returns false and sets statusMsg on error.
+    // ---------------------------------------------------------------------
+    static bool fetchMarketChart(const std::string& id, std::vector<HistoryPoint>& points,
+        std::string& statusMsg) {
+        try {
+            httplib::SSLClient cli("api.coingecko.com");
+            cli.enable_server_certificate_verification(false);
+            cli.set_connection_timeout(5);
+            cli.set_read_timeout(5, 0);
+            return fetchChart(cli, marketChartPath(id), "[HTTPLIB SSL]", points, statusMsg);
+        }
+        catch (const std::exception& e) {
+            statusMsg = std::string("[HTTPLIB SSL EXCEPTION] ") + e.what();
+            return false;
+        }
+    }
+
+    // Same over plain HTTP against any host (a local mock server).
+    static bool fetchMarketChartFromHost(const std::string& host, int port, const std::string& id,
+        std::vector<HistoryPoint>& points, std::string& statusMsg) {
+        try {
+            httplib::Client cli(host, port);
+            cli.set_connection_timeout(5);
+            cli.set_read_timeout(5, 0);
+            return fetchChart(cli, marketChartPath(id), "[HTTPLIB]", points, statusMsg);
+        }
+        catch (const std::exception& e) {
+            statusMsg = std::string("[HTTPLIB EXCEPTION] ") + e.what();
+            return false;
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // BTC exchange rates for every currency CoinGecko knows (one small
+    // request, buffered; no ETag). Returns false and sets statusMsg on error,
+    // leaving `rates` unchanged.
+    // ---------------------------------------------------------------------
+    static bool fetchExchangeRates(ExchangeRates& rates, std::string& statusMsg) {
+        try {
+            httplib::SSLClient cli("api.coingecko.com");
+            cli.enable_server_certificate_verification(false);
+            cli.set_connection_timeout(5);
+            cli.set_read_timeout(5, 0);
+
+            const auto started = std::chrono::steady_clock::now();
+            auto res = cli.Get(EXCHANGE_RATES_PATH);
+            if (res) {
+                if (CaptureWriter* recorder = recorderSlot().get()) {
+                    CapturedResponse captured;
+                    captured.offsetNs = recorder->offsetOf(started);
+                    captured.durationUs = elapsedUs(started);
+                    captured.status = res->status;
+                    captured.path = EXCHANGE_RATES_PATH;
+                    captured.headers = formatHeaders(res->headers);
+                    captured.body = res->body;
+                    recorder->append(captured);
+                }
+            }
+            if (!res) {
+                statusMsg = "[HTTPLIB SSL] Exchange rates: " + httplib::to_string(res.error());
+                return false;
+            }
+            if (res->status != 200) {
+                statusMsg = "[HTTPLIB SSL] Exchange rates: HTTP " + std::to_string(res->status);
+                return false;
+            }
+            return rates.parse(res->body, statusMsg);
+        }
+        catch (const std::exception& e) {
+            statusMsg = std::string("[HTTPLIB SSL EXCEPTION] ") + e.what();
+            return false;
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // Same request over plain HTTP against any host, e.g. a local mock
+    // server used to measure the fetch path without touching CoinGecko.
+    // ---------------------------------------------------------------------
+    static std::vector<CryptoCoin> fetchFromHost(const std::string& host, int port,
+        const std::string& path, std::string& statusMsg, FetchStats* stats = nullptr) {
+        std::vector<CryptoCoin> coins;
+
+        try {
+            httplib::Client cli(host, port);
+            cli.set_connection_timeout(5);
+            cli.set_read_timeout(5, 0);
+
+            FetchOutcome outcome = fetchMarkets(cli, host + ":" + std::to_string(port),
+                path, "[HTTPLIB]", coins, statusMsg, stats);
+            if (outcome == FetchOutcome::Failed) {
+                coins.clear();
+                return coins;
+            }
+
+            if (outcome == FetchOutcome::Updated) {
+                statusMsg = "Live Data: Connected via httplib (" + host + ")";
+            }
+        }
+        catch (const std::exception& e) {
+            coins.clear();
+            statusMsg = std::string("[HTTPLIB EXCEPTION] ") + e.what();
+        }
+        return coins;
+    }
+
+    // ---------------------------------------------------------------------
+    // Runs a recorded response through the same decode, metrics and
+    // validator path as a live fetch. Returns the coins, or an empty list
+    // with statusMsg set, as fetchTopCoins does.
+    // ---------------------------------------------------------------------
+    static std::vector<CryptoCoin> replayMarkets(const CapturedResponse& response,
+        std::string& statusMsg, FetchStats* stats = nullptr) {
+        std::vector<CryptoCoin> coins;
+        ReplayClient cli(response);
+        FetchOutcome outcome = fetchMarkets(cli, "replay", response.path, "[REPLAY]", coins, statusMsg, stats);
+        if (outcome == FetchOutcome::Failed) coins.clear();
+        return coins;
+    }
+
+    // A recorded market_chart response, decoded as fetchMarketChart does.
+    static bool replayMarketChart(const CapturedResponse& response, std::vector<HistoryPoint>& points,
+        std::string& statusMsg) {
+        ReplayClient cli(response);
+        return fetchChart(cli, response.path, "[REPLAY]", points, statusMsg);
+    }
+
+    // From now on every response is also appended to `recorder`
+    // (FeedCapture.h); null stops recording. Set before the fetch threads
+    // start or after they stop.
+    static void setRecorder(std::shared_ptr<CaptureWriter> recorder) {
+        recorderSlot() = std::move(recorder);
+    }
+
+    // Optional columns decoded from now on (the required ones always are).
+    // Unused fields are skipped by the decoder instead of converted. A
+    // change drops the validators: a 304 would keep the rows we hold,
+    // which were decoded with the old set.
+    static void setDecodedFields(CoinFieldSet fields) {
+        if (decodedFieldBits().exchange(fields.bits(), std::memory_order_relaxed) != fields.bits()) {
+            clearValidators();
+        }
+    }
+
+    static CoinFieldSet decodedFields() {
+        return CoinFieldSet::fromBits(decodedFieldBits().load(std::memory_order_relaxed));
+    }
+
+    static ConditionalStats conditionalStats() {
+        ValidatorCache& cache = validatorCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return cache.stats;
+    }
+
+    // Forget all remembered validators (next request is unconditional).
+    static void clearValidators() {
+        ValidatorCache& cache = validatorCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.byUrl.clear();
+    }
+
+    // Forget the validators of one path on any origin: its body was not
+    // the one the app applied (another provider's reply won), so a 304
+    // would not refer to data we hold.
+    static void forgetValidators(const std::string& path) {
+        ValidatorCache& cache = validatorCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        for (auto it = cache.byUrl.begin(); it != cache.byUrl.end();) {
+            const std::string& url = it->first;
+            const bool same = url.size() >= path.size() && url.compare(url.size() - path.size(), path.size(), path) == 0;
+            it = same ? cache.byUrl.erase(it) : std::next(it);
+        }
+    }
+
+private:
+    enum class FetchOutcome { Failed, Updated, NotModified };
+
+    // HTTPS request against api.coingecko.com (requires CPPHTTPLIB_OPENSSL_SUPPORT)
+    static std::vector<CryptoCoin> fetchFromCoinGecko(const std::string& path,
+        std::string& statusMsg, FetchStats* stats) {
         std::vector<CryptoCoin> coins;
 
         try {
             statusMsg = "Connecting via httplib SSL (CoinGecko)...";
 
-            // HTTPS client for CoinGecko (requires CPPHTTPLIB_OPENSSL_SUPPORT)
             httplib::SSLClient cli("api.coingecko.com");
 
             // For a course project it's OK to disable verification.
@@ -40,78 +399,367 @@ public:
             cli.set_connection_timeout(5);   // 5 seconds to connect
             cli.set_read_timeout(5, 0);      // 5 seconds to read
 
-            const char* path =
-                "/api/v3/coins/markets"
-                "?vs_currency=usd"
-                "&order=market_cap_desc"
-                "&per_page=10"
-                "&page=1"
-                "&sparkline=false";
-
-            auto res = cli.Get(path);
-
-            // ---------- basic response checks ----------
-            if (!res) {
-                statusMsg = "[HTTPLIB SSL] No response from CoinGecko.";
+            FetchOutcome outcome = fetchMarkets(cli, "api.coingecko.com", path,
+                "[HTTPLIB SSL]", coins, statusMsg, stats);
+            if (outcome == FetchOutcome::Failed) {
+                coins.clear();
                 return coins;
             }
 
-            if (res->status != 200) {
-                if (res->status == 429) {
-                    statusMsg = "API limit reached (HTTP 429). Using last data, will retry...";
-                    return coins; 
-                }
-
-                statusMsg = "[HTTPLIB SSL] HTTP " + std::to_string(res->status) +
-                    " from CoinGecko.";
-                return coins;
+            if (outcome == FetchOutcome::Updated) {
+                statusMsg =
+                    "Live Data: Connected via httplib (CoinGecko HTTPS)";
             }
+        }
+        catch (const std::exception& e) {
+            coins.clear();
+            statusMsg = std::string("[HTTPLIB SSL EXCEPTION] ") + e.what();
+        }
+        catch (...) {
+            coins.clear();
+            statusMsg = "[HTTPLIB SSL EXCEPTION] Unknown error.";
+        }
+        return coins;
+    }
 
-            if (res->body.empty()) {
-                statusMsg = "[HTTPLIB SSL] Empty body from CoinGecko.";
-                return coins;
+    // ---------------------------------------------------------------------
+    // ETag / Last-Modified validators remembered per request URL. They are
+    // only stored after a body decoded cleanly, so a 304 always refers to
+    // data we actually hold.
+    // ---------------------------------------------------------------------
+    struct Validators {
+        std::string etag;
+        std::string lastModified;
+    };
+
+    struct ValidatorCache {
+        std::mutex mutex;
+        std::unordered_map<std::string, Validators> byUrl;
+        ConditionalStats stats;
+        double avgFullCpuMs = 0.0;   // smoothed CPU cost of a 200 + decode
+    };
+
+    static std::shared_ptr<CaptureWriter>& recorderSlot() {
+        static std::shared_ptr<CaptureWriter> recorder;
+        return recorder;
+    }
+
+    static std::string formatHeaders(const httplib::Headers& headers) {
+        std::string text;
+        for (const auto& header : headers) {
+            text += header.first;
+            text += ": ";
+            text += header.second;
+            text += '\n';
+        }
+        return text;
+    }
+
+    static std::uint32_t elapsedUs(std::chrono::steady_clock::time_point since) {
+        return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - since).count());
+    }
+
+    static std::atomic<std::uint32_t>& decodedFieldBits() {
+        static std::atomic<std::uint32_t> bits{ CoinFieldSet::defaults().bits() };
+        return bits;
+    }
+
+    static ValidatorCache& validatorCache() {
+        static ValidatorCache cache;
+        return cache;
+    }
+
+    static void recordConditional(bool notModified, double cpuMs) {
+        ValidatorCache& cache = validatorCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+
+        ++cache.stats.responses;
+        if (notModified) {
+            ++cache.stats.notModified;
+            if (cache.avgFullCpuMs > cpuMs) {
+                cache.stats.cpuSavedMs += cache.avgFullCpuMs - cpuMs;
             }
-            // ---------- parse JSON ----------
-            json result = json::parse(res->body);
+        }
+        else if (cache.avgFullCpuMs == 0.0) {
+            cache.avgFullCpuMs = cpuMs;
+        }
+        else {
+            cache.avgFullCpuMs = 0.8 * cache.avgFullCpuMs + 0.2 * cpuMs;
+        }
+    }
 
-            if (!result.is_array()) {
-                statusMsg = "[HTTPLIB SSL] API did not return a list.";
-                return coins;
+    // CPU time consumed by the calling thread, in milliseconds.
+    static double threadCpuMs() {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) {
+            return 0.0;
+        }
+        auto ticks = [](const FILETIME& ft) {
+            return (static_cast<unsigned long long>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+        };
+        return (ticks(kernel) + ticks(user)) / 10000.0;   // 100ns units
+#else
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+    }
+
+    static double toMs(std::chrono::steady_clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    static void recordPhases(FetchStats& st, std::chrono::steady_clock::time_point started,
+        std::chrono::steady_clock::time_point socketAt, std::chrono::steady_clock::time_point headersAt,
+        std::chrono::steady_clock::time_point finished, std::chrono::steady_clock::duration parseTime) {
+        if (headersAt == started) return;   // never got a response: nothing to split
+
+        TrackerMetrics& m = trackerMetrics();
+        auto transfer = (finished - headersAt) - parseTime;
+        if (transfer.count() < 0) transfer = {};
+
+        st.dnsMs = toMs(socketAt - started);
+        st.connectMs = toMs(headersAt - socketAt);
+        st.transferMs = toMs(transfer);
+        st.parseMs = toMs(parseTime);
+
+        m.fetchDns.record(socketAt - started);
+        m.fetchConnect.record(headersAt - socketAt);
+        m.fetchTransfer.record(transfer);
+        m.fetchParse.record(parseTime);
+    }
+
+    static void recordOutcome(const FetchStats& st, FetchOutcome outcome) {
+        TrackerMetrics& m = trackerMetrics();
+        switch (outcome) {
+        case FetchOutcome::Updated: m.fetchUpdated.add(); break;
+        case FetchOutcome::NotModified: m.fetchNotModified.add(); break;
+        default: m.fetchFailed.add(); break;
+        }
+        m.bytesOnWire.add(st.bytesOnWire);
+        m.bytesDecoded.add(st.bytesReceived);
+    }
+
+    // ---------------------------------------------------------------------
+    // Streams the body straight into CoinStreamDecoder: each chunk from the
+    // content receiver is decoded as it arrives, so there is no full copy
+    // of the response in res->body and parsing overlaps the download.
+    // ---------------------------------------------------------------------
+    template <typename Client>
+    static FetchOutcome fetchMarkets(Client& cli, const std::string& origin, const std::string& path,
+        const std::string& tag, std::vector<CryptoCoin>& coins, std::string& statusMsg,
+        FetchStats* stats) {
+        CT_TRACE_SCOPE("fetch", "http request");
+        using Clock = std::chrono::steady_clock;
+        const auto started = Clock::now();
+        auto elapsedMs = [&started]() {
+            return std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        };
+
+        const double cpuStarted = threadCpuMs();
+
+        FetchStats local;
+        FetchStats& st = stats ? *stats : local;
+        st = FetchStats{};
+
+        httplib::Headers headers;
+        const std::string encodings = acceptEncoding();
+        if (!encodings.empty()) {
+            headers.emplace("Accept-Encoding", encodings);
+        }
+
+        const std::string url = origin + path;
+        {
+            ValidatorCache& cache = validatorCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto it = cache.byUrl.find(url);
+            if (it != cache.byUrl.end()) {
+                if (!it->second.etag.empty())
+                    headers.emplace("If-None-Match", it->second.etag);
+                if (!it->second.lastModified.empty())
+                    headers.emplace("If-Modified-Since", it->second.lastModified);
             }
-            for (auto& item : result) {
-                CryptoCoin coin;
-
-                // Required fields
-                coin.id = item["id"].get<std::string>();
-                coin.symbol = item["symbol"].get<std::string>();
-                coin.name = item["name"].get<std::string>();
-                coin.current_price = item["current_price"].get<double>();
-
-                // Optional fields
-                if (item.contains("price_change_percentage_24h") &&
-                    !item["price_change_percentage_24h"].is_null()) {
-                    coin.price_change_24h =
-                        item["price_change_percentage_24h"].get<double>();
-                }
+        }
+        Validators received;
 
-                if (item.contains("market_cap") &&
-                    !item["market_cap"].is_null()) {
-                    coin.market_cap = item["market_cap"].get<double>();
-                }
+        // Phase timestamps. httplib calls the socket-options hook right after
+        // the name lookup and before connect(); on a retried connection the
+        // last call wins.
+        Clock::time_point socketAt = started;
+        Clock::time_point headersAt = started;
+        Clock::duration parseTime{};
+        cli.set_socket_options([&socketAt](socket_t) { socketAt = Clock::now(); });
+
+        // Recording keeps a copy of the body as the decoder sees it
+        CaptureWriter* recorder = recorderSlot().get();
+        CapturedResponse captured;
+
+        CoinStreamDecoder decoder([&](CryptoCoin&& coin) {
+            if (coins.empty()) st.firstCoinMs = elapsedMs();
+            coins.push_back(std::move(coin));
+        }, decodedFields());
+
+        int status = 0;
+        auto res = cli.Get(path, headers,
+            [&](const httplib::Response& response) {
+                status = response.status;
+                headersAt = Clock::now();
+                st.contentEncoding = response.get_header_value("Content-Encoding");
+                received.etag = response.get_header_value("ETag");
+                received.lastModified = response.get_header_value("Last-Modified");
+                if (recorder) captured.headers = formatHeaders(response.headers);
+                return status == 200 || status == 304;   // don't download error bodies
+            },
+            [&](const char* data, size_t len) {
+                st.bytesReceived += len;
+                if (recorder) captured.body.append(data, len);
+                CT_TRACE_SCOPE("fetch", "decode chunk");
+                const auto feedStarted = Clock::now();
+                bool ok = decoder.feed(data, len);
+                parseTime += Clock::now() - feedStarted;
+                return ok;
+            },
+            [&](size_t current, size_t) {
+                // Raw (still encoded) bytes; only reported for Content-Length bodies
+                st.bytesOnWire = current;
+                return true;
+            });
+
+        st.totalMs = elapsedMs();
+        st.cpuMs = threadCpuMs() - cpuStarted;
+        if (st.bytesOnWire == 0 && st.contentEncoding.empty()) {
+            st.bytesOnWire = st.bytesReceived;
+        }
+        st.peakBufferBytes = decoder.peakBufferBytes();
+        cli.set_socket_options(nullptr);
+        if (recorder && status != 0) {
+            captured.offsetNs = recorder->offsetOf(started);
+            captured.durationUs = elapsedUs(started);
+            captured.status = status;
+            captured.path = path;
+            recorder->append(captured);
+        }
+
+        // finish() only flushes the decoder state; it is folded into parse
+        const auto finishStarted = Clock::now();
+        const bool decoded = status == 200 && res && decoder.finish();
+        parseTime += Clock::now() - finishStarted;
+        const auto finished = Clock::now();
+        recordPhases(st, started, socketAt, headersAt, finished, parseTime);
+        if (headersAt != started) {
+            CT_TRACE_COMPLETE("fetch", "dns", started, socketAt);
+            CT_TRACE_COMPLETE("fetch", "connect+tls+wait", socketAt, headersAt);
+            CT_TRACE_COMPLETE("fetch", "body", headersAt, finished);
+        }
+        FetchOutcome outcome = FetchOutcome::Failed;
+        if (status == 304) outcome = FetchOutcome::NotModified;
+        else if (decoded) outcome = FetchOutcome::Updated;
+        recordOutcome(st, outcome);
 
-                coins.push_back(coin);
+        // ---------- basic response checks ----------
+        if (status == 0) {
+            statusMsg = tag + " No response from CoinGecko.";
+            return FetchOutcome::Failed;
+        }
+
+        if (status == 304) {
+            // Upstream cache unchanged: nothing to decode or publish
+            st.notModified = true;
+            recordConditional(true, st.cpuMs);
+            statusMsg = "Live Data: unchanged since last refresh (HTTP 304)";
+            return FetchOutcome::NotModified;
+        }
+
+        if (status != 200) {
+            if (status == 429) {
+                statusMsg = "API limit reached (HTTP 429). Using last data, will retry...";
+                return FetchOutcome::Failed;
             }
 
-            statusMsg =
-                "Live Data: Connected via httplib (CoinGecko HTTPS)";
+            statusMsg = tag + " HTTP " + std::to_string(status) +
+                " from CoinGecko.";
+            return FetchOutcome::Failed;
         }
-        catch (const std::exception& e) {
-            statusMsg = std::string("[HTTPLIB SSL EXCEPTION] ") + e.what();
+
+        if (!res && decoder.error().empty()) {
+            statusMsg = tag + " Connection dropped: " + httplib::to_string(res.error());
+            return FetchOutcome::Failed;
         }
-        catch (...) {
-            statusMsg = "[HTTPLIB SSL EXCEPTION] Unknown error.";
+
+        if (!decoded) {
+            statusMsg = tag + " " + decoder.error();
+            return FetchOutcome::Failed;
         }
-        return coins;
+
+        recordConditional(false, st.cpuMs);
+        if (!received.etag.empty() || !received.lastModified.empty()) {
+            ValidatorCache& cache = validatorCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            cache.byUrl[url] = std::move(received);
+        }
+        return FetchOutcome::Updated;
     }
 
+    // ---------------------------------------------------------------------
+    // market_chart, streamed into MarketChartDecoder the same way. A chart
+    // is fetched once per selection, so no validators and no phase split.
+    // ---------------------------------------------------------------------
+    template <typename Client>
+    static bool fetchChart(Client& cli, const std::string& path, const std::string& tag,
+        std::vector<HistoryPoint>& points, std::string& statusMsg) {
+        CT_TRACE_SCOPE("fetch", "market chart");
+        const auto started = std::chrono::steady_clock::now();
+        httplib::Headers headers;
+        const std::string encodings = acceptEncoding();
+        if (!encodings.empty()) {
+            headers.emplace("Accept-Encoding", encodings);
+        }
+
+        CaptureWriter* recorder = recorderSlot().get();
+        CapturedResponse captured;
+        points.clear();
+        MarketChartDecoder decoder(points);
+
+        int status = 0;
+        auto res = cli.Get(path, headers,
+            [&](const httplib::Response& response) {
+                status = response.status;
+                if (recorder) captured.headers = formatHeaders(response.headers);
+                return status == 200;
+            },
+            [&](const char* data, size_t len) {
+                if (recorder) captured.body.append(data, len);
+                return decoder.feed(data, len);
+            },
+            [](size_t, size_t) { return true; });
+
+        if (recorder && status != 0) {
+            captured.offsetNs = recorder->offsetOf(started);
+            captured.durationUs = elapsedUs(started);
+            captured.status = status;
+            captured.path = path;
+            recorder->append(captured);
+        }
+
+        if (status == 0) {
+            statusMsg = tag + " No response from CoinGecko.";
+            return false;
+        }
+        if (status != 200) {
+            statusMsg = status == 429 ? "API limit reached (HTTP 429). Using last data, will retry..."
+                : tag + " HTTP " + std::to_string(status) + " from CoinGecko.";
+            return false;
+        }
+        if (!res && decoder.error().empty()) {
+            statusMsg = tag + " Connection dropped: " + httplib::to_string(res.error());
+            return false;
+        }
+        if (!decoder.finish()) {
+            statusMsg = tag + " " + decoder.error();
+            return false;
+        }
+        return true;
+    }
 };
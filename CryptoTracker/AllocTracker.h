@@ -0,0 +1,175 @@
+#pragma once
+
+// -------------------------------------------------------------------------
+// Opt-in heap allocation tracking.
+//
+// Build with CRYPTOTRACKER_ALLOC_TRACKING=1 and expand
+// CT_ALLOCATION_HOOKS() once, at namespace scope, in one translation unit:
+// the global operator new / operator delete then bump plain per-thread
+// counters (no atomics, no locks). An alloc::Scope reads the calling
+// thread's counters at construction and reports what that thread allocated
+// since; ScopeStats accumulates those reports per named phase (refresh,
+// frame, ...) for the debug overlay and /metrics.
+//
+// Libraries with their own allocator hooks (ImGui) are routed through
+// countedMalloc / countedFree so they show up in the same counters.
+//
+// With tracking off (the default) the hooks expand to nothing and every
+// Scope reports zero.
+// -------------------------------------------------------------------------
+
+#ifndef CRYPTOTRACKER_ALLOC_TRACKING
+#define CRYPTOTRACKER_ALLOC_TRACKING 0
+#endif
+
+#include "Metrics.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace alloc {
+
+struct Counts {
+    std::uint64_t allocations = 0;
+    std::uint64_t frees = 0;
+    std::uint64_t bytes = 0;   // requested bytes allocated (frees are not sized)
+
+    Counts operator-(const Counts& other) const {
+        return { allocations - other.allocations, frees - other.frees, bytes - other.bytes };
+    }
+};
+
+namespace detail {
+// Trivially initialised, so touching it from operator new never allocates.
+inline thread_local Counts threadCounts;
+}
+
+constexpr bool enabled() { return CRYPTOTRACKER_ALLOC_TRACKING != 0; }
+
+// Everything the calling thread has allocated since it started.
+inline Counts threadCounts() { return detail::threadCounts; }
+
+// malloc / free that count like operator new / delete. The unused pointer
+// matches ImGui::SetAllocatorFunctions' user-data argument.
+inline void* countedMalloc(std::size_t size, void* = nullptr) {
+    ++detail::threadCounts.allocations;
+    detail::threadCounts.bytes += size;
+    return std::malloc(size);
+}
+
+inline void countedFree(void* p, void* = nullptr) {
+    if (p) ++detail::threadCounts.frees;
+    std::free(p);
+}
+
+// What the calling thread allocates between construction and delta().
+class Scope {
+public:
+    Scope() : start_(threadCounts()) {}
+    Counts delta() const { return threadCounts() - start_; }
+
+private:
+    Counts start_;
+};
+
+// Totals and the most recent cycle of one named phase. record() is called
+// by the thread that ran the phase; readers may be anywhere.
+class ScopeStats {
+public:
+    void record(const Counts& c) {
+        cycles_.add();
+        allocations_.add(c.allocations);
+        bytes_.add(c.bytes);
+        lastAllocations_.store(c.allocations, std::memory_order_relaxed);
+        lastBytes_.store(c.bytes, std::memory_order_relaxed);
+        std::uint64_t peak = peakAllocations_.load(std::memory_order_relaxed);
+        while (c.allocations > peak &&
+            !peakAllocations_.compare_exchange_weak(peak, c.allocations, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::uint64_t cycles() const { return cycles_.value(); }
+    std::uint64_t allocations() const { return allocations_.value(); }
+    std::uint64_t bytes() const { return bytes_.value(); }
+    std::uint64_t lastAllocations() const { return lastAllocations_.load(std::memory_order_relaxed); }
+    std::uint64_t lastBytes() const { return lastBytes_.load(std::memory_order_relaxed); }
+    std::uint64_t peakAllocations() const { return peakAllocations_.load(std::memory_order_relaxed); }
+
+    double allocationsPerCycle() const {
+        std::uint64_t n = cycles();
+        return n ? static_cast<double>(allocations()) / n : 0.0;
+    }
+
+    // Exposes the totals as counters labelled scope="<scope>".
+    void registerMetrics(metrics::Registry& r, const char* scope) {
+        const std::string label = std::string("scope=\"") + scope + "\"";
+        r.add("cryptotracker_scope_cycles_total", "Completed cycles of each allocation-tracked phase.", label, cycles_);
+        r.add("cryptotracker_allocations_total", "Heap allocations made inside each tracked phase.", label, allocations_);
+        r.add("cryptotracker_allocated_bytes_total", "Heap bytes requested inside each tracked phase.", label, bytes_);
+    }
+
+private:
+    metrics::Counter cycles_;
+    metrics::Counter allocations_;
+    metrics::Counter bytes_;
+    std::atomic<std::uint64_t> lastAllocations_{ 0 };
+    std::atomic<std::uint64_t> lastBytes_{ 0 };
+    std::atomic<std::uint64_t> peakAllocations_{ 0 };
+};
+
+// Records the calling thread's allocations into `stats` when it goes out
+// of scope.
+class ScopedRecord {
+public:
+    explicit ScopedRecord(ScopeStats& stats) : stats_(stats) {}
+    ~ScopedRecord() { stats_.record(scope_.delta()); }
+
+    ScopedRecord(const ScopedRecord&) = delete;
+    ScopedRecord& operator=(const ScopedRecord&) = delete;
+
+private:
+    ScopeStats& stats_;
+    Scope scope_;
+};
+
+} // namespace alloc
+
+namespace alloc {
+namespace detail {
+
+inline void* countedNew(std::size_t size) {
+    ++threadCounts.allocations;
+    threadCounts.bytes += size;
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+inline void countedDelete(void* p) noexcept {
+    if (p) ++threadCounts.frees;
+    std::free(p);
+}
+
+} // namespace detail
+} // namespace alloc
+
+// Plain, array and sized forms are all replaced so every new is paired with
+// a delete that goes through the same counters; the nothrow forms forward
+// to these by default. Aligned (align_val_t) allocations are not counted.
+#if CRYPTOTRACKER_ALLOC_TRACKING
+#define CT_ALLOCATION_HOOKS()                                                                   \
+    void* operator new(std::size_t size) { return ::alloc::detail::countedNew(size); }         \
+    void* operator new[](std::size_t size) { return ::alloc::detail::countedNew(size); }       \
+    void operator delete(void* p) noexcept { ::alloc::detail::countedDelete(p); }              \
+    void operator delete[](void* p) noexcept { ::alloc::detail::countedDelete(p); }            \
+    void operator delete(void* p, std::size_t) noexcept { ::alloc::detail::countedDelete(p); } \
+    void operator delete[](void* p, std::size_t) noexcept { ::alloc::detail::countedDelete(p); }
+#else
+#define CT_ALLOCATION_HOOKS()
+#endif
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>        // _commit
+#else
+#include <unistd.h>    // fsync
+#endif
+
+// -------------------------------------------------------------------------
+// Whole-file reads and crash-safe whole-file replacement for the files
+// under data/. Errors are thrown as std::filesystem::filesystem_error.
+//
+// A file is replaced, never rewritten in place: the new content goes to
+// <path>.tmp, is flushed to disk, then renamed over the old file, so a
+// crash at any point leaves either the old or the new content.
+// -------------------------------------------------------------------------
+
+inline std::FILE* OpenFile(const std::filesystem::path& path, bool write) {
+    std::FILE* file = nullptr;
+#ifdef _WIN32
+    if (_wfopen_s(&file, path.c_str(), write ? L"wb" : L"rb") != 0) file = nullptr;
+#else
+    file = std::fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+    return file;
+}
+
+// Reads all of `path` into `content` (one pass). Returns false if the file
+// does not exist.
+inline bool ReadWholeFile(const std::filesystem::path& path, std::string& content) {
+    std::FILE* file = OpenFile(path, false);
+    if (!file) {
+        if (errno == ENOENT) return false;
+        throw std::filesystem::filesystem_error("cannot read", path,
+            std::error_code(errno, std::generic_category()));
+    }
+
+    content.clear();
+    char buffer[16 * 1024];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) content.append(buffer, n);
+    std::fclose(file);
+    return true;
+}
+
+// Replaces `path` with `content`, creating its directory if needed.
+inline void WriteFileAtomically(const std::filesystem::path& path, const std::string& content) {
+    if (path.has_parent_path() && !std::filesystem::exists(path.parent_path())) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+
+    std::FILE* file = OpenFile(temp, true);
+    if (!file) {
+        throw std::filesystem::filesystem_error("cannot write", temp,
+            std::error_code(errno, std::generic_category()));
+    }
+    bool ok = std::fwrite(content.data(), 1, content.size(), file) == content.size() && std::fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    const int error = errno;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::error_code ignored;
+        std::filesystem::remove(temp, ignored);
+        throw std::filesystem::filesystem_error("cannot write", temp,
+            std::error_code(error, std::generic_category()));
+    }
+
+    std::filesystem::rename(temp, path);   // replaces the old file in one step
+}
+
+// -------------------------------------------------------------------------
+// Background writer for one file under data/ (favorites, portfolios).
+//
+// requestSave() only flags the data as dirty and wakes the writer thread,
+// so a UI action never waits on the disk. The writer lets a burst of
+// changes settle (`debounce` without a new request, but no longer than
+// `maxDelay` in total), then takes the current file content from `content`
+// (which locks whatever guards the data) and writes it with
+// WriteFileAtomically. stop() writes anything still pending before
+// returning.
+// -------------------------------------------------------------------------
+class DebouncedFileWriter {
+public:
+    using Content = std::function<std::string()>;
+    using ErrorHandler = std::function<void(const std::string& message)>;
+
+    DebouncedFileWriter(std::filesystem::path path, Content content,
+        std::chrono::milliseconds debounce = std::chrono::milliseconds(250),
+        std::chrono::milliseconds maxDelay = std::chrono::seconds(2))
+        : path_(std::move(path)), content_(std::move(content)), debounce_(debounce), maxDelay_(maxDelay) {}
+
+    ~DebouncedFileWriter() { stop(); }
+
+    DebouncedFileWriter(const DebouncedFileWriter&) = delete;
+    DebouncedFileWriter& operator=(const DebouncedFileWriter&) = delete;
+
+    // Called on the writer thread when a write fails.
+    void setErrorHandler(ErrorHandler handler) { onError_ = std::move(handler); }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (thread_.joinable()) return;
+        stopping_ = false;
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void requestSave() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++requested_;
+        }
+        wake_.notify_all();
+    }
+
+    // Blocks until every request made so far is on disk (or failed), or the
+    // writer is not running.
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const unsigned long long target = requested_;
+        flushing_ = true;
+        wake_.notify_all();
+        written_.wait(lock, [&] { return saved_ >= target || !running_; });
+        flushing_ = false;
+    }
+
+    unsigned long long requests() const { std::lock_guard<std::mutex> lock(mutex_); return requested_; }
+    unsigned long long writes() const { std::lock_guard<std::mutex> lock(mutex_); return writes_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stopping_ || requested_ > saved_; });
+            if (requested_ == saved_) {   // stopping with nothing pending
+                running_ = false;
+                written_.notify_all();
+                return;
+            }
+
+            // Let the burst settle
+            const Clock::time_point first = Clock::now();
+            unsigned long long seen = requested_;
+            while (!stopping_ && !flushing_) {
+                const Clock::time_point deadline = std::min(Clock::now() + debounce_, first + maxDelay_);
+                wake_.wait_until(lock, deadline, [&] { return stopping_ || flushing_ || requested_ != seen; });
+                if (requested_ == seen || Clock::now() >= first + maxDelay_) break;
+                seen = requested_;
+            }
+
+            const unsigned long long target = requested_;
+            lock.unlock();
+            std::string error;
+            try {
+                WriteFileAtomically(path_, content_());
+            }
+            catch (const std::exception& e) {
+                error = e.what();
+            }
+            if (!error.empty() && onError_) onError_(error);
+            lock.lock();
+
+            saved_ = target;
+            if (error.empty()) ++writes_;
+            written_.notify_all();
+        }
+    }
+
+    const std::filesystem::path path_;
+    const Content content_;
+    const std::chrono::milliseconds debounce_;
+    const std::chrono::milliseconds maxDelay_;
+    ErrorHandler onError_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_;
+    std::thread thread_;
+    bool stopping_ = false;
+    bool running_ = false;
+    bool flushing_ = false;
+    unsigned long long requested_ = 0;   // requestSave() calls so far
+    unsigned long long saved_ = 0;       // requests covered by the last write attempt
+    unsigned long long writes_ = 0;      // successful writes
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "CoinStreamDecoder.h"
+#include "Utf16.h"
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Loads saved /coins/markets responses ("captures") through the same
+// CoinStreamDecoder the live fetch uses.
+//
+// Two shapes are accepted, in UTF-8 or UTF-16LE (detected from the first
+// bytes, BOM or not):
+//   [ {...}, {...} ]                      the body as CoinGecko sent it
+//   { "value": [ {...} ], "Count": 2 }    PowerShell's ConvertTo-Json
+// UTF-16 is transcoded chunk by chunk (Utf16.h) into one reused buffer;
+// the envelope is walked only until its "value" list starts, the list is
+// decoded in place, and whatever follows it is ignored. Nothing is held
+// beyond one chunk and the current coin, so multi-GB capture sets stream.
+// -------------------------------------------------------------------------
+
+class CaptureLoader {
+public:
+    explicit CaptureLoader(CoinStreamDecoder::CoinSink sink, CoinFieldSet fields = CoinFieldSet::defaults())
+        : decoder_(std::move(sink), fields) {}
+
+    // Feeds the next chunk of the file. False once the capture is known to
+    // be bad.
+    bool feed(const char* data, size_t len) {
+        if (state_ == State::Failed) return false;
+        if (encoding_ == Encoding::Unknown) {
+            if (head_.empty() && len >= 2) {
+                detectEncoding(data);
+                return feedDecoded(data, len);
+            }
+            head_.append(data, len);
+            if (head_.size() < 2) return true;
+            detectEncoding(head_.data());
+            const std::string head = std::move(head_);
+            return feedDecoded(head.data(), head.size());
+        }
+        return feedDecoded(data, len);
+    }
+
+    // Call after the last chunk. True if a complete coin list was decoded.
+    bool finish() {
+        if (state_ == State::Failed) return false;
+        if (encoding_ == Encoding::Unknown) return fail("Empty capture.");
+        if (encoding_ == Encoding::Utf16Le) {
+            utf8_.clear();
+            transcoder_.finish(utf8_);
+            if (!scanUtf8(utf8_.data(), utf8_.size())) return false;
+        }
+        if (state_ == State::AfterList) return true;
+        if (state_ == State::List) {
+            if (!decoder_.finish()) return fail(decoder_.error());
+            return true;
+        }
+        return fail(state_ == State::Start ? "Empty capture." : "No \"value\" list in capture.");
+    }
+
+    const std::string& error() const { return error_; }
+    size_t coinCount() const { return decoder_.coinCount(); }
+    bool utf16() const { return encoding_ == Encoding::Utf16Le; }
+
+private:
+    enum class Encoding { Unknown, Utf8, Utf16Le };
+    enum class State { Start, Envelope, BeforeList, List, AfterList, Failed };
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    // Two bytes decide: FF FE is the UTF-16LE BOM, and ASCII text in
+    // UTF-16LE has a zero second byte.
+    void detectEncoding(const char* first) {
+        const unsigned char b0 = static_cast<unsigned char>(first[0]);
+        const unsigned char b1 = static_cast<unsigned char>(first[1]);
+        encoding_ = (b0 == 0xFF && b1 == 0xFE) || (b0 != 0 && b1 == 0) ? Encoding::Utf16Le : Encoding::Utf8;
+    }
+
+    bool feedDecoded(const char* data, size_t len) {
+        if (encoding_ == Encoding::Utf8) return scanUtf8(data, len);
+        utf8_.clear();
+        transcoder_.feed(data, len, utf8_);
+        return scanUtf8(utf8_.data(), utf8_.size());
+    }
+
+    bool scanUtf8(const char* data, size_t len) {
+        size_t i = 0;
+        while (i < len) {
+            switch (state_) {
+            case State::Start: {
+                const unsigned char c = static_cast<unsigned char>(data[i]);
+                if (c == 0xEF || c == 0xBB || c == 0xBF || isSpace(data[i])) { ++i; break; }   // BOM
+                if (c == '[') { state_ = State::List; break; }
+                if (c != '{') return fail("Capture is neither a list nor an object.");
+                state_ = State::Envelope;
+                depth_ = 0;
+                break;
+            }
+            case State::Envelope:
+                i = scanEnvelope(data, i, len);
+                if (state_ == State::Failed) return false;
+                break;
+            case State::BeforeList:
+                if (isSpace(data[i])) { ++i; break; }
+                if (data[i] != '[') return fail("Capture \"value\" is not a list.");
+                state_ = State::List;
+                break;
+            case State::List:
+                i += decoder_.feedList(data + i, len - i);
+                if (decoder_.listComplete()) state_ = State::AfterList;
+                else if (!decoder_.error().empty()) return fail(decoder_.error());
+                break;
+            case State::AfterList:
+                return true;   // "Count" and the closing brace
+            case State::Failed:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Walks the wrapper object up to the ':' after its top-level "value"
+    // key. Returns where it stopped.
+    size_t scanEnvelope(const char* data, size_t i, size_t len) {
+        for (; i < len; ++i) {
+            const char c = data[i];
+            if (inString_) {
+                if (escape_) escape_ = false;
+                else if (c == '\\') escape_ = true;
+                else if (c == '"') inString_ = false;
+                else if (depth_ == 1 && key_.size() < 8) key_ += c;
+                continue;
+            }
+            if (c == '"') {
+                inString_ = true;
+                if (depth_ == 1) key_.clear();
+            }
+            else if (c == '{' || c == '[') ++depth_;
+            else if (c == '}' || c == ']') {
+                if (--depth_ == 0) { fail("No \"value\" list in capture."); return i; }
+            }
+            else if (c == ':' && depth_ == 1 && key_ == "value") {
+                state_ = State::BeforeList;
+                return i + 1;
+            }
+            else if (c == ',' && depth_ == 1) key_.clear();
+        }
+        return i;
+    }
+
+    bool fail(std::string msg) {
+        error_ = std::move(msg);
+        state_ = State::Failed;
+        return false;
+    }
+
+    CoinStreamDecoder decoder_;
+    Utf16LeTranscoder transcoder_;
+    Encoding encoding_ = Encoding::Unknown;
+    State state_ = State::Start;
+    std::string head_;     // first bytes, until the encoding is known
+    std::string utf8_;     // transcoded chunk (reused)
+    std::string key_;      // current top-level key of the envelope
+    int depth_ = 0;
+    bool inString_ = false;
+    bool escape_ = false;
+    std::string error_;
+};
+
+// Decodes the capture at `path` into `sink`, reading it in 1 MB chunks.
+// On failure `error` says why; coins decoded before the problem have
+// already reached the sink.
+inline bool LoadCaptureFile(const std::string& path, CoinStreamDecoder::CoinSink sink, std::string& error,
+    CoinFieldSet fields = CoinFieldSet::defaults()) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    CaptureLoader loader(std::move(sink), fields);
+    std::vector<char> chunk(1 << 20);
+    while (file) {
+        file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const size_t got = static_cast<size_t>(file.gcount());
+        if (got == 0) break;
+        if (!loader.feed(chunk.data(), got)) break;
+    }
+    if (!loader.finish()) {
+        error = path + ": " + loader.error();
+        return false;
+    }
+    return true;
+}
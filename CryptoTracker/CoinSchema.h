@@ -0,0 +1,457 @@
+#pragma once
+
+#include "CryptoData.h"
+#include "JsonNumber.h"
+#include "Timestamp.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Schema-driven decoding of one /coins/markets object.
+//
+// Every known key has a CoinField id and a decode handler in
+// COIN_FIELDS, a table indexed by that id. The parser walks the object
+// once, with no DOM in between:
+//   key  -> field id   via the key-order cache (below)
+//   id   -> handler    via COIN_FIELDS[id], if the field is enabled
+// A disabled or unknown field has its value skipped, not converted.
+//
+// CoinGecko sends every object with the same keys in the same order, so
+// the parser remembers which field the k-th key was last time, together
+// with the key's length and hash (computed while scanning it anyway). Only
+// a key that does not match its slot is compared against the known names;
+// after the first object that is none of them.
+//
+// Not thread-safe: one parser per decoder (the key-order cache mutates).
+// -------------------------------------------------------------------------
+
+enum class CoinField : std::uint8_t {
+    Id,
+    Symbol,
+    Name,
+    Image,
+    CurrentPrice,
+    MarketCap,
+    MarketCapRank,
+    FullyDilutedValuation,
+    TotalVolume,
+    High24h,
+    Low24h,
+    PriceChange24h,
+    PriceChangePercentage24h,
+    MarketCapChange24h,
+    MarketCapChangePercentage24h,
+    CirculatingSupply,
+    TotalSupply,
+    MaxSupply,
+    Ath,
+    AthChangePercentage,
+    AthDate,
+    Atl,
+    AtlChangePercentage,
+    AtlDate,
+    Roi,
+    LastUpdated,
+    Count,
+    Unknown = Count
+};
+
+constexpr size_t COIN_FIELD_COUNT = static_cast<size_t>(CoinField::Count);
+
+// Which fields a decoder converts (the required ones always are).
+class CoinFieldSet {
+public:
+    constexpr CoinFieldSet() = default;
+
+    // id, symbol, name, price, 24h change %, market cap: the CryptoCoin row
+    static constexpr CoinFieldSet core() {
+        return CoinFieldSet()
+            .with(CoinField::Id).with(CoinField::Symbol).with(CoinField::Name)
+            .with(CoinField::CurrentPrice).with(CoinField::PriceChangePercentage24h).with(CoinField::MarketCap);
+    }
+
+    // core plus last_updated: the table without market details. The
+    // history needs the quote time to skip repeats and to place backfills.
+    static constexpr CoinFieldSet compact() {
+        return core().with(CoinField::LastUpdated);
+    }
+
+    // core plus the numbers the details panel shows (no per-coin strings)
+    // and last_updated, which keeps repeated quotes out of the history
+    static constexpr CoinFieldSet defaults() {
+        return compact()
+            .with(CoinField::MarketCapRank).with(CoinField::TotalVolume)
+            .with(CoinField::High24h).with(CoinField::Low24h)
+            .with(CoinField::CirculatingSupply).with(CoinField::MaxSupply)
+            .with(CoinField::Ath).with(CoinField::Atl);
+    }
+
+    static constexpr CoinFieldSet all() { return CoinFieldSet((1u << COIN_FIELD_COUNT) - 1); }
+
+    constexpr CoinFieldSet with(CoinField f) const { return CoinFieldSet(bits_ | bit(f)); }
+    constexpr CoinFieldSet without(CoinField f) const { return CoinFieldSet(bits_ & ~bit(f)); }
+    constexpr bool has(CoinField f) const { return (bits_ & bit(f)) != 0; }
+    constexpr std::uint32_t bits() const { return bits_; }
+    static constexpr CoinFieldSet fromBits(std::uint32_t bits) { return CoinFieldSet(bits); }
+
+private:
+    constexpr explicit CoinFieldSet(std::uint32_t bits) : bits_(bits) {}
+    static constexpr std::uint32_t bit(CoinField f) { return 1u << static_cast<unsigned>(f); }
+
+    std::uint32_t bits_ = 0;
+};
+
+static_assert(COIN_FIELD_COUNT <= 32, "CoinFieldSet holds one bit per field");
+
+// Reads JSON values out of one buffered object.
+class JsonCursor {
+public:
+    JsonCursor(const char* begin, const char* end) : at_(begin), end_(end) {}
+
+    const char* at() const { return at_; }
+    bool wasNull() const { return null_; }
+
+    void skipSpace() {
+        while (at_ < end_ && (*at_ == ' ' || *at_ == '\n' || *at_ == '\r' || *at_ == '\t')) ++at_;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (at_ == end_ || *at_ != c) return false;
+        ++at_;
+        return true;
+    }
+
+    bool peek(char c) {
+        skipSpace();
+        return at_ < end_ && *at_ == c;
+    }
+
+    // A key without unescaping, plus its FNV-1a hash.
+    bool key(const char*& text, size_t& length, std::uint64_t& hash) {
+        if (!consume('"')) return false;
+        text = at_;
+        std::uint64_t h = 14695981039346656037ull;
+        while (at_ < end_ && *at_ != '"') {
+            if (*at_ == '\\' && at_ + 1 < end_) {
+                h = (h ^ static_cast<unsigned char>(*at_++)) * 1099511628211ull;
+            }
+            h = (h ^ static_cast<unsigned char>(*at_++)) * 1099511628211ull;
+        }
+        if (at_ == end_) return false;
+        length = static_cast<size_t>(at_ - text);
+        hash = h;
+        ++at_;
+        return consume(':');
+    }
+
+    bool string(std::string& out) {
+        null_ = false;
+        if (literal("null")) { null_ = true; return true; }
+        if (!consume('"')) return false;
+        out.clear();
+        const char* run = at_;
+        while (at_ < end_ && *at_ != '"') {
+            if (*at_ != '\\') { ++at_; continue; }
+            out.append(run, at_);
+            if (!escape(out)) return false;
+            run = at_;
+        }
+        if (at_ == end_) return false;
+        out.append(run, at_);
+        ++at_;
+        return true;
+    }
+
+    // A string's raw characters, escapes left as they are; or null.
+    bool rawString(const char*& text, size_t& length) {
+        null_ = false;
+        if (literal("null")) { null_ = true; length = 0; return true; }
+        if (!consume('"')) return false;
+        text = at_;
+        for (; at_ < end_ && *at_ != '"'; ++at_) {
+            if (*at_ == '\\') ++at_;
+        }
+        if (at_ >= end_) return false;
+        length = static_cast<size_t>(at_ - text);
+        ++at_;
+        return true;
+    }
+
+    // A number, or null (out unchanged, wasNull() true).
+    bool number(double& out) {
+        null_ = false;
+        if (literal("null")) { null_ = true; return true; }
+        skipSpace();
+        const char* parsed = ParseJsonNumber(at_, end_, out);
+        if (!parsed) return false;
+        at_ = parsed;
+        return true;
+    }
+
+    // Any value, unconverted.
+    bool skipValue() {
+        skipSpace();
+        if (at_ == end_) return false;
+        switch (*at_) {
+        case '"':
+            for (++at_; at_ < end_ && *at_ != '"'; ++at_) {
+                if (*at_ == '\\') ++at_;
+            }
+            if (at_ >= end_) return false;
+            ++at_;
+            return true;
+        case '{':
+        case '[': {
+            int depth = 0;
+            bool inString = false;
+            for (; at_ < end_; ++at_) {
+                const char c = *at_;
+                if (inString) {
+                    if (c == '\\') ++at_;
+                    else if (c == '"') inString = false;
+                }
+                else if (c == '"') inString = true;
+                else if (c == '{' || c == '[') ++depth;
+                else if ((c == '}' || c == ']') && --depth == 0) { ++at_; return true; }
+            }
+            return false;
+        }
+        default: {
+            const char* start = at_;
+            while (at_ < end_ && *at_ != ',' && *at_ != '}' && *at_ != ']' &&
+                *at_ != ' ' && *at_ != '\n' && *at_ != '\r' && *at_ != '\t') {
+                ++at_;
+            }
+            return at_ != start;
+        }
+        }
+    }
+
+private:
+    bool literal(const char* word) {
+        skipSpace();
+        const size_t n = std::strlen(word);
+        if (static_cast<size_t>(end_ - at_) < n || std::memcmp(at_, word, n) != 0) return false;
+        at_ += n;
+        return true;
+    }
+
+    static int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool hex4(unsigned& out) {
+        if (end_ - at_ < 4) return false;
+        out = 0;
+        for (int i = 0; i < 4; ++i) {
+            int d = hexDigit(*at_++);
+            if (d < 0) return false;
+            out = out * 16 + static_cast<unsigned>(d);
+        }
+        return true;
+    }
+
+    // At a backslash inside a string: appends the escaped character (UTF-8).
+    bool escape(std::string& out) {
+        if (end_ - at_ < 2) return false;
+        ++at_;
+        const char c = *at_++;
+        switch (c) {
+        case '"': case '\\': case '/': out += c; return true;
+        case 'b': out += '\b'; return true;
+        case 'f': out += '\f'; return true;
+        case 'n': out += '\n'; return true;
+        case 'r': out += '\r'; return true;
+        case 't': out += '\t'; return true;
+        case 'u': break;
+        default: return false;
+        }
+        unsigned cp = 0;
+        if (!hex4(cp)) return false;
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            unsigned low = 0;
+            if (end_ - at_ < 6 || at_[0] != '\\' || at_[1] != 'u') return false;
+            at_ += 2;
+            if (!hex4(low) || low < 0xDC00 || low > 0xDFFF) return false;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        if (cp < 0x80) out += static_cast<char>(cp);
+        else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        return true;
+    }
+
+    const char* at_;
+    const char* end_;
+    bool null_ = false;
+};
+
+// An ISO-8601 string, as epoch nanoseconds. An unreadable date is left at 0
+// (absent) rather than failing the coin: it is never a required field.
+inline bool DecodeTimestamp(JsonCursor& in, std::int64_t& out) {
+    const char* text = nullptr;
+    size_t length = 0;
+    if (!in.rawString(text, length)) return false;
+    if (length > 0 && !ParseIso8601(text, length, out)) out = 0;
+    return true;
+}
+
+// roi is null or { "times": ..., "currency": ..., "percentage": ... }
+inline bool DecodeRoi(JsonCursor& in, CryptoCoin& c) {
+    if (in.peek('n')) return in.skipValue();
+    if (!in.consume('{')) return false;
+    if (in.consume('}')) return true;
+    do {
+        const char* key; size_t length; std::uint64_t hash;
+        if (!in.key(key, length, hash)) return false;
+        bool ok = length == 10 && std::memcmp(key, "percentage", 10) == 0
+            ? in.number(c.extras.roi_percentage)
+            : in.skipValue();
+        if (!ok) return false;
+    } while (in.consume(','));
+    return in.consume('}');
+}
+
+struct CoinFieldInfo {
+    const char* key;
+    bool required;                                   // missing or null fails the coin
+    bool (*decode)(JsonCursor&, CryptoCoin&);
+};
+
+// Indexed by CoinField: the jump table.
+inline constexpr CoinFieldInfo COIN_FIELDS[COIN_FIELD_COUNT] = {
+    { "id", true, [](JsonCursor& in, CryptoCoin& c) { return in.string(c.id); } },
+    { "symbol", true, [](JsonCursor& in, CryptoCoin& c) { return in.string(c.symbol); } },
+    { "name", true, [](JsonCursor& in, CryptoCoin& c) { return in.string(c.name); } },
+    { "image", false, [](JsonCursor& in, CryptoCoin& c) { return in.string(c.extras.image); } },
+    { "current_price", true, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.current_price); } },
+    { "market_cap", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.market_cap); } },
+    { "market_cap_rank", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.market_cap_rank); } },
+    { "fully_diluted_valuation", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.fully_diluted_valuation); } },
+    { "total_volume", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.total_volume); } },
+    { "high_24h", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.high_24h); } },
+    { "low_24h", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.low_24h); } },
+    { "price_change_24h", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.price_change_abs_24h); } },
+    { "price_change_percentage_24h", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.price_change_24h); } },
+    { "market_cap_change_24h", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.market_cap_change_24h); } },
+    { "market_cap_change_percentage_24h", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.market_cap_change_percentage_24h); } },
+    { "circulating_supply", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.circulating_supply); } },
+    { "total_supply", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.total_supply); } },
+    { "max_supply", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.max_supply); } },
+    { "ath", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.ath); } },
+    { "ath_change_percentage", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.ath_change_percentage); } },
+    { "ath_date", false, [](JsonCursor& in, CryptoCoin& c) { return DecodeTimestamp(in, c.extras.ath_date); } },
+    { "atl", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.atl); } },
+    { "atl_change_percentage", false, [](JsonCursor& in, CryptoCoin& c) { return in.number(c.extras.atl_change_percentage); } },
+    { "atl_date", false, [](JsonCursor& in, CryptoCoin& c) { return DecodeTimestamp(in, c.extras.atl_date); } },
+    { "roi", false, DecodeRoi },
+    { "last_updated", false, [](JsonCursor& in, CryptoCoin& c) { return DecodeTimestamp(in, c.extras.last_updated); } },
+};
+
+inline const char* CoinFieldKey(CoinField f) { return COIN_FIELDS[static_cast<size_t>(f)].key; }
+
+class CoinObjectParser {
+public:
+    explicit CoinObjectParser(CoinFieldSet fields = CoinFieldSet::defaults()) : fields_(fields) {
+        for (size_t i = 0; i < COIN_FIELD_COUNT; ++i) {
+            if (COIN_FIELDS[i].required) required_ = required_.with(static_cast<CoinField>(i));
+        }
+        fields_ = CoinFieldSet::fromBits(fields_.bits() | required_.bits());
+    }
+
+    CoinFieldSet fields() const { return fields_; }
+
+    // Decodes the object in [begin, end) into `coin` (a fresh CryptoCoin).
+    // On failure `error` says why and false is returned.
+    bool parse(const char* begin, const char* end, CryptoCoin& coin, std::string& error) {
+        JsonCursor in(begin, end);
+        if (!in.consume('{')) return fail(error, "expected an object");
+
+        CoinFieldSet seen;
+        size_t position = 0;
+        if (!in.consume('}')) {
+            do {
+                const char* key; size_t length; std::uint64_t hash;
+                if (!in.key(key, length, hash)) return fail(error, "bad key");
+
+                const CoinField field = lookup(position++, key, length, hash);
+                if (field != CoinField::Unknown && fields_.has(field)) {
+                    const CoinFieldInfo& info = COIN_FIELDS[static_cast<size_t>(field)];
+                    if (!info.decode(in, coin)) return fail(error, std::string("bad value for \"") + info.key + "\"");
+                    if (!in.wasNull()) seen = seen.with(field);
+                }
+                else if (!in.skipValue()) {
+                    return fail(error, "bad value for \"" + std::string(key, length) + "\"");
+                }
+            } while (in.consume(','));
+            if (!in.consume('}')) return fail(error, "expected ',' or '}'");
+        }
+
+        if ((seen.bits() & required_.bits()) != required_.bits()) {
+            for (size_t i = 0; i < COIN_FIELD_COUNT; ++i) {
+                const CoinField f = static_cast<CoinField>(i);
+                if (required_.has(f) && !seen.has(f)) {
+                    return fail(error, std::string("missing \"") + COIN_FIELDS[i].key + "\"");
+                }
+            }
+        }
+        return true;
+    }
+
+    // Keys that had to be compared by name (cache misses), for benchmarks.
+    unsigned long long keyLookups() const { return keyLookups_; }
+
+private:
+    struct KeySlot {
+        std::uint64_t hash = 0;
+        size_t length = 0;
+        CoinField field = CoinField::Unknown;
+    };
+
+    CoinField lookup(size_t position, const char* key, size_t length, std::uint64_t hash) {
+        if (position < slots_.size() && slots_[position].hash == hash && slots_[position].length == length) {
+            return slots_[position].field;
+        }
+        ++keyLookups_;
+        CoinField field = CoinField::Unknown;
+        for (size_t i = 0; i < COIN_FIELD_COUNT; ++i) {
+            if (std::strlen(COIN_FIELDS[i].key) == length && std::memcmp(COIN_FIELDS[i].key, key, length) == 0) {
+                field = static_cast<CoinField>(i);
+                break;
+            }
+        }
+        if (position >= slots_.size()) slots_.resize(position + 1);
+        slots_[position] = { hash, length, field };
+        return field;
+    }
+
+    static bool fail(std::string& error, std::string message) {
+        error = std::move(message);
+        return false;
+    }
+
+    CoinFieldSet fields_;
+    CoinFieldSet required_;
+    std::vector<KeySlot> slots_;
+    unsigned long long keyLookups_ = 0;
+};
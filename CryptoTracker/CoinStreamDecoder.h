@@ -0,0 +1,215 @@
+#pragma once
+
+#include "json.hpp"
+#include "CryptoData.h"
+#include "CoinSchema.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+
+// -------------------------------------------------------------------------
+// Incremental decoder for the /coins/markets response.
+//
+// Chunks arrive from httplib's content receiver in whatever sizes the
+// socket hands us. The decoder only scans for the boundaries of the
+// top-level array elements (tracking depth and string/escape state), so
+// only the current coin object is ever buffered. Each completed element is
+// parsed on its own and handed to the sink right away, which lets decoding
+// overlap with the download instead of waiting for the whole body.
+//
+// Elements are decoded by CoinObjectParser (CoinSchema.h) straight from the
+// buffer; only the fields in the decoder's CoinFieldSet are converted.
+// -------------------------------------------------------------------------
+
+// Maps one CoinGecko market object (already a DOM) onto our CryptoCoin's
+// core fields. Used where a whole body is parsed with nlohmann::json.
+inline CryptoCoin parseCoin(const nlohmann::json& item) {
+    CryptoCoin coin;
+
+    // Required fields
+    coin.id = item["id"].get<std::string>();
+    coin.symbol = item["symbol"].get<std::string>();
+    coin.name = item["name"].get<std::string>();
+    coin.current_price = item["current_price"].get<double>();
+
+    // Optional fields
+    auto pct = item.find("price_change_percentage_24h");
+    if (pct != item.end() && !pct->is_null()) {
+        coin.price_change_24h = pct->get<double>();
+    }
+
+    auto cap = item.find("market_cap");
+    if (cap != item.end() && !cap->is_null()) {
+        coin.market_cap = cap->get<double>();
+    }
+
+    return coin;
+}
+
+class CoinStreamDecoder {
+public:
+    using CoinSink = std::function<void(CryptoCoin&&)>;
+
+    explicit CoinStreamDecoder(CoinSink sink, CoinFieldSet fields = CoinFieldSet::defaults())
+        : sink_(std::move(sink)), parser_(fields) {}
+
+    // Feeds the next chunk of the body. Returns false once the stream is
+    // known to be bad, so the caller can abort the transfer early.
+    bool feed(const char* data, size_t len) {
+        scan(data, len, false);
+        return state_ != State::Failed;
+    }
+
+    // Like feed(), for a list embedded in a larger document (CaptureLoader.h):
+    // stops right after the list's closing ']' and returns how many bytes
+    // were used (all of them while the list is still open).
+    size_t feedList(const char* data, size_t len) {
+        return scan(data, len, true);
+    }
+
+    // Call after the last chunk. True if a complete list was decoded.
+    bool finish() {
+        if (state_ == State::Failed) return false;
+        if (state_ != State::Done) {
+            fail(state_ == State::BeforeArray ? "Empty body." : "Truncated list.");
+            return false;
+        }
+        return true;
+    }
+
+    bool listComplete() const { return state_ == State::Done; }
+    const std::string& error() const { return error_; }
+    size_t coinCount() const { return coinCount_; }
+    size_t peakBufferBytes() const { return peakBuffer_; }
+    const CoinObjectParser& parser() const { return parser_; }
+
+private:
+    // BetweenElements: after '[' or ',' (an element must follow, or ']'
+    // right after '['); AfterElement: a ',' or ']' must follow.
+    enum class State { BeforeArray, BetweenElements, AfterElement, InElement, Done, Failed };
+
+    size_t scan(const char* data, size_t len, bool stopAfterList) {
+        size_t i = 0;
+        for (; i < len && state_ != State::Failed; ++i) {
+            char c = data[i];
+
+            switch (state_) {
+            case State::BeforeArray:
+                if (isSpace(c)) break;
+                if (c == '[') { state_ = State::BetweenElements; break; }
+                fail("API did not return a list.");
+                break;
+
+            case State::BetweenElements:
+                if (isSpace(c)) break;
+                if (c == ',') { fail(coinCount_ == 0 ? "Comma before the first entry." : "Repeated comma in list."); break; }
+                if (c == ']') {
+                    if (coinCount_ != 0) { fail("Trailing comma in list."); break; }
+                    state_ = State::Done;
+                    break;
+                }
+                if (c != '{') { fail("Unexpected entry in list."); break; }
+                state_ = State::InElement;
+                depth_ = 0;
+                element_.clear();
+                consume(c);
+                break;
+
+            case State::AfterElement:
+                if (isSpace(c)) break;
+                if (c == ',') { state_ = State::BetweenElements; break; }
+                if (c == ']') { state_ = State::Done; break; }
+                fail(c == '{' ? "Missing comma between entries." : "Unexpected entry in list.");
+                break;
+
+            case State::InElement: {
+                // Scan the rest of the chunk for the element's end, then
+                // buffer the whole run with one append.
+                const size_t start = i;
+                while (i < len && !advance(data[i])) ++i;
+                if (i < len) {
+                    element_.append(data + start, i - start + 1);
+                    emitElement();
+                }
+                else {
+                    element_.append(data + start, len - start);
+                }
+                break;
+            }
+
+            case State::Done:
+                if (stopAfterList) return i;
+                if (!isSpace(c)) fail("Trailing data after list.");
+                break;
+
+            case State::Failed:
+                break;
+            }
+        }
+        return i;
+    }
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    void consume(char c) {
+        element_.push_back(c);
+        if (advance(c)) emitElement();
+    }
+
+    // Tracks string / escape / nesting state; true when `c` closes the element.
+    bool advance(char c) {
+        if (inString_) {
+            if (escape_) escape_ = false;
+            else if (c == '\\') escape_ = true;
+            else if (c == '"') inString_ = false;
+            return false;
+        }
+
+        if (c == '"') inString_ = true;
+        else if (c == '{' || c == '[') ++depth_;
+        else if (c == '}' || c == ']') return --depth_ == 0;
+        return false;
+    }
+
+    void emitElement() {
+        if (element_.size() > peakBuffer_) peakBuffer_ = element_.size();
+
+        try {
+            CryptoCoin coin;
+            std::string error;
+            if (!parser_.parse(element_.data(), element_.data() + element_.size(), coin, error)) {
+                fail("Bad coin entry: " + error);
+                return;
+            }
+            sink_(std::move(coin));
+            ++coinCount_;
+        }
+        catch (const std::exception& e) {
+            fail(std::string("Bad coin entry: ") + e.what());
+            return;
+        }
+
+        element_.clear();
+        state_ = State::AfterElement;
+    }
+
+    void fail(std::string msg) {
+        error_ = std::move(msg);
+        state_ = State::Failed;
+    }
+
+    CoinSink sink_;
+    CoinObjectParser parser_;
+    State state_ = State::BeforeArray;
+    std::string element_;
+    std::string error_;
+    int depth_ = 0;
+    bool inString_ = false;
+    bool escape_ = false;
+    size_t coinCount_ = 0;
+    size_t peakBuffer_ = 0;
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "imgui.h"
+#include "CoinText.h"
+#include "CryptoData.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// The coin table and the selected-coin details panel.
+//
+// Kept apart from the DX11/Win32 main loop so the same drawing code can run
+// in a headless ImGui context (see Benchmarks/).
+//
+// A steady-state frame makes no heap allocations and no number formatting:
+// widget IDs come from PushID on the symbol, the search is matched without
+// copying names, cell text arrives pre-formatted in the model (CoinText.h)
+// and the lowered search text lives in a CoinTableCache that outlives the
+// frame.
+// -------------------------------------------------------------------------
+
+// Lowercases ASCII letters in place (coin names and the search text)
+inline void ToLowerAscii(std::string& text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+}
+
+// Whether `text` contains `needleLower` (already lowercase), ignoring ASCII case
+inline bool ContainsIgnoreCaseAscii(const std::string& text, const std::string& needleLower) {
+    if (needleLower.size() > text.size()) return false;
+    const size_t last = text.size() - needleLower.size();
+    for (size_t at = 0; at <= last; ++at) {
+        size_t i = 0;
+        while (i < needleLower.size() &&
+            std::tolower(static_cast<unsigned char>(text[at + i])) == static_cast<unsigned char>(needleLower[i])) {
+            ++i;
+        }
+        if (i == needleLower.size()) return true;
+    }
+    return false;
+}
+
+// Case-insensitive name search; an empty search matches everything.
+inline bool MatchesSearch(const CryptoCoin& coin, const std::string& searchLower) {
+    return searchLower.empty() || ContainsIgnoreCaseAscii(coin.name, searchLower);
+}
+
+// Everything the table reads. The caller holds g_dataMutex while drawing.
+struct CoinTableModel {
+    const std::vector<CryptoCoin>& coins;
+    const std::vector<CoinCellText>& cells;                                  // parallel to coins
+    const std::unordered_set<std::string>& favorites;                        // symbols
+    const std::unordered_map<std::string, std::vector<float>>& priceHistory; // by symbol
+    std::string& selectedSymbol;
+    const char* priceColumn = "Price (USD)";                                 // header, names the display currency
+    NumberFormat numberFormat = NumberFormat();                              // for text formatted while drawing (details)
+};
+
+struct CoinTableFilter {
+    const char* search = "";
+    bool favoritesOnly = false;
+};
+
+// Per-table state kept across frames (owned by the caller, one per table).
+// Its buffers grow to fit the data once and are reused afterwards.
+struct CoinTableCache {
+    std::string searchLower;
+    std::vector<CoinCellText> cells;   // only used if the model's cells do not match its coins
+};
+
+// What the table asks the app to do in response to the user.
+struct CoinTableActions {
+    std::function<void(const std::string& symbol)> toggleFavorite;
+    std::function<void(const std::string& id)> rowVisible;   // row was on screen this frame
+};
+
+inline void DrawCoinDetails(const CryptoCoin& selected, const CoinCellText& text,
+    const std::unordered_map<std::string, std::vector<float>>& priceHistory, const NumberFormat& format = NumberFormat()) {
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("Selected Coin Details");
+
+    ImGui::Text("Name: %s (%s)", selected.name.c_str(), selected.symbol.c_str());
+    ImGui::Text("Current Price: %s", text.priceText);
+    ImGui::Text("24h Change: %s", text.changeText);
+    ImGui::Text("Market Cap: %s", text.marketCapText);
+
+    // Optional columns (CoinSchema.h); absent when not decoded or null
+    const CoinMarketExtras& x = selected.extras;
+    const CurrencyInfo& currency = text.currency ? *text.currency : DISPLAY_CURRENCIES[0];
+    char buffer[48];
+    auto amount = [&](const char* label, double value) {
+        if (std::isnan(value)) return;
+        value *= text.factor;
+        FormatNumber(buffer, sizeof(buffer), value, PriceDecimals(value), format, currency.prefix, currency.suffix);
+        ImGui::Text("%s: %s", label, buffer);
+    };
+    auto count = [&](const char* label, double value) {
+        if (std::isnan(value)) return;
+        FormatNumber(buffer, sizeof(buffer), value, 0, format);
+        ImGui::Text("%s: %s", label, buffer);
+    };
+    if (!std::isnan(x.market_cap_rank)) ImGui::Text("Rank: #%.0f", x.market_cap_rank);
+    amount("24h Volume", x.total_volume);
+    amount("24h High", x.high_24h);
+    amount("24h Low", x.low_24h);
+    count("Circulating Supply", x.circulating_supply);
+    count("Max Supply", x.max_supply);
+    amount("All-Time High", x.ath);
+    amount("All-Time Low", x.atl);
+
+    // --- price history graph ---
+    auto it = priceHistory.find(selected.symbol);
+    if (it != priceHistory.end() && it->second.size() >= 2) {
+        const std::vector<float>& hist = it->second;
+
+        // Compute min/max for nicer scaling
+        float minPrice = hist[0];
+        float maxPrice = hist[0];
+        for (float v : hist) {
+            if (v < minPrice) minPrice = v;
+            if (v > maxPrice) maxPrice = v;
+        }
+
+        // Add a small margin
+        float scaleMin = minPrice * 0.95f;
+        float scaleMax = maxPrice * 1.05f;
+
+        ImGui::Spacing();
+        ImGui::Text("Price History:");
+        ImGui::PlotLines(
+            "",                    // no label inside the graph
+            hist.data(),
+            static_cast<int>(hist.size()),
+            0,
+            nullptr,               // no overlay text
+            scaleMin,
+            scaleMax,
+            ImVec2(0, 100.0f)      // width auto, height ~100px
+        );
+    }
+    else {
+        ImGui::Spacing();
+        ImGui::Text("Price History: collecting data...");
+    }
+}
+
+inline void DrawCoinTable(const CoinTableModel& model, const CoinTableFilter& filter,
+    const CoinTableActions& actions, CoinTableCache& cache) {
+    if (!ImGui::BeginTable("Coins", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable)) {
+        return;
+    }
+
+    ImGui::TableSetupColumn("Fav", ImGuiTableColumnFlags_WidthFixed, 30.0f);
+    ImGui::TableSetupColumn("Name");
+    ImGui::TableSetupColumn("Symbol");
+    ImGui::TableSetupColumn(model.priceColumn);
+    ImGui::TableSetupColumn("24h Change");
+    ImGui::TableHeadersRow();
+
+    cache.searchLower.assign(filter.search);
+    ToLowerAscii(cache.searchLower);
+
+    const std::vector<CoinCellText>* cells = &model.cells;
+    if (cells->size() != model.coins.size()) {
+        UpdateCoinCells(model.coins, cache.cells, NumberFormat());
+        cells = &cache.cells;
+    }
+
+    for (size_t row = 0; row < model.coins.size(); ++row) {
+        const CryptoCoin& coin = model.coins[row];
+
+        // FILTER 1: Search Logic
+        if (!MatchesSearch(coin, cache.searchLower)) {
+            continue; // Skip if name doesn't match search
+        }
+
+        // FILTER 2: Favorites Logic
+        bool isFav = model.favorites.count(coin.symbol) > 0;
+        if (filter.favoritesOnly && !isFav) {
+            continue; // Skip if we only want favorites
+        }
+
+        // RENDER ROW
+        ImGui::TableNextRow();
+        ImGui::PushID(coin.symbol.c_str());
+
+        // Column 1: Favorite Checkbox
+        ImGui::TableSetColumnIndex(0);
+        if (ImGui::Checkbox("##fav", &isFav) && actions.toggleFavorite) {
+            actions.toggleFavorite(coin.symbol);
+        }
+
+        // Column 2: Name (clickable, selects this coin)
+        ImGui::TableSetColumnIndex(1);
+        bool isSelected = (!model.selectedSymbol.empty() && model.selectedSymbol == coin.symbol);
+        if (ImGui::Selectable(coin.name.c_str(), isSelected)) {
+            model.selectedSymbol = coin.symbol;
+        }
+        if (ImGui::IsItemVisible() && actions.rowVisible) {
+            actions.rowVisible(coin.id);
+        }
+
+        // Column 3: Symbol
+        ImGui::TableSetColumnIndex(2);
+        ImGui::TextUnformatted(coin.symbol.c_str());
+
+        const CoinCellText& text = (*cells)[row];
+
+        // Column 4: Price
+        ImGui::TableSetColumnIndex(3);
+        ImGui::TextUnformatted(text.priceText);
+
+        // Column 5: 24h Change
+        ImGui::TableSetColumnIndex(4);
+        ImGui::PushStyleColor(ImGuiCol_Text, coin.price_change_24h >= 0 ? ImVec4(0, 1, 0, 1) : ImVec4(1, 0, 0, 1));
+        ImGui::TextUnformatted(text.changeText);
+        ImGui::PopStyleColor();
+
+        ImGui::PopID();
+    }
+
+    // --- SELECTED COIN DETAILS ---
+    if (!model.selectedSymbol.empty()) {
+        for (size_t row = 0; row < model.coins.size(); ++row) {
+            if (model.coins[row].symbol == model.selectedSymbol) {
+                DrawCoinDetails(model.coins[row], (*cells)[row], model.priceHistory, model.numberFormat);
+                break;
+            }
+        }
+    }
+
+    ImGui::EndTable();
+}
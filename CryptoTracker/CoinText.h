@@ -0,0 +1,151 @@
+#pragma once
+
+#include "CryptoData.h"
+#include "Currency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <locale>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Display text for prices, changes and market caps.
+//
+// Cells are formatted once per value change by whoever publishes the coin
+// list (CaptureSnapshot in the app), not by the UI: a frame only hands the
+// prepared text to ImGui::TextUnformatted.
+// -------------------------------------------------------------------------
+
+// Digit grouping and decimal mark of the user's locale.
+struct NumberFormat {
+    char thousands = ',';   // '\0' = no grouping
+    char decimal = '.';
+
+    static NumberFormat fromUserLocale() {
+        NumberFormat format;
+        try {
+            const auto& punct = std::use_facet<std::numpunct<char>>(std::locale(""));
+            format.decimal = printable(punct.decimal_point(), '.');
+            format.thousands = punct.grouping().empty() ? '\0' : printable(punct.thousands_sep(), ' ');
+        }
+        catch (const std::runtime_error&) {
+            // unknown locale name in the environment: keep the defaults
+        }
+        return format;
+    }
+
+private:
+    // Code-page separators (e.g. 0xA0, no-break space) are not valid UTF-8
+    // for ImGui; fall back to an ASCII look-alike.
+    static char printable(char c, char fallback) {
+        return (c > ' ' && c < 0x7f) || c == ' ' ? c : fallback;
+    }
+};
+
+// Decimal places for a price: cents from $1 up, four significant digits
+// below that ($0.5432, $0.01234, $0.00001234).
+inline int PriceDecimals(double price) {
+    const double magnitude = std::fabs(price);
+    if (magnitude >= 1.0 || magnitude == 0.0) return 2;
+    int decimals = 3 - static_cast<int>(std::floor(std::log10(magnitude)));
+    return std::min(decimals, 12);
+}
+
+// Writes sign, prefix, grouped digits, `decimals` places and suffix into
+// `out` (always NUL-terminated). `plus` prints '+' for non-negative values.
+inline void FormatNumber(char* out, size_t size, double value, int decimals, const NumberFormat& format,
+    const char* prefix = "", const char* suffix = "", bool plus = false) {
+    if (size == 0) return;
+    char digits[64];
+    int n = std::isfinite(value)
+        ? std::snprintf(digits, sizeof(digits), "%.*f", decimals, std::fabs(value))
+        : -1;
+    if (n < 0 || n >= static_cast<int>(sizeof(digits))) {
+        std::snprintf(out, size, "-");
+        return;
+    }
+
+    const int integerDigits = decimals > 0 ? n - decimals - 1 : n;
+    size_t at = 0;
+    auto put = [&](char c) { if (at + 1 < size) out[at++] = c; };
+
+    if (std::signbit(value) && value != 0.0) put('-');
+    else if (plus) put('+');
+    for (const char* p = prefix; *p; ++p) put(*p);
+    for (int i = 0; i < integerDigits; ++i) {
+        if (i > 0 && format.thousands && (integerDigits - i) % 3 == 0) put(format.thousands);
+        put(digits[i]);
+    }
+    if (decimals > 0) {
+        put(format.decimal);
+        for (int i = integerDigits + 1; i < n; ++i) put(digits[i]);
+    }
+    for (const char* p = suffix; *p; ++p) put(*p);
+    out[at] = '\0';
+}
+
+// Price, 24h change and market cap text of one coin, re-formatted only when
+// the value it was formatted from (or the display currency) changes.
+struct CoinCellText {
+    double price = std::numeric_limits<double>::quiet_NaN();
+    double change = std::numeric_limits<double>::quiet_NaN();
+    double marketCap = std::numeric_limits<double>::quiet_NaN();
+    const CurrencyInfo* currency = nullptr;
+    double factor = 1.0;   // base currency -> currency (for the details panel)
+    char priceText[40] = "";
+    char changeText[24] = "";
+    char marketCapText[40] = "";
+
+    // Amounts already in `currency`
+    void update(double newPrice, double newChange, double newMarketCap, const CurrencyInfo& in,
+        const NumberFormat& format) {
+        const bool sameCurrency = currency == &in;
+        currency = &in;
+        if (newPrice != price || !sameCurrency) {
+            price = newPrice;
+            FormatNumber(priceText, sizeof(priceText), price, PriceDecimals(price), format, in.prefix, in.suffix);
+        }
+        if (newChange != change) {
+            change = newChange;
+            FormatNumber(changeText, sizeof(changeText), change, 2, format, "", "%", true);
+        }
+        if (newMarketCap != marketCap || !sameCurrency) {
+            marketCap = newMarketCap;
+            FormatNumber(marketCapText, sizeof(marketCapText), marketCap, 0, format, in.prefix, in.suffix);
+        }
+    }
+
+    void update(const CryptoCoin& coin, const NumberFormat& format) {
+        update(coin.current_price, coin.price_change_24h, coin.market_cap, DISPLAY_CURRENCIES[0], format);
+        factor = 1.0;
+    }
+};
+
+// Brings `cells` in line with `coins` (same order and length), in the base currency.
+inline void UpdateCoinCells(const std::vector<CryptoCoin>& coins, std::vector<CoinCellText>& cells,
+    const NumberFormat& format) {
+    cells.resize(coins.size());
+    for (size_t i = 0; i < coins.size(); ++i) cells[i].update(coins[i], format);
+}
+
+// Same, with prices and market caps taken from column `currency` of
+// `columns` (converted from `coins`; DISPLAY_CURRENCIES order).
+inline void UpdateCoinCells(const std::vector<CryptoCoin>& coins, const CurrencyColumns& columns,
+    size_t currency, std::vector<CoinCellText>& cells, const NumberFormat& format) {
+    if (columns.coins != coins.size() || currency >= columns.currencies() || currency >= DISPLAY_CURRENCY_COUNT) {
+        UpdateCoinCells(coins, cells, format);
+        return;
+    }
+    const double* price = columns.price(currency);
+    const double* marketCap = columns.marketCap(currency);
+    const CurrencyInfo& info = DISPLAY_CURRENCIES[currency];
+    cells.resize(coins.size());
+    for (size_t i = 0; i < coins.size(); ++i) {
+        cells[i].update(price[i], coins[i].price_change_24h, marketCap[i], info, format);
+        cells[i].factor = columns.factors[currency];
+    }
+}
@@ -1,7 +1,38 @@
 #pragma once
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
+// Optional /coins/markets columns, decoded only when enabled in the
+// decoder's CoinFieldSet (CoinSchema.h). NaN / empty / 0 = absent (null in
+// the response) or not decoded. Dates are nanoseconds since the Unix epoch
+// (Timestamp.h).
+struct CoinMarketExtras {
+    static constexpr double NONE = std::numeric_limits<double>::quiet_NaN();
+
+    std::string image;                        // logo URL
+    double market_cap_rank = NONE;
+    double fully_diluted_valuation = NONE;
+    double total_volume = NONE;
+    double high_24h = NONE;
+    double low_24h = NONE;
+    double price_change_abs_24h = NONE;       // "price_change_24h" (the row's change is a percentage)
+    double market_cap_change_24h = NONE;
+    double market_cap_change_percentage_24h = NONE;
+    double circulating_supply = NONE;
+    double total_supply = NONE;
+    double max_supply = NONE;
+    double ath = NONE;
+    double ath_change_percentage = NONE;
+    std::int64_t ath_date = 0;
+    double atl = NONE;
+    double atl_change_percentage = NONE;
+    std::int64_t atl_date = 0;
+    double roi_percentage = NONE;
+    std::int64_t last_updated = 0;            // when CoinGecko last recomputed this quote
+};
+
 struct CryptoCoin {
     std::string id = "";
     std::string symbol = "";
@@ -9,4 +40,5 @@ struct CryptoCoin {
     double current_price = 0.0;
     double price_change_24h = 0.0;
     double market_cap = 0.0;
-};
\ No newline at end of file
+    CoinMarketExtras extras;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "json.hpp"
+#include "CryptoData.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Display currencies.
+//
+// The universe is fetched once, in BASE_CURRENCY. Other currencies are
+// derived from CoinGecko's /exchange_rates table (a few KB, refreshed far
+// less often than prices), so showing EUR, BTC or JPY costs no extra
+// market requests.
+//
+// At capture time CurrencyColumns gathers the base price and market cap
+// columns once, then scales them per currency in flat loops over
+// contiguous doubles, which the compiler vectorizes. Snapshots and the
+// table text share the result.
+//
+// The 24h change is a percentage and is shown as fetched; it ignores how
+// the exchange rate itself moved over the day.
+// -------------------------------------------------------------------------
+
+constexpr const char* BASE_CURRENCY = "usd";   // vs_currency of every market request
+
+struct CurrencyInfo {
+    const char* code;     // CoinGecko code (vs_currency, exchange_rates key)
+    const char* label;    // combo text
+    const char* prefix;   // before the digits ("$")
+    const char* suffix;   // after the digits (" EUR")
+    const char* column;   // price column header
+};
+
+// Offered in the UI; the first entry must be BASE_CURRENCY.
+inline constexpr CurrencyInfo DISPLAY_CURRENCIES[] = {
+    { "usd", "USD", "$", "", "Price (USD)" },
+    { "eur", "EUR", "", " EUR", "Price (EUR)" },
+    { "btc", "BTC", "", " BTC", "Price (BTC)" },
+    { "jpy", "JPY", "", " JPY", "Price (JPY)" },
+};
+constexpr size_t DISPLAY_CURRENCY_COUNT = sizeof(DISPLAY_CURRENCIES) / sizeof(DISPLAY_CURRENCIES[0]);
+
+// CoinGecko /api/v3/exchange_rates: value of one BTC in each currency.
+class ExchangeRates {
+public:
+    // Replaces the table with the rates in `body`. On a malformed body the
+    // table is left unchanged, `error` is set and false is returned.
+    bool parse(const std::string& body, std::string& error) {
+        nlohmann::json doc = nlohmann::json::parse(body, nullptr, false);
+        if (doc.is_discarded() || !doc.is_object() || !doc.contains("rates") || !doc["rates"].is_object()) {
+            error = "exchange rates: unexpected response";
+            return false;
+        }
+        std::unordered_map<std::string, double> perBtc;
+        for (const auto& [code, rate] : doc["rates"].items()) {
+            if (!rate.is_object() || !rate.contains("value") || !rate["value"].is_number()) continue;
+            const double value = rate["value"].get<double>();
+            if (value > 0.0 && std::isfinite(value)) perBtc[code] = value;
+        }
+        if (!perBtc.count(BASE_CURRENCY)) {
+            error = std::string("exchange rates: no rate for ") + BASE_CURRENCY;
+            return false;
+        }
+        perBtc_ = std::move(perBtc);
+        return true;
+    }
+
+    void set(const std::string& code, double unitsPerBtc) { perBtc_[code] = unitsPerBtc; }
+    bool empty() const { return perBtc_.empty(); }
+
+    // Multiplier from BASE_CURRENCY amounts to `code`; NaN if either rate is
+    // unknown (no table yet, or a code CoinGecko does not list).
+    double factor(const std::string& code) const {
+        if (code == BASE_CURRENCY) return 1.0;
+        auto to = perBtc_.find(code);
+        auto from = perBtc_.find(BASE_CURRENCY);
+        if (to == perBtc_.end() || from == perBtc_.end()) return std::numeric_limits<double>::quiet_NaN();
+        return to->second / from->second;
+    }
+
+private:
+    std::unordered_map<std::string, double> perBtc_;
+};
+
+// Price and market cap of every coin in several currencies, stored
+// currency-major: price(c)[i] is coin i in currency c. Currency 0 is the
+// base. A currency without a known rate holds NaN.
+struct CurrencyColumns {
+    size_t coins = 0;
+    std::vector<double> factors;     // per currency, from the base
+    std::vector<double> prices;      // currencies x coins
+    std::vector<double> marketCaps;  // currencies x coins
+
+    size_t currencies() const { return factors.size(); }
+    const double* price(size_t currency) const { return prices.data() + currency * coins; }
+    const double* marketCap(size_t currency) const { return marketCaps.data() + currency * coins; }
+};
+
+// Fills `out` for `coins` in the currencies whose factors are given.
+// factors[0] is taken to be the base itself (1.0). Reuses out's storage.
+inline void ConvertColumns(const std::vector<CryptoCoin>& coins, const std::vector<double>& factors,
+    CurrencyColumns& out) {
+    const size_t n = coins.size();
+    out.coins = n;
+    out.factors = factors;
+    out.prices.resize(factors.size() * n);
+    out.marketCaps.resize(factors.size() * n);
+    if (factors.empty()) return;
+
+    // Gather the base columns once (the only pass over the coin structs)...
+    double* basePrice = out.prices.data();
+    double* baseCap = out.marketCaps.data();
+    for (size_t i = 0; i < n; ++i) {
+        basePrice[i] = coins[i].current_price;
+        baseCap[i] = coins[i].market_cap;
+    }
+    // ...then each currency is one multiply over a contiguous column.
+    for (size_t c = 1; c < factors.size(); ++c) {
+        const double f = factors[c];
+        double* price = out.prices.data() + c * n;
+        double* cap = out.marketCaps.data() + c * n;
+        for (size_t i = 0; i < n; ++i) price[i] = basePrice[i] * f;
+        for (size_t i = 0; i < n; ++i) cap[i] = baseCap[i] * f;
+    }
+}
+
+// Factors for DISPLAY_CURRENCIES from `rates`.
+inline std::vector<double> DisplayCurrencyFactors(const ExchangeRates& rates) {
+    std::vector<double> factors;
+    factors.reserve(DISPLAY_CURRENCY_COUNT);
+    for (const auto& currency : DISPLAY_CURRENCIES) factors.push_back(rates.factor(currency.code));
+    return factors;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "json.hpp"
+#include "MarketSnapshot.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Push feed of per-refresh change-sets.
+//
+// When a snapshot is published, the coins that changed (plus removed ids)
+// are serialized once into a DeltaMessage that holds both the ready-to-send
+// SSE frame and the bare JSON used by long-polling. Subscribers only keep
+// a cursor into a bounded ring of shared messages. Every subscriber writes
+// the same bytes, and nothing is queued per subscriber. A consumer that
+// falls behind the ring is resynced with the current full snapshot instead,
+// and so is one whose cursor is ahead of the feed (the tracker restarted
+// and its versions began again while the client kept its old cursor).
+// -------------------------------------------------------------------------
+struct DeltaMessage {
+    unsigned long long version = 0;       // snapshot version after this delta
+    unsigned long long prevVersion = 0;   // snapshot version it applies to
+    std::string json;                     // {"version":..,"prev":..,"changed":[..],"removed":[..]}
+    std::string sse;                      // "id: ..\nevent: delta\ndata: <json>\n\n"
+};
+
+using DeltaPtr = std::shared_ptr<const DeltaMessage>;
+
+class DeltaFeed {
+public:
+    explicit DeltaFeed(size_t capacity = 64) : capacity_(capacity) {}
+
+    // What a subscriber at `cursor` has to send next.
+    struct Batch {
+        bool resync = false;              // cursor fell out of the ring or is ahead of it: send a full snapshot
+        bool closed = false;              // feed shut down
+        std::vector<DeltaPtr> messages;   // deltas after cursor, oldest first
+    };
+
+    // Computes and serializes the change-set between two snapshots. Called by
+    // SnapshotStore under its writer lock, so pushes arrive in version order.
+    void push(const MarketSnapshot& prev, const MarketSnapshot& next) {
+        auto msg = std::make_shared<DeltaMessage>();
+        msg->version = next.version;
+        msg->prevVersion = prev.version;
+        msg->json = diffJson(prev, next);
+        msg->sse = "id: " + std::to_string(next.version) + "\nevent: delta\ndata: " + msg->json + "\n\n";
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            latest_ = msg->version;
+            ring_.push_back(std::move(msg));
+            if (ring_.size() > capacity_) ring_.pop_front();
+            ++published_;
+        }
+        cv_.notify_all();
+    }
+
+    // Blocks until there is something newer than `cursor`, the timeout
+    // expires (empty batch) or the feed is shut down. A cursor newer than
+    // anything pushed gets a resync straight away.
+    Batch waitAfter(unsigned long long cursor, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, timeout, [&]() {
+            return closed_ || cursor > latest_ || (!ring_.empty() && ring_.back()->version > cursor);
+        });
+
+        Batch batch;
+        batch.closed = closed_;
+        if (closed_) return batch;
+        if (cursor > latest_) {
+            batch.resync = true;
+            ++resyncs_;
+            return batch;
+        }
+        if (ring_.empty() || ring_.back()->version <= cursor) {
+            return batch;
+        }
+
+        // The first delta we'd send must start exactly at the cursor,
+        // otherwise the subscriber missed some and needs a resync.
+        size_t first = 0;
+        while (first < ring_.size() && ring_[first]->version <= cursor) ++first;
+        if (ring_[first]->prevVersion != cursor) {
+            batch.resync = true;
+            ++resyncs_;
+            return batch;
+        }
+
+        batch.messages.assign(ring_.begin() + first, ring_.end());
+        return batch;
+    }
+
+    // Wakes every waiting subscriber so server threads can exit.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    unsigned long long published() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return published_;
+    }
+
+    unsigned long long resyncs() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return resyncs_;
+    }
+
+private:
+    static nlohmann::json coinJson(const CryptoCoin& coin) {
+        return {
+            { "id", coin.id },
+            { "symbol", coin.symbol },
+            { "name", coin.name },
+            { "current_price", coin.current_price },
+            { "price_change_percentage_24h", coin.price_change_24h },
+            { "market_cap", coin.market_cap },
+        };
+    }
+
+    static std::string diffJson(const MarketSnapshot& prev, const MarketSnapshot& next) {
+        std::unordered_map<std::string, const CryptoCoin*> before;
+        before.reserve(prev.coins.size());
+        for (const auto& coin : prev.coins) before[coin.id] = &coin;
+
+        nlohmann::json changed = nlohmann::json::array();
+        for (const auto& coin : next.coins) {
+            auto it = before.find(coin.id);
+            if (it == before.end()) {
+                changed.push_back(coinJson(coin));
+                continue;
+            }
+            const CryptoCoin& old = *it->second;
+            if (old.current_price != coin.current_price ||
+                old.price_change_24h != coin.price_change_24h ||
+                old.market_cap != coin.market_cap) {
+                changed.push_back(coinJson(coin));
+            }
+            before.erase(it);
+        }
+
+        nlohmann::json removed = nlohmann::json::array();
+        for (const auto& kv : before) removed.push_back(kv.first);
+
+        nlohmann::json doc = {
+            { "version", next.version },
+            { "prev", prev.version },
+            { "changed", std::move(changed) },
+            { "removed", std::move(removed) },
+        };
+        return doc.dump();
+    }
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<DeltaPtr> ring_;
+    bool closed_ = false;
+    unsigned long long latest_ = 0;   // version of the newest push (0: none yet)
+    unsigned long long published_ = 0;
+    unsigned long long resyncs_ = 0;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "AtomicFile.h"
+
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+
+// -------------------------------------------------------------------------
+// favorites.txt: one coin symbol per line.
+// Filesystem errors are thrown (std::filesystem::filesystem_error); the
+// caller reports them in the status line. Writes replace the file
+// atomically (AtomicFile.h), so a crash never leaves a partial list.
+// -------------------------------------------------------------------------
+
+// Adds the symbols stored in `path` to `favorites` (one read of the whole
+// file). A missing file is not an error.
+inline void ReadFavoritesFile(const std::filesystem::path& path, std::unordered_set<std::string>& favorites) {
+    std::string content;
+    if (!ReadWholeFile(path, content)) return;
+
+    size_t begin = 0;
+    while (begin < content.size()) {
+        size_t end = content.find('\n', begin);
+        if (end == std::string::npos) end = content.size();
+        size_t last = end;
+        if (last > begin && content[last - 1] == '\r') --last;
+        if (last > begin) favorites.emplace(content, begin, last - begin);
+        begin = end + 1;
+    }
+}
+
+// The file content for `symbols`
+template <typename Symbols>
+std::string FavoritesFileContent(const Symbols& symbols) {
+    std::string content;
+    for (const auto& symbol : symbols) {
+        content += symbol;
+        content += '\n';
+    }
+    return content;
+}
+
+// Replaces `path` with `symbols`, creating its directory if needed.
+template <typename Symbols>
+void WriteFavoritesFile(const std::filesystem::path& path, const Symbols& symbols) {
+    WriteFileAtomically(path, FavoritesFileContent(symbols));
+}
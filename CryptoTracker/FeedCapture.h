@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// -------------------------------------------------------------------------
+// Recorded market feed sessions ("feed captures").
+//
+// With recording on, APIClient appends every response it receives - path,
+// status, headers, the body as the decoder saw it, and when it arrived -
+// to one append-only file. Replaying that file drives the app from the
+// same data at recorded speed, N times faster, or as fast as the pipeline
+// goes, so a session can be reproduced and timed.
+//
+// File layout (little-endian), compact and appendable:
+//   "CTFEED1\n"
+//   record*: u32 size of what follows
+//            i64 offsetNs    request start, since the first session began
+//            u32 durationUs  request start -> end of body
+//            u16 status
+//            u16 pathBytes, u32 headerBytes, u32 bodyBytes
+//            path, headers ("Name: value\n" each), body
+// A record is written with one call and flushed, so a crash leaves at
+// most a truncated last record, which readers ignore. Reopening a file
+// appends a new session after the last one.
+// -------------------------------------------------------------------------
+
+struct CapturedResponse {
+    std::int64_t offsetNs = 0;
+    std::uint32_t durationUs = 0;
+    int status = 0;
+    std::string path;
+    std::string headers;
+    std::string body;
+};
+
+namespace feed_capture_detail {
+
+constexpr char MAGIC[] = "CTFEED1\n";
+constexpr size_t MAGIC_BYTES = 8;
+constexpr size_t FIXED_BYTES = 8 + 4 + 2 + 2 + 4 + 4;   // after the size prefix
+
+template <typename T>
+void put(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T get(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+} // namespace feed_capture_detail
+
+class CaptureReader {
+public:
+    ~CaptureReader() { close(); }
+
+    bool open(const std::string& path, std::string& error) {
+        close();
+        file_ = std::fopen(path.c_str(), "rb");
+        if (!file_) {
+            error = "Cannot open " + path;
+            return false;
+        }
+        char magic[feed_capture_detail::MAGIC_BYTES];
+        if (std::fread(magic, 1, sizeof magic, file_) != sizeof magic ||
+            std::memcmp(magic, feed_capture_detail::MAGIC, sizeof magic) != 0) {
+            error = path + " is not a feed capture";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // The next record, or false at the end of the file (truncated() tells
+    // whether it ended inside a record).
+    bool next(CapturedResponse& out) {
+        using namespace feed_capture_detail;
+        if (!file_) return false;
+        std::uint32_t size = 0;
+        const size_t got = std::fread(&size, 1, sizeof size, file_);
+        if (got != sizeof size) {
+            truncated_ = got != 0;
+            return false;
+        }
+        record_.resize(size);
+        if (size < FIXED_BYTES || std::fread(&record_[0], 1, size, file_) != size) {
+            truncated_ = true;
+            return false;
+        }
+        const char* p = record_.data();
+        out.offsetNs = get<std::int64_t>(p);
+        out.durationUs = get<std::uint32_t>(p);
+        out.status = get<std::uint16_t>(p);
+        const size_t pathBytes = get<std::uint16_t>(p);
+        const size_t headerBytes = get<std::uint32_t>(p);
+        const size_t bodyBytes = get<std::uint32_t>(p);
+        if (FIXED_BYTES + pathBytes + headerBytes + bodyBytes != size) {
+            truncated_ = true;
+            return false;
+        }
+        out.path.assign(p, pathBytes);
+        out.headers.assign(p + pathBytes, headerBytes);
+        out.body.assign(p + pathBytes + headerBytes, bodyBytes);
+        ++records_;
+        return true;
+    }
+
+    bool truncated() const { return truncated_; }
+    size_t records() const { return records_; }
+
+    void close() {
+        if (file_) std::fclose(file_);
+        file_ = nullptr;
+    }
+
+private:
+    std::FILE* file_ = nullptr;
+    std::string record_;
+    bool truncated_ = false;
+    size_t records_ = 0;
+};
+
+// Appends records; safe to share between the fetch threads.
+class CaptureWriter {
+public:
+    ~CaptureWriter() { close(); }
+
+    bool open(const std::string& path, std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_) std::fclose(file_);
+        file_ = nullptr;
+
+        // An existing capture gets a new session after its last record,
+        // keeping offsets increasing through the file.
+        std::int64_t resumeAt = 0;
+        {
+            CaptureReader existing;
+            std::string ignored;
+            if (existing.open(path, ignored)) {
+                CapturedResponse last;
+                while (existing.next(last)) resumeAt = last.offsetNs + 1000000000;
+                if (existing.truncated()) {
+                    error = path + " ends in a truncated record; not appending to it";
+                    return false;
+                }
+            }
+        }
+
+        file_ = std::fopen(path.c_str(), "ab");
+        if (!file_) {
+            error = "Cannot write " + path;
+            return false;
+        }
+        std::fseek(file_, 0, SEEK_END);
+        if (std::ftell(file_) == 0) {
+            std::fwrite(feed_capture_detail::MAGIC, 1, feed_capture_detail::MAGIC_BYTES, file_);
+        }
+        else if (resumeAt == 0 && !hasMagic(path)) {
+            error = path + " exists and is not a feed capture";
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        base_ = resumeAt;
+        started_ = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool isOpen() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return file_ != nullptr;
+    }
+
+    // Offset of a request started at `at`, for CapturedResponse::offsetNs.
+    std::int64_t offsetOf(std::chrono::steady_clock::time_point at) const {
+        return base_ + std::chrono::duration_cast<std::chrono::nanoseconds>(at - started_).count();
+    }
+
+    void append(const CapturedResponse& response) {
+        using namespace feed_capture_detail;
+        std::string record;
+        record.reserve(4 + FIXED_BYTES + response.path.size() + response.headers.size() + response.body.size());
+        const size_t pathBytes = response.path.size() < 0xFFFF ? response.path.size() : 0xFFFF;
+        put<std::uint32_t>(record, static_cast<std::uint32_t>(
+            FIXED_BYTES + pathBytes + response.headers.size() + response.body.size()));
+        put<std::int64_t>(record, response.offsetNs);
+        put<std::uint32_t>(record, response.durationUs);
+        put<std::uint16_t>(record, static_cast<std::uint16_t>(response.status));
+        put<std::uint16_t>(record, static_cast<std::uint16_t>(pathBytes));
+        put<std::uint32_t>(record, static_cast<std::uint32_t>(response.headers.size()));
+        put<std::uint32_t>(record, static_cast<std::uint32_t>(response.body.size()));
+        record.append(response.path, 0, pathBytes);
+        record += response.headers;
+        record += response.body;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_) return;
+        std::fwrite(record.data(), 1, record.size(), file_);
+        std::fflush(file_);
+        ++records_;
+    }
+
+    size_t records() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_) std::fclose(file_);
+        file_ = nullptr;
+    }
+
+private:
+    static bool hasMagic(const std::string& path) {
+        CaptureReader reader;
+        std::string ignored;
+        return reader.open(path, ignored);
+    }
+
+    mutable std::mutex mutex_;
+    std::FILE* file_ = nullptr;
+    std::int64_t base_ = 0;
+    std::chrono::steady_clock::time_point started_;
+    size_t records_ = 0;
+};
+
+// Paces a replay: a record is due `offset / speed` after the first one.
+// Speed 0 replays as fast as possible.
+class ReplayClock {
+public:
+    explicit ReplayClock(double speed) : speed_(speed) {}
+
+    // Sleeps until the record at `offsetNs` is due. Returns false early if
+    // `running` goes false.
+    bool waitFor(std::int64_t offsetNs, const std::atomic<bool>& running) {
+        if (!anchored_) {
+            anchored_ = true;
+            firstOffset_ = offsetNs;
+            started_ = std::chrono::steady_clock::now();
+        }
+        if (speed_ <= 0.0) return running;
+        const auto due = started_ + std::chrono::nanoseconds(
+            static_cast<std::int64_t>(static_cast<double>(offsetNs - firstOffset_) / speed_));
+        while (running) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= due) return true;
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                due - now, std::chrono::milliseconds(250)));
+        }
+        return false;
+    }
+
+    double speed() const { return speed_; }
+
+private:
+    double speed_;
+    bool anchored_ = false;
+    std::int64_t firstOffset_ = 0;
+    std::chrono::steady_clock::time_point started_;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <system_error>
+
+// -------------------------------------------------------------------------
+// JSON numbers to double, for the market decoder (CoinSchema.h).
+//
+// Prices, caps, volumes and supplies are most of a /coins/markets body.
+// strtod pays for locale lookups and a grammar JSON does not have (hex,
+// inf, leading '+'), and it reads until it sees a terminator, which a
+// buffered object slice does not promise.
+//
+// The token is scanned once against the JSON grammar while its digits
+// are accumulated. Then:
+//   - an integer of up to 2^53 (market caps, volumes, supplies, ranks)
+//     is converted directly: exact, no floating-point arithmetic;
+//   - a mantissa of up to 2^53 with a power of ten up to 1e22 is one
+//     exact multiply or divide, which IEEE rounds correctly (Clinger's
+//     fast path) - this covers prices as CoinGecko writes them;
+//   - anything else (17+ significant digits, large exponents) goes to
+//     std::from_chars, which is correctly rounded and locale-free.
+// Every route gives the same bits strtod would in the "C" locale.
+// -------------------------------------------------------------------------
+
+namespace json_number_detail {
+
+constexpr std::uint64_t MAX_EXACT_MANTISSA = std::uint64_t(1) << 53;
+
+inline bool isDigit(char c) {
+    return static_cast<unsigned>(c - '0') <= 9;
+}
+
+} // namespace json_number_detail
+
+// Parses one JSON number starting at `begin`. Returns the end of the token,
+// or nullptr (and `out` untouched) if `begin` does not start a valid number
+// or its value is out of double range.
+inline const char* ParseJsonNumber(const char* begin, const char* end, double& out) {
+    using namespace json_number_detail;
+    static constexpr double POW10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    const char* p = begin;
+    const bool negative = p < end && *p == '-';
+    if (negative) ++p;
+    if (p == end || !isDigit(*p)) return nullptr;
+
+    // Up to 19 significant digits fit a uint64; past that only the count
+    // matters, and such tokens take the slow path anyway.
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;   // power of ten applied to mantissa
+    if (*p == '0') {
+        ++p;   // no leading zeros
+    }
+    else {
+        for (; p < end && isDigit(*p); ++p, ++digits) {
+            if (digits < 19) mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+            else ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        const char* first = ++p;
+        for (; p < end && isDigit(*p); ++p) {
+            if (mantissa == 0 && *p == '0') { --exponent; continue; }   // 0.000012: zeros are not significant
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                --exponent;
+            }
+            ++digits;
+        }
+        if (p == first) return nullptr;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        const bool negativeExp = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) ++p;
+        if (p == end || !isDigit(*p)) return nullptr;
+        int e = 0;
+        for (; p < end && isDigit(*p); ++p) {
+            if (e < 100000) e = e * 10 + (*p - '0');
+        }
+        exponent += negativeExp ? -e : e;
+    }
+
+    if (digits <= 19 && mantissa <= MAX_EXACT_MANTISSA) {
+        double value = static_cast<double>(mantissa);   // exact
+        if (exponent == 0) {
+            out = negative ? -value : value;
+            return p;
+        }
+        if (exponent >= -22 && exponent <= 22) {
+            value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+            out = negative ? -value : value;
+            return p;
+        }
+    }
+
+    // The grammar is checked, so from_chars sees exactly this token.
+    double value = 0.0;
+    const auto result = std::from_chars(begin, p, value);
+    if (result.ec != std::errc() || result.ptr != p) return nullptr;
+    out = value;
+    return p;
+}
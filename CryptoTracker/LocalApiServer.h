@@ -0,0 +1,197 @@
+#pragma once
+
+#include "DeltaFeed.h"
+#include "MarketSnapshot.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+#pragma warning(push)
+#pragma warning(disable: 4996)
+#include "httplib.h"
+#pragma warning(pop)
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+
+// -------------------------------------------------------------------------
+// Local market-data API so other tools can reuse the tracker's prices
+// instead of spending their own CoinGecko quota.
+//
+//   GET /api/v1/snapshot              current coin table (JSON)
+//   GET /api/v1/snapshot.bin          same, compact binary
+//   GET /api/v1/history/<symbol>      price history (JSON array)
+//   GET /api/v1/history/<symbol>.bin  same, compact binary
+//   GET /api/v1/stream[?since=V]      server-sent events: snapshot, then deltas
+//   GET /api/v1/deltas?since=V        long-poll: deltas after version V
+//   GET /metrics                      Prometheus text exposition
+//   GET /debug/trace                  Chrome trace-event JSON of recent spans
+//
+// Every handler works from SnapshotStore::current() and DeltaFeed, so
+// serving never waits on g_dataMutex or the fetch threads.
+//
+// httplib runs one connection per pool thread, and stream / long-poll
+// clients hold theirs open, so the pool is sized for `maxConnections`.
+// -------------------------------------------------------------------------
+class LocalApiServer {
+public:
+    LocalApiServer(const SnapshotStore& store, DeltaFeed& feed, size_t maxConnections = 256)
+        : store_(store), feed_(feed) {
+        server_.new_task_queue = [maxConnections]() {
+            return new httplib::ThreadPool(maxConnections);
+        };
+        // Headers and body go out as separate writes; without this, Nagle plus
+        // the client's delayed ACK adds ~40 ms to every keep-alive request.
+        // The listen backlog comes from CPPHTTPLIB_LISTEN_BACKLOG (set in the
+        // project); httplib's default of 5 drops SYNs when many clients connect.
+        server_.set_tcp_nodelay(true);
+
+        server_.Get("/api/v1/snapshot", [this](const httplib::Request&, httplib::Response& res) {
+            SnapshotPtr snap = store_.current();
+            res.set_header("ETag", versionTag(*snap));
+            res.set_content(snap->json, "application/json");
+        });
+
+        server_.Get("/api/v1/snapshot.bin", [this](const httplib::Request&, httplib::Response& res) {
+            SnapshotPtr snap = store_.current();
+            res.set_header("ETag", versionTag(*snap));
+            res.set_content(snap->binary, "application/octet-stream");
+        });
+
+        server_.Get(R"(/api/v1/history/([^/.]+)(\.bin)?)",
+            [this](const httplib::Request& req, httplib::Response& res) {
+                SnapshotPtr snap = store_.current();
+                auto it = snap->history.find(req.matches[1].str());
+                if (it == snap->history.end() || !it->second) {
+                    res.status = 404;
+                    res.set_content("{\"error\":\"unknown symbol\"}", "application/json");
+                    return;
+                }
+
+                if (req.matches[2].matched) {
+                    res.set_content(snapshot_codec::historyBinary(*it->second), "application/octet-stream");
+                }
+                else {
+                    res.set_content(snapshot_codec::historyJson(*it->second), "application/json");
+                }
+            });
+
+        server_.Get("/api/v1/stream", [this](const httplib::Request& req, httplib::Response& res) {
+            // Resume point: ?since=V or the standard Last-Event-ID header
+            std::string since = req.has_param("since")
+                ? req.get_param_value("since")
+                : req.get_header_value("Last-Event-ID");
+            auto cursor = std::make_shared<unsigned long long>(
+                since.empty() ? 0ULL : std::strtoull(since.c_str(), nullptr, 10));
+            auto needSnapshot = std::make_shared<bool>(since.empty());
+
+            res.set_header("Cache-Control", "no-cache");
+            res.set_chunked_content_provider("text/event-stream",
+                [this, cursor, needSnapshot](size_t, httplib::DataSink& sink) {
+                    if (*needSnapshot) {
+                        *needSnapshot = false;
+                        SnapshotPtr snap = store_.current();
+                        *cursor = snap->version;
+                        return writeSnapshotEvent(sink, *snap);
+                    }
+
+                    DeltaFeed::Batch batch = feed_.waitAfter(*cursor, std::chrono::seconds(15));
+                    if (batch.closed) {
+                        sink.done();
+                        return true;
+                    }
+                    if (batch.resync) {
+                        // Too slow to keep up: skip the backlog, start over from a full snapshot
+                        SnapshotPtr snap = store_.current();
+                        *cursor = snap->version;
+                        return writeSnapshotEvent(sink, *snap);
+                    }
+                    if (batch.messages.empty()) {
+                        return sink.write(":\n\n", 3);   // keep-alive comment
+                    }
+                    for (const auto& msg : batch.messages) {
+                        if (!sink.write(msg->sse.data(), msg->sse.size())) return false;
+                        *cursor = msg->version;
+                    }
+                    return true;
+                });
+        });
+
+        server_.Get("/api/v1/deltas", [this](const httplib::Request& req, httplib::Response& res) {
+            unsigned long long since = std::strtoull(req.get_param_value("since").c_str(), nullptr, 10);
+
+            DeltaFeed::Batch batch;
+            if (since != 0) batch = feed_.waitAfter(since, std::chrono::seconds(25));
+            if (batch.resync || since == 0) {
+                SnapshotPtr snap = store_.current();
+                res.set_content("{\"resync\":true,\"snapshot\":" + snap->json + "}", "application/json");
+                return;
+            }
+
+            std::string body = "{\"resync\":false,\"deltas\":[";
+            for (size_t i = 0; i < batch.messages.size(); ++i) {
+                if (i > 0) body += ",";
+                body += batch.messages[i]->json;
+            }
+            body += "]}";
+            res.set_content(body, "application/json");
+        });
+
+        server_.Get("/metrics", [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(metrics::registry().exposition(), "text/plain; version=0.0.4");
+        });
+
+        server_.Get("/debug/trace", [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(trace::dumpJson(), "application/json");
+        });
+    }
+
+    ~LocalApiServer() { stop(); }
+
+    LocalApiServer(const LocalApiServer&) = delete;
+    LocalApiServer& operator=(const LocalApiServer&) = delete;
+
+    // Binds and starts serving on a background thread. Port 0 picks a free port.
+    bool start(const std::string& host, int port) {
+        if (port == 0) {
+            port = server_.bind_to_any_port(host);
+            if (port <= 0) return false;
+        }
+        else if (!server_.bind_to_port(host, port)) {
+            return false;
+        }
+        port_ = port;
+        thread_ = std::thread([this]() { server_.listen_after_bind(); });
+        server_.wait_until_ready();
+        return true;
+    }
+
+    int port() const { return port_; }
+
+    void stop() {
+        feed_.shutdown();
+        server_.stop();
+        if (thread_.joinable()) thread_.join();
+    }
+
+private:
+    static std::string versionTag(const MarketSnapshot& snap) {
+        return "\"" + std::to_string(snap.version) + "\"";
+    }
+
+    // Full snapshot as one SSE event; the JSON body is the one pre-serialized at publish.
+    static bool writeSnapshotEvent(httplib::DataSink& sink, const MarketSnapshot& snap) {
+        std::string head = "id: " + std::to_string(snap.version) + "\nevent: snapshot\ndata: ";
+        return sink.write(head.data(), head.size()) &&
+            sink.write(snap.json.data(), snap.json.size()) &&
+            sink.write("\n\n", 2);
+    }
+
+    const SnapshotStore& store_;
+    DeltaFeed& feed_;
+    httplib::Server server_;
+    std::thread thread_;
+    int port_ = 0;
+};
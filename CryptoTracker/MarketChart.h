@@ -0,0 +1,134 @@
+#pragma once
+
+#include "JsonNumber.h"
+#include "PriceHistory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Incremental decoder for /coins/{id}/market_chart.
+//
+//   { "prices": [[1711843200123, 64000.5], ...],
+//     "market_caps": [...], "total_volumes": [...] }
+//
+// Only "prices" is kept: each [ms, price] pair is converted as soon as
+// its closing bracket arrives and appended to the output as a
+// HistoryPoint (epoch ns), ready for MergeBackfill (PriceHistory.h). The
+// other series are scanned past without being converted. Chunks may split
+// a pair anywhere; at most one pair is buffered.
+// -------------------------------------------------------------------------
+
+class MarketChartDecoder {
+public:
+    explicit MarketChartDecoder(std::vector<HistoryPoint>& out) : out_(out) {}
+
+    // Feeds the next chunk of the body. Returns false once the body is
+    // known to be bad, so the caller can abort the transfer early.
+    bool feed(const char* data, size_t len) {
+        for (size_t i = 0; i < len && error_.empty(); ++i) {
+            const char c = data[i];
+            if (depth_ == 3 && inPrices_) {   // inside a [ms, price] pair of "prices"
+                if (c == ']') {
+                    --depth_;
+                    decodePair();
+                    pair_.clear();
+                }
+                else if (pair_.size() < MAX_PAIR_BYTES) pair_ += c;
+                else fail("Oversized price pair.");
+                continue;
+            }
+            if (inString_) {
+                if (escape_) escape_ = false;
+                else if (c == '\\') escape_ = true;
+                else if (c == '"') inString_ = false;
+                else if (depth_ == 1 && key_.size() < 8) key_ += c;
+                continue;
+            }
+            switch (c) {
+            case '"':
+                inString_ = true;
+                if (depth_ == 1) key_.clear();
+                break;
+            case '{':
+            case '[':
+                if (depth_ == 0 && c != '{') { fail("Chart is not an object."); break; }
+                if (depth_ == 1 && c == '[') inPrices_ = key_ == "prices";
+                if (depth_ == 2 && inPrices_ && c != '[') { fail("Price point is not a pair."); break; }
+                ++depth_;
+                break;
+            case '}':
+            case ']':
+                if (depth_ == 0) { fail("Unbalanced chart."); break; }
+                if (--depth_ == 1 && inPrices_) {
+                    inPrices_ = false;
+                    havePrices_ = true;
+                }
+                if (depth_ == 0) done_ = true;
+                break;
+            case ',':
+                if (depth_ == 1) key_.clear();
+                break;
+            default:
+                break;
+            }
+        }
+        return error_.empty();
+    }
+
+    // Call after the last chunk. True if the chart was complete and had a
+    // "prices" series.
+    bool finish() {
+        if (!error_.empty()) return false;
+        if (!done_) return fail(depth_ == 0 ? "Empty chart." : "Truncated chart.");
+        if (!havePrices_) return fail("No \"prices\" in chart.");
+        return true;
+    }
+
+    const std::string& error() const { return error_; }
+    size_t pointCount() const { return points_; }
+
+private:
+    static constexpr size_t MAX_PAIR_BYTES = 64;
+
+    static const char* skipSpace(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+        return p;
+    }
+
+    // "ms, price" without the brackets. A null price (CoinGecko has gaps)
+    // drops the point.
+    void decodePair() {
+        const char* p = skipSpace(pair_.data(), pair_.data() + pair_.size());
+        const char* end = pair_.data() + pair_.size();
+        double ms = 0, price = 0;
+        p = ParseJsonNumber(p, end, ms);
+        if (p) p = skipSpace(p, end);
+        if (!p || p == end || *p != ',') { fail("Bad price pair."); return; }
+        p = skipSpace(p + 1, end);
+        if (end - p >= 4 && p[0] == 'n' && p[1] == 'u' && p[2] == 'l' && p[3] == 'l') return;
+        p = ParseJsonNumber(p, end, price);
+        if (!p || skipSpace(p, end) != end) { fail("Bad price pair."); return; }
+        out_.push_back({ static_cast<std::int64_t>(ms) * 1000000, price });
+        ++points_;
+    }
+
+    bool fail(std::string msg) {
+        if (error_.empty()) error_ = std::move(msg);
+        return false;
+    }
+
+    std::vector<HistoryPoint>& out_;
+    std::string pair_;   // text of the current pair
+    std::string key_;    // current top-level key
+    int depth_ = 0;
+    bool inString_ = false;
+    bool escape_ = false;
+    bool inPrices_ = false;
+    bool havePrices_ = false;
+    bool done_ = false;
+    size_t points_ = 0;
+    std::string error_;
+};
@@ -0,0 +1,560 @@
+#pragma once
+
+#include "APIClient.h"
+#include "JsonNumber.h"
+#include "RequestBroker.h"
+#include "TrackerMetrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Market data from more than one provider, with hedged requests.
+//
+// A provider answers /coins/markets paths (MARKETS_PATH, idsPath) with
+// CoinGecko-shaped rows: CoinGecko itself, or an adapter over another
+// API (TickerAdapter: a Binance-style 24h ticker that refreshes prices
+// of rows CoinGecko sent earlier).
+//
+// HedgedProviders sends a request to the healthiest provider. If the
+// reply takes longer than that provider's usual latency (a percentile of
+// its recent successful requests), the next provider is asked as well and
+// the first good reply wins; a provider that fails is followed straight
+// away by the next. A hedge never goes to the same provider twice, so it
+// costs no extra CoinGecko quota. Health is success rate and latency per
+// provider; after a few failures in a row a provider sits out a cool-down.
+// The losing request runs to completion in the background so its latency
+// still counts. Requests run on a small fixed set of worker threads.
+// -------------------------------------------------------------------------
+
+// One source of /coins/markets rows.
+struct MarketProvider {
+    std::string name;
+    std::function<std::vector<CryptoCoin>(const std::string& path, std::string& statusMsg, FetchStats* stats)> coins;
+    double costFactor = 1.0;   // > 1: a provider with partial data is only preferred when this much faster
+    // Called when another provider's reply was used for `path`, including
+    // after this provider's own (losing) request finishes; optional.
+    std::function<void(const std::string& path)> replaced;
+};
+
+struct HedgeOptions {
+    double hedgePercentile = 0.95;                                      // of the asked provider's recent latencies
+    std::chrono::milliseconds defaultHedgeDelay{ 1500 };                // until a provider has minSamples
+    std::chrono::milliseconds minHedgeDelay{ 20 };
+    size_t minSamples = 8;
+    int failuresToCool = 3;                                             // in a row
+    std::chrono::milliseconds coolDown{ 30000 };
+    size_t workers = 4;                                                 // threads running requests, shared by all providers
+};
+
+// What status() reports per provider, in preference order.
+struct ProviderStatus {
+    std::string name;
+    double successRate = 1.0;   // smoothed
+    double p50Ms = 0.0;         // recent successful requests (0 until any)
+    double p95Ms = 0.0;
+    unsigned long long requests = 0;
+    unsigned long long failures = 0;
+    unsigned long long wins = 0;   // replies that were used
+    bool cooling = false;
+};
+
+struct HedgeStats {
+    unsigned long long fetches = 0;
+    unsigned long long hedges = 0;      // second provider asked because the first was slow
+    unsigned long long failovers = 0;   // next provider asked because the first failed
+};
+
+class HedgedProviders {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit HedgedProviders(std::vector<MarketProvider> providers, HedgeOptions options = HedgeOptions())
+        : providers_(std::move(providers)), health_(providers_.size()), options_(options) {
+        for (size_t i = 0; i < std::max<size_t>(options_.workers, 1); ++i) workers_.emplace_back([this] { work(); });
+    }
+
+    HedgedProviders(const HedgedProviders&) = delete;
+    HedgedProviders& operator=(const HedgedProviders&) = delete;
+
+    // Waits for requests still running (losers of a race).
+    ~HedgedProviders() {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex_);
+            stopping_ = true;
+        }
+        jobsReady_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    // Same contract as APIClient::fetchPath. On failure statusMsg names
+    // every provider that was tried.
+    std::vector<CryptoCoin> fetch(const std::string& path, std::string& statusMsg, FetchStats* stats = nullptr) {
+        const std::vector<size_t> order = ranking();
+        auto race = std::make_shared<Race>();
+        {
+            std::lock_guard<std::mutex> lock(healthMutex_);
+            ++hedgeStats_.fetches;
+        }
+
+        size_t next = 0;
+        std::unique_lock<std::mutex> lock(race->mutex);
+        auto settled = [&race] { return race->winner != NONE || race->running == 0; };
+        start(order[next++], path, race);
+        while (race->winner == NONE) {
+            if (race->running == 0) {   // all asked so far failed
+                if (next == order.size()) break;
+                count(&HedgeStats::failovers);
+                trackerMetrics().providerFailovers.add();
+                start(order[next++], path, race);
+                continue;
+            }
+            if (next == order.size()) {
+                race->done.wait(lock, settled);
+                continue;
+            }
+            if (!race->done.wait_for(lock, hedgeDelay(order[next - 1]), settled)) {
+                count(&HedgeStats::hedges);
+                trackerMetrics().providerHedges.add();
+                start(order[next++], path, race);
+            }
+        }
+
+        if (race->winner == NONE) {
+            statusMsg = "All providers failed: " + race->failures;
+            if (stats) *stats = FetchStats();
+            return std::vector<CryptoCoin>();
+        }
+        {
+            std::lock_guard<std::mutex> healthLock(healthMutex_);
+            ++health_[race->winner].wins;
+        }
+        for (size_t i = 0; i < providers_.size(); ++i) {
+            if (i != race->winner && providers_[i].replaced) providers_[i].replaced(path);
+        }
+        statusMsg = race->statusMsg;
+        if (stats) *stats = race->stats;
+        return std::move(race->coins);
+    }
+
+    std::vector<ProviderStatus> status() const {
+        std::vector<ProviderStatus> out;
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(healthMutex_);
+        for (size_t i : rankingLocked(now)) {
+            const Health& h = health_[i];
+            ProviderStatus s;
+            s.name = providers_[i].name;
+            s.successRate = h.successRate;
+            s.p50Ms = h.percentileMs(0.5);
+            s.p95Ms = h.percentileMs(0.95);
+            s.requests = h.requests;
+            s.failures = h.failures;
+            s.wins = h.wins;
+            s.cooling = now < h.coolUntil;
+            out.push_back(s);
+        }
+        return out;
+    }
+
+    HedgeStats hedgeStats() const {
+        std::lock_guard<std::mutex> lock(healthMutex_);
+        return hedgeStats_;
+    }
+
+    // `base` with its coin requests going through the providers (charts
+    // stay with `base`), for RequestBroker.
+    BrokerUpstream upstream(BrokerUpstream base) {
+        base.coins = [this](const std::string& path, std::string& statusMsg, FetchStats* stats) {
+            return fetch(path, statusMsg, stats);
+        };
+        return base;
+    }
+
+private:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+    static constexpr size_t LATENCY_WINDOW = 64;
+
+    struct Health {
+        std::vector<double> latenciesMs;   // ring of recent successful requests
+        size_t nextSlot = 0;
+        double successRate = 1.0;
+        int failuresInRow = 0;
+        Clock::time_point coolUntil{};
+        unsigned long long requests = 0, failures = 0, wins = 0;
+
+        double percentileMs(double p) const {
+            if (latenciesMs.empty()) return 0.0;
+            std::vector<double> sorted = latenciesMs;
+            const size_t at = std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())));
+            std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(at), sorted.end());
+            return sorted[at];
+        }
+    };
+
+    // One request and the attempts racing for it. Guarded by its mutex.
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable done;
+        int running = 0;
+        size_t winner = NONE;
+        std::vector<CryptoCoin> coins;
+        std::string statusMsg;
+        FetchStats stats;
+        std::string failures;   // "name: why; ..."
+    };
+
+    struct Job {
+        size_t provider;
+        std::string path;
+        std::shared_ptr<Race> race;
+    };
+
+    void count(unsigned long long HedgeStats::*field) {
+        std::lock_guard<std::mutex> lock(healthMutex_);
+        ++(hedgeStats_.*field);
+    }
+
+    // Provider indices, best first: cooling providers last, then by
+    // expected latency (median, scaled by cost and failure rate).
+    std::vector<size_t> ranking() const {
+        std::lock_guard<std::mutex> lock(healthMutex_);
+        return rankingLocked(Clock::now());
+    }
+
+    std::vector<size_t> rankingLocked(Clock::time_point now) const {
+        std::vector<double> expected(providers_.size());
+        for (size_t i = 0; i < providers_.size(); ++i) {
+            const Health& h = health_[i];
+            const double ms = h.latenciesMs.size() >= options_.minSamples
+                ? h.percentileMs(0.5) : static_cast<double>(options_.defaultHedgeDelay.count());
+            expected[i] = ms * providers_[i].costFactor / std::max(h.successRate, 0.05);
+            if (now < h.coolUntil) expected[i] += 1e12;
+        }
+        std::vector<size_t> order(providers_.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&expected](size_t a, size_t b) { return expected[a] < expected[b]; });
+        return order;
+    }
+
+    // How long to give provider `i` before asking the next one.
+    Clock::duration hedgeDelay(size_t i) const {
+        std::lock_guard<std::mutex> lock(healthMutex_);
+        const Health& h = health_[i];
+        if (h.latenciesMs.size() < options_.minSamples) return options_.defaultHedgeDelay;
+        const auto delay = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(h.percentileMs(options_.hedgePercentile)));
+        return std::max<Clock::duration>(delay, options_.minHedgeDelay);
+    }
+
+    void record(size_t i, bool ok, double ms) {
+        std::lock_guard<std::mutex> lock(healthMutex_);
+        Health& h = health_[i];
+        ++h.requests;
+        h.successRate = 0.8 * h.successRate + (ok ? 0.2 : 0.0);
+        if (ok) {
+            h.failuresInRow = 0;
+            if (h.latenciesMs.size() < LATENCY_WINDOW) h.latenciesMs.push_back(ms);
+            else h.latenciesMs[h.nextSlot] = ms;
+            h.nextSlot = (h.nextSlot + 1) % LATENCY_WINDOW;
+            return;
+        }
+        ++h.failures;
+        if (++h.failuresInRow >= options_.failuresToCool) {
+            h.coolUntil = Clock::now() + options_.coolDown;
+            h.failuresInRow = 0;
+        }
+    }
+
+    // Queues a request to provider `i`. Caller holds race->mutex.
+    void start(size_t i, const std::string& path, const std::shared_ptr<Race>& race) {
+        ++race->running;
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex_);
+            jobs_.push_back({ i, path, race });
+        }
+        jobsReady_.notify_one();
+    }
+
+    void work() {
+        CT_TRACE_THREAD_NAME("MarketProvider");
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(jobsMutex_);
+                jobsReady_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            run(job);
+        }
+    }
+
+    void run(const Job& job) {
+        const size_t i = job.provider;
+        Race& race = *job.race;
+        {
+            // Queued behind a slow request and the race is already won
+            std::lock_guard<std::mutex> lock(race.mutex);
+            if (race.winner != NONE) {
+                --race.running;
+                return;
+            }
+        }
+
+        FetchStats stats;
+        std::string statusMsg;
+        const auto started = Clock::now();
+        std::vector<CryptoCoin> coins;
+        try {
+            coins = providers_[i].coins(job.path, statusMsg, &stats);
+        }
+        catch (const std::exception& e) {
+            coins.clear();
+            statusMsg = std::string("[PROVIDER EXCEPTION] ") + e.what();
+        }
+        const bool ok = !coins.empty() || stats.notModified;
+        record(i, ok, std::chrono::duration<double, std::milli>(Clock::now() - started).count());
+
+        bool lost = false;
+        {
+            std::lock_guard<std::mutex> lock(race.mutex);
+            --race.running;
+            if (ok && race.winner == NONE) {
+                race.winner = i;
+                race.coins = std::move(coins);
+                race.statusMsg = std::move(statusMsg);
+                race.stats = stats;
+            }
+            else if (!ok) {
+                if (!race.failures.empty()) race.failures += "; ";
+                race.failures += providers_[i].name + ": " + statusMsg;
+            }
+            lost = race.winner != NONE && race.winner != i;
+        }
+        race.done.notify_all();
+        // fetch() tells the losers when it takes the winner's reply; this
+        // one may have finished later and kept state for its own reply
+        if (lost && providers_[i].replaced) providers_[i].replaced(job.path);
+    }
+
+    std::vector<MarketProvider> providers_;
+    std::vector<Health> health_;   // parallel to providers_
+    HedgeOptions options_;
+    mutable std::mutex healthMutex_;
+    HedgeStats hedgeStats_;
+    std::mutex jobsMutex_;
+    std::condition_variable jobsReady_;
+    std::deque<Job> jobs_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;   // last: started after everything they use
+};
+
+// -------------------------------------------------------------------------
+// Binance-style 24h ticker (GET /api/v3/ticker/24hr) as a market
+// provider. An exchange knows prices, not coins: the adapter keeps the
+// rows CoinGecko sent last (remember()) and answers a markets path with
+// those rows repriced from the ticker of SYMBOL + quote, e.g. "BTCUSDT".
+// A coin the exchange does not list keeps its CoinGecko row (and its
+// last_updated, so the history does not take it twice). The whole ticker
+// list is requested: a symbols= filter fails the request outright if one
+// symbol is not listed.
+// -------------------------------------------------------------------------
+class TickerAdapter {
+public:
+    static constexpr const char* TICKER_PATH = "/api/v3/ticker/24hr";
+
+    struct Ticker {
+        double last = 0.0;
+        double changePercent = 0.0;
+        double high = CoinMarketExtras::NONE;
+        double low = CoinMarketExtras::NONE;
+        double quoteVolume = CoinMarketExtras::NONE;
+        std::int64_t closeTime = 0;   // epoch ns
+    };
+
+    // `tls`: HTTPS (the exchange) or plain HTTP (a local mock).
+    TickerAdapter(std::string host, int port, bool tls, std::string quote = "USDT")
+        : host_(std::move(host)), port_(port), tls_(tls), quote_(std::move(quote)) {}
+
+    // Rows from CoinGecko for `path`; a full list also sets the order a
+    // full markets path is answered in.
+    void remember(const std::string& path, const std::vector<CryptoCoin>& coins) {
+        if (coins.empty()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (path.find("&ids=") == std::string::npos) {
+            fullList_.clear();
+            for (const auto& coin : coins) fullList_.push_back(coin.id);
+        }
+        for (const auto& coin : coins) rows_[coin.id] = coin;
+    }
+
+    std::vector<CryptoCoin> fetch(const std::string& path, std::string& statusMsg, FetchStats* stats = nullptr) {
+        const auto started = std::chrono::steady_clock::now();
+        std::vector<CryptoCoin> coins;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& id : requestedIds(path)) {
+                auto row = rows_.find(id);
+                if (row != rows_.end()) coins.push_back(row->second);
+            }
+        }
+        if (coins.empty()) {
+            statusMsg = "[TICKER] No CoinGecko rows to reprice yet.";
+            return coins;
+        }
+
+        std::string body;
+        int status = 0;
+        try {
+            if (tls_) {
+                httplib::SSLClient cli(host_, port_);   // default certificate checks apply
+                get(cli, status, body, statusMsg);
+            }
+            else {
+                httplib::Client cli(host_, port_);
+                get(cli, status, body, statusMsg);
+            }
+        }
+        catch (const std::exception& e) {
+            statusMsg = std::string("[TICKER EXCEPTION] ") + e.what();
+            return std::vector<CryptoCoin>();
+        }
+        if (status != 200) {
+            if (status != 0) statusMsg = "[TICKER] HTTP " + std::to_string(status) + " from " + host_ + ".";
+            return std::vector<CryptoCoin>();
+        }
+
+        std::unordered_map<std::string, Ticker> tickers;
+        if (!parseTickers(body, tickers, statusMsg)) return std::vector<CryptoCoin>();
+        for (auto& coin : coins) {
+            auto t = tickers.find(tickerSymbol(coin.symbol));
+            if (t == tickers.end()) continue;
+            if (coin.current_price > 0.0) coin.market_cap *= t->second.last / coin.current_price;   // same supply
+            coin.current_price = t->second.last;
+            coin.price_change_24h = t->second.changePercent;
+            coin.extras.high_24h = t->second.high;
+            coin.extras.low_24h = t->second.low;
+            coin.extras.total_volume = t->second.quoteVolume;
+            if (t->second.closeTime != 0) coin.extras.last_updated = t->second.closeTime;
+        }
+        if (stats) {
+            *stats = FetchStats();
+            stats->bytesReceived = stats->bytesOnWire = body.size();
+            stats->totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        }
+        statusMsg = "Live Data: prices via " + host_ + " ticker";
+        return coins;
+    }
+
+    std::string tickerSymbol(const std::string& coinSymbol) const {
+        std::string symbol = coinSymbol;
+        for (char& c : symbol) {
+            if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        }
+        return symbol + quote_;
+    }
+
+    // The exchange sends numbers as strings ("64000.10000000").
+    static bool parseTickers(const std::string& body, std::unordered_map<std::string, Ticker>& out,
+        std::string& error) {
+        const nlohmann::json doc = nlohmann::json::parse(body, nullptr, false);
+        if (!doc.is_array()) {
+            error = "[TICKER] Response is not a list.";
+            return false;
+        }
+        auto number = [](const nlohmann::json& item, const char* key, double& value) {
+            auto it = item.find(key);
+            if (it == item.end()) return false;
+            if (it->is_number()) {
+                value = it->get<double>();
+                return true;
+            }
+            if (!it->is_string()) return false;
+            const std::string& text = it->get_ref<const std::string&>();
+            return ParseJsonNumber(text.data(), text.data() + text.size(), value) == text.data() + text.size();
+        };
+        for (const auto& item : doc) {
+            auto symbol = item.find("symbol");
+            Ticker t;
+            if (symbol == item.end() || !symbol->is_string() || !number(item, "lastPrice", t.last)) continue;
+            number(item, "priceChangePercent", t.changePercent);
+            number(item, "highPrice", t.high);
+            number(item, "lowPrice", t.low);
+            number(item, "quoteVolume", t.quoteVolume);
+            auto close = item.find("closeTime");
+            if (close != item.end() && close->is_number_integer()) t.closeTime = close->get<std::int64_t>() * 1000000;
+            out[symbol->get<std::string>()] = t;
+        }
+        return true;
+    }
+
+private:
+    // Coin ids a markets path asks for: its ids= list, or the full list.
+    // Caller holds mutex_.
+    std::vector<std::string> requestedIds(const std::string& path) const {
+        const size_t at = path.find("&ids=");
+        if (at == std::string::npos) return fullList_;
+        std::vector<std::string> ids;
+        const size_t end = std::min(path.find('&', at + 5), path.size());
+        for (size_t i = at + 5; i < end;) {
+            size_t comma = path.find("%2C", i);
+            if (comma == std::string::npos || comma > end) comma = end;
+            ids.push_back(path.substr(i, comma - i));
+            i = comma == end ? end : comma + 3;
+        }
+        return ids;
+    }
+
+    template <typename Client>
+    static void get(Client& cli, int& status, std::string& body, std::string& statusMsg) {
+        cli.set_connection_timeout(5);
+        cli.set_read_timeout(5, 0);
+        auto res = cli.Get(TICKER_PATH);
+        if (!res) {
+            statusMsg = "[TICKER] " + httplib::to_string(res.error());
+            return;
+        }
+        status = res->status;
+        body = std::move(res->body);
+    }
+
+    std::string host_;
+    int port_;
+    bool tls_;
+    std::string quote_;
+    std::mutex mutex_;
+    std::vector<std::string> fullList_;                    // ids of the last full list, in order
+    std::unordered_map<std::string, CryptoCoin> rows_;     // by id
+};
+
+// CoinGecko first; an exchange ticker as hedge and fallback for prices.
+// `upstream.coins` is where CoinGecko requests go (the benchmarks' mock).
+inline std::vector<MarketProvider> DefaultProviders(const std::shared_ptr<TickerAdapter>& ticker,
+    BrokerUpstream upstream = BrokerUpstream::coinGecko()) {
+    MarketProvider coinGecko{ "CoinGecko",
+        [ticker, fetch = std::move(upstream.coins)](const std::string& path, std::string& statusMsg, FetchStats* stats) {
+            std::vector<CryptoCoin> coins = fetch(path, statusMsg, stats);
+            ticker->remember(path, coins);
+            return coins;
+        }, 1.0,
+        // a 304 must not be taken for rows the app got from the exchange
+        [](const std::string& path) { APIClient::forgetValidators(path); } };
+    MarketProvider exchange{ "Binance",
+        [ticker](const std::string& path, std::string& statusMsg, FetchStats* stats) {
+            return ticker->fetch(path, statusMsg, stats);
+        }, 2.0 };   // prices only: names, caps and supplies stay as CoinGecko last sent them
+    return { coinGecko, exchange };
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "json.hpp"
+#include "CryptoData.h"
+#include "Currency.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Immutable, published view of the market data.
+//
+// The fetch lanes mutate g_coins / g_priceHistory under g_dataMutex. After
+// each update they capture a MarketSnapshot, and SnapshotStore swaps it in
+// through an atomic shared_ptr. Readers on other threads (local API, ...)
+// just load the pointer and never touch g_dataMutex. The response bodies
+// are serialized once per snapshot, not once per request.
+// -------------------------------------------------------------------------
+struct MarketSnapshot {
+    unsigned long long version = 0;
+    std::chrono::system_clock::time_point publishedAt;
+    std::vector<CryptoCoin> coins;
+
+    // Price history by symbol. Unchanged coins share the vector with the
+    // previous snapshot, so publishing only copies what actually moved.
+    std::unordered_map<std::string, std::shared_ptr<const std::vector<float>>> history;
+
+    // Prices and market caps in DISPLAY_CURRENCIES (null until first capture)
+    std::shared_ptr<const CurrencyColumns> currencies;
+
+    std::string json;     // pre-serialized snapshot (JSON)
+    std::string binary;   // pre-serialized snapshot (compact binary, see below)
+};
+
+using SnapshotPtr = std::shared_ptr<const MarketSnapshot>;
+
+// ---------------------------------------------------------------------
+// Compact binary layout (all little-endian):
+//   "CTS1"  u64 version  u32 count
+//   per coin: u8 len + id, u8 len + symbol, u8 len + name,
+//             f64 price, f64 change_24h, f64 market_cap
+// History: "CTH1" u32 count, then count x f32.
+// ---------------------------------------------------------------------
+namespace snapshot_codec {
+
+inline void putBytes(std::string& out, const void* data, size_t len) {
+    out.append(static_cast<const char*>(data), len);
+}
+
+template <typename T>
+inline void putValue(std::string& out, T value) {
+    putBytes(out, &value, sizeof(value));   // x86/x64 are little-endian
+}
+
+inline void putShortString(std::string& out, const std::string& s) {
+    size_t len = s.size() < 255 ? s.size() : 255;
+    putValue(out, static_cast<std::uint8_t>(len));
+    putBytes(out, s.data(), len);
+}
+
+inline std::string toJson(const MarketSnapshot& snap) {
+    nlohmann::json coins = nlohmann::json::array();
+    for (const auto& coin : snap.coins) {
+        coins.push_back({
+            { "id", coin.id },
+            { "symbol", coin.symbol },
+            { "name", coin.name },
+            { "current_price", coin.current_price },
+            { "price_change_percentage_24h", coin.price_change_24h },
+            { "market_cap", coin.market_cap },
+        });
+    }
+
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        snap.publishedAt.time_since_epoch()).count();
+
+    nlohmann::json doc = {
+        { "version", snap.version },
+        { "published_at_ms", millis },
+        { "coins", std::move(coins) },
+    };
+    // Multipliers from the coins' (base currency) amounts, for clients that
+    // display other currencies; unknown rates are left out.
+    if (snap.currencies) {
+        nlohmann::json fx = nlohmann::json::object();
+        for (size_t c = 0; c < snap.currencies->currencies() && c < DISPLAY_CURRENCY_COUNT; ++c) {
+            const double factor = snap.currencies->factors[c];
+            if (std::isfinite(factor)) fx[DISPLAY_CURRENCIES[c].code] = factor;
+        }
+        doc["base_currency"] = BASE_CURRENCY;
+        doc["fx"] = std::move(fx);
+    }
+    return doc.dump();
+}
+
+inline std::string toBinary(const MarketSnapshot& snap) {
+    std::string out;
+    out.reserve(16 + snap.coins.size() * 64);
+    putBytes(out, "CTS1", 4);
+    putValue(out, static_cast<std::uint64_t>(snap.version));
+    putValue(out, static_cast<std::uint32_t>(snap.coins.size()));
+    for (const auto& coin : snap.coins) {
+        putShortString(out, coin.id);
+        putShortString(out, coin.symbol);
+        putShortString(out, coin.name);
+        putValue(out, coin.current_price);
+        putValue(out, coin.price_change_24h);
+        putValue(out, coin.market_cap);
+    }
+    return out;
+}
+
+inline std::string historyJson(const std::vector<float>& points) {
+    return nlohmann::json(points).dump();
+}
+
+inline std::string historyBinary(const std::vector<float>& points) {
+    std::string out;
+    out.reserve(8 + points.size() * sizeof(float));
+    putBytes(out, "CTH1", 4);
+    putValue(out, static_cast<std::uint32_t>(points.size()));
+    putBytes(out, points.data(), points.size() * sizeof(float));
+    return out;
+}
+
+} // namespace snapshot_codec
+
+class SnapshotStore {
+public:
+    // Called with (previous, new) for every snapshot that becomes current,
+    // in version order, on the publishing thread.
+    using Listener = std::function<void(const MarketSnapshot&, const MarketSnapshot&)>;
+
+    SnapshotStore() : current_(std::make_shared<MarketSnapshot>()) {}
+
+    // Set before the fetch threads start.
+    void setListener(Listener listener) { listener_ = std::move(listener); }
+
+    // Readers never wait on writers or g_dataMutex: one atomic shared_ptr load.
+    SnapshotPtr current() const { return std::atomic_load(&current_); }
+
+    // Serializes the snapshot and makes it current. Snapshots can be captured
+    // by two fetch lanes and arrive here out of order; an older one is dropped.
+    void publish(std::shared_ptr<MarketSnapshot> snap) {
+        snap->publishedAt = std::chrono::system_clock::now();
+        snap->json = snapshot_codec::toJson(*snap);
+        snap->binary = snapshot_codec::toBinary(*snap);
+
+        std::lock_guard<std::mutex> lock(writerMutex_);   // writers only
+        SnapshotPtr prev = current();
+        if (snap->version <= prev->version) return;
+
+        SnapshotPtr next(std::move(snap));
+        std::atomic_store(&current_, next);
+        if (listener_) listener_(*prev, *next);
+    }
+
+private:
+    std::mutex writerMutex_;
+    SnapshotPtr current_;
+    Listener listener_;
+};
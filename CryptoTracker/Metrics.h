@@ -0,0 +1,244 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// -------------------------------------------------------------------------
+// Low-overhead metrics with a Prometheus text exporter.
+//
+// Recording is a relaxed atomic add (counters, histogram buckets) or a
+// relaxed store (gauges): lock-free and allocation-free, safe from any
+// thread. Metrics are created once and registered with the registry. Only
+// registration and export take the registry mutex.
+//
+// Histograms use HDR-style log-linear buckets over nanoseconds: 8 linear
+// sub-buckets per power of two, so any recorded value is within 12.5% of
+// its bucket bounds from 1ns up to hours, in a fixed 4KB array.
+// -------------------------------------------------------------------------
+namespace metrics {
+
+class Counter {
+public:
+    void add(std::uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value_{ 0 };
+};
+
+class Gauge {
+public:
+    void set(double v) { value_.store(v, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{ 0.0 };
+};
+
+class Histogram {
+public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKETS = SUB_COUNT + (64 - SUB_BITS) * SUB_COUNT;
+
+    void recordNanos(std::uint64_t ns) {
+        buckets_[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sumNs_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> d) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        recordNanos(ns > 0 ? static_cast<std::uint64_t>(ns) : 0);
+    }
+
+    std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    std::uint64_t sumNanos() const { return sumNs_.load(std::memory_order_relaxed); }
+
+    // Approximate quantile (q in 0..1), reported as the bucket's upper bound.
+    std::uint64_t quantileNanos(double q) const {
+        std::uint64_t total = count();
+        if (total == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(q * (total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return upperBound(i);
+        }
+        return upperBound(BUCKETS - 1);
+    }
+
+    std::uint64_t bucketCount(int i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+    static int bucketOf(std::uint64_t v) {
+        if (v < SUB_COUNT) return static_cast<int>(v);
+        int exp = 63 - countLeadingZeros(v);   // >= SUB_BITS
+        int sub = static_cast<int>((v >> (exp - SUB_BITS)) & (SUB_COUNT - 1));
+        return SUB_COUNT + (exp - SUB_BITS) * SUB_COUNT + sub;
+    }
+
+    // Exclusive upper bound of bucket i, in nanoseconds.
+    static std::uint64_t upperBound(int i) {
+        if (i < SUB_COUNT) return static_cast<std::uint64_t>(i) + 1;
+        int exp = (i - SUB_COUNT) / SUB_COUNT + SUB_BITS;
+        int sub = (i - SUB_COUNT) % SUB_COUNT;
+        std::uint64_t top = static_cast<std::uint64_t>(SUB_COUNT + sub + 1) << (exp - SUB_BITS);
+        return top == 0 ? UINT64_MAX : top;
+    }
+
+private:
+    static int countLeadingZeros(std::uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return 63 - static_cast<int>(index);
+#else
+        return __builtin_clzll(v);
+#endif
+    }
+
+    std::array<std::atomic<std::uint64_t>, BUCKETS> buckets_{};
+    std::atomic<std::uint64_t> count_{ 0 };
+    std::atomic<std::uint64_t> sumNs_{ 0 };
+};
+
+// Measures the enclosing scope into a histogram.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& h) : hist_(h), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { hist_.record(std::chrono::steady_clock::now() - start_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& hist_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+class Registry {
+public:
+    // `labels` is the inside of {...}, e.g. phase="parse"; metrics sharing a
+    // name are exported as one family.
+    void add(const std::string& name, const std::string& help, const std::string& labels, Counter& c) {
+        addEntry({ name, help, labels, Kind::Counter, &c, nullptr, nullptr });
+    }
+    void add(const std::string& name, const std::string& help, const std::string& labels, Gauge& g) {
+        addEntry({ name, help, labels, Kind::Gauge, nullptr, &g, nullptr });
+    }
+    void add(const std::string& name, const std::string& help, const std::string& labels, Histogram& h) {
+        addEntry({ name, help, labels, Kind::Histogram, nullptr, nullptr, &h });
+    }
+
+    // Prometheus text exposition format 0.0.4. Histograms are exported in
+    // seconds with one bucket per power of two.
+    std::string exposition() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string out;
+        out.reserve(entries_.size() * 256);
+
+        std::string lastFamily;
+        for (const auto& e : entries_) {
+            if (e.name != lastFamily) {
+                out += "# HELP " + e.name + " " + e.help + "\n";
+                out += "# TYPE " + e.name + " " + kindName(e.kind) + "\n";
+                lastFamily = e.name;
+            }
+
+            switch (e.kind) {
+            case Kind::Counter:
+                out += e.name + braces(e.labels) + " " + std::to_string(e.counter->value()) + "\n";
+                break;
+            case Kind::Gauge:
+                out += e.name + braces(e.labels) + " " + number(e.gauge->value()) + "\n";
+                break;
+            case Kind::Histogram:
+                appendHistogram(out, e);
+                break;
+            }
+        }
+        return out;
+    }
+
+private:
+    enum class Kind { Counter, Gauge, Histogram };
+
+    struct Entry {
+        std::string name;
+        std::string help;
+        std::string labels;
+        Kind kind;
+        Counter* counter;
+        Gauge* gauge;
+        Histogram* histogram;
+    };
+
+    void addEntry(Entry e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Keep families together for the exporter
+        auto pos = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->name == e.name) pos = it + 1;
+        }
+        entries_.insert(pos, std::move(e));
+    }
+
+    static const char* kindName(Kind k) {
+        switch (k) {
+        case Kind::Counter: return "counter";
+        case Kind::Gauge: return "gauge";
+        default: return "histogram";
+        }
+    }
+
+    static std::string braces(const std::string& labels) {
+        return labels.empty() ? std::string() : "{" + labels + "}";
+    }
+
+    static std::string number(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.9g", v);
+        return buf;
+    }
+
+    static void appendHistogram(std::string& out, const Entry& e) {
+        const Histogram& h = *e.histogram;
+        const std::string sep = e.labels.empty() ? "" : ",";
+
+        // Sub-buckets are folded into power-of-two "le" bounds
+        std::uint64_t cumulative = 0;
+        int i = 0;
+        for (int exp = 0; exp < 40; ++exp) {   // 1ns .. ~18 minutes
+            std::uint64_t bound = 1ULL << exp;
+            while (i < Histogram::BUCKETS && Histogram::upperBound(i) <= bound) {
+                cumulative += h.bucketCount(i++);
+            }
+            out += e.name + "_bucket{" + e.labels + sep + "le=\"" + number(bound / 1e9) + "\"} "
+                + std::to_string(cumulative) + "\n";
+        }
+        out += e.name + "_bucket{" + e.labels + sep + "le=\"+Inf\"} " + std::to_string(h.count()) + "\n";
+        out += e.name + "_sum" + braces(e.labels) + " " + number(h.sumNanos() / 1e9) + "\n";
+        out += e.name + "_count" + braces(e.labels) + " " + std::to_string(h.count()) + "\n";
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+inline Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+} // namespace metrics
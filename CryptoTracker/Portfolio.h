@@ -0,0 +1,264 @@
+#pragma once
+
+#include "MarketSnapshot.h"   // snapshot_codec::putValue / putShortString
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Named watchlists and portfolios, valued incrementally.
+//
+// Coin ids are interned once; every portfolio keeps its total value and
+// cost. A reverse index (coin -> holdings of that coin) lets updatePrice()
+// touch only the holdings of the coin that moved:
+//     value += quantity * (new price - old price)
+// so a refresh costs O(holdings of the changed coins), not a scan of every
+// holding. To keep rounding from drifting, a portfolio is revalued exactly
+// after REVALUE_AFTER incremental updates.
+//
+// A watchlist is a portfolio whose entries have no quantity; it is kept in
+// the same structure so both share one persistence format.
+//
+// Not thread-safe: the app guards it with g_dataMutex.
+// -------------------------------------------------------------------------
+
+struct Holding {
+    std::uint32_t coin = 0;    // PortfolioBook::coinId(coin)
+    double quantity = 0.0;
+    double costBasis = 0.0;    // total paid, USD
+};
+
+struct Portfolio {
+    std::string name;
+    bool watchlist = false;
+    std::vector<Holding> holdings;
+
+    double value = 0.0;        // sum of quantity x price, kept up to date
+    double cost = 0.0;         // sum of cost basis
+    std::uint32_t updatesSinceRevalue = 0;
+
+    double pnl() const { return value - cost; }
+    double pnlPercent() const { return cost != 0.0 ? (value - cost) / cost * 100.0 : 0.0; }
+};
+
+class PortfolioBook {
+public:
+    static constexpr std::uint32_t REVALUE_AFTER = 4096;
+
+    size_t addPortfolio(std::string name, bool watchlist = false) {
+        Portfolio p;
+        p.name = std::move(name);
+        p.watchlist = watchlist;
+        portfolios_.push_back(std::move(p));
+        return portfolios_.size() - 1;
+    }
+
+    // Adds a holding (or, for a watchlist, an entry; quantity and cost are ignored).
+    void addHolding(size_t portfolio, const std::string& coinId, double quantity = 0.0, double costBasis = 0.0) {
+        Portfolio& p = portfolios_[portfolio];
+        if (p.watchlist) quantity = costBasis = 0.0;
+        std::uint32_t coin = intern(coinId);
+        p.holdings.push_back({ coin, quantity, costBasis });
+        holders_[coin].push_back({ static_cast<std::uint32_t>(portfolio), static_cast<std::uint32_t>(p.holdings.size() - 1) });
+        p.value += quantity * prices_[coin];
+        p.cost += costBasis;
+    }
+
+    // Rare (user action): rebuilds the reverse index.
+    void removeHolding(size_t portfolio, size_t holding) {
+        Portfolio& p = portfolios_[portfolio];
+        p.holdings.erase(p.holdings.begin() + holding);
+        revalue(portfolio);
+        rebuildIndex();
+    }
+
+    void removePortfolio(size_t portfolio) {
+        portfolios_.erase(portfolios_.begin() + portfolio);
+        rebuildIndex();
+    }
+
+    // O(holdings of this coin). Unknown coins (held nowhere) are ignored.
+    void updatePrice(const std::string& coinId, double price) {
+        auto it = coinIndex_.find(coinId);
+        if (it == coinIndex_.end()) return;
+        const std::uint32_t coin = it->second;
+        const double delta = price - prices_[coin];
+        if (delta == 0.0) return;
+        prices_[coin] = price;
+        bool due = false;
+        for (const HolderRef& ref : holders_[coin]) {
+            Portfolio& p = portfolios_[ref.portfolio];
+            p.value += p.holdings[ref.holding].quantity * delta;
+            due |= ++p.updatesSinceRevalue >= REVALUE_AFTER;
+        }
+        // Only after every holding of the coin has its delta: a revalue
+        // part-way would count the rest of a portfolio's holdings twice.
+        if (due) {
+            for (const HolderRef& ref : holders_[coin]) {
+                if (portfolios_[ref.portfolio].updatesSinceRevalue >= REVALUE_AFTER) revalue(ref.portfolio);
+            }
+        }
+        ++updates_;
+    }
+
+    // Exact recomputation of one portfolio from its holdings.
+    void revalue(size_t portfolio) {
+        Portfolio& p = portfolios_[portfolio];
+        double value = 0.0, cost = 0.0;
+        for (const Holding& h : p.holdings) {
+            value += h.quantity * prices_[h.coin];
+            cost += h.costBasis;
+        }
+        p.value = value;
+        p.cost = cost;
+        p.updatesSinceRevalue = 0;
+    }
+
+    const std::vector<Portfolio>& portfolios() const { return portfolios_; }
+    const std::string& coinId(std::uint32_t coin) const { return coinIds_[coin]; }
+    double price(std::uint32_t coin) const { return prices_[coin]; }
+    unsigned long long priceUpdates() const { return updates_; }
+
+    double holdingValue(const Holding& h) const { return h.quantity * prices_[h.coin]; }
+
+    // Share of the portfolio's value in this holding (0..1)
+    double weight(const Portfolio& p, const Holding& h) const {
+        return p.value != 0.0 ? holdingValue(h) / p.value : 0.0;
+    }
+
+    // ---------------------------------------------------------------------
+    // Persistence (data/portfolios.dat), little-endian:
+    //   "CTP1"  u32 coin count, per coin: u8 len + id
+    //   u32 portfolio count, per portfolio:
+    //     u8 len + name, u8 flags (1 = watchlist), u32 holding count,
+    //     per holding: u32 coin, f64 quantity, f64 cost basis
+    // Prices are not stored; values fill in as the next refresh arrives.
+    // ---------------------------------------------------------------------
+    std::string serialize() const {
+        using namespace snapshot_codec;
+        std::string out;
+        size_t holdings = 0;
+        for (const auto& p : portfolios_) holdings += p.holdings.size();
+        out.reserve(16 + coinIds_.size() * 16 + portfolios_.size() * 32 + holdings * 20);
+
+        putBytes(out, "CTP1", 4);
+        putValue(out, static_cast<std::uint32_t>(coinIds_.size()));
+        for (const auto& id : coinIds_) putShortString(out, id);
+        putValue(out, static_cast<std::uint32_t>(portfolios_.size()));
+        for (const auto& p : portfolios_) {
+            putShortString(out, p.name);
+            putValue(out, static_cast<std::uint8_t>(p.watchlist ? 1 : 0));
+            putValue(out, static_cast<std::uint32_t>(p.holdings.size()));
+            for (const auto& h : p.holdings) {
+                putValue(out, h.coin);
+                putValue(out, h.quantity);
+                putValue(out, h.costBasis);
+            }
+        }
+        return out;
+    }
+
+    // Replaces the book with `data`. On a malformed file the book is left
+    // unchanged and false is returned.
+    bool deserialize(const std::string& data) {
+        Reader in{ data.data(), data.data() + data.size() };
+        if (!in.expect("CTP1", 4)) return false;
+
+        PortfolioBook book;
+        std::uint32_t coins = 0;
+        if (!in.get(coins)) return false;
+        for (std::uint32_t i = 0; i < coins; ++i) {
+            std::string id;
+            if (!in.getShortString(id)) return false;
+            book.intern(id);
+        }
+
+        std::uint32_t count = 0;
+        if (!in.get(count)) return false;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            Portfolio p;
+            std::uint8_t flags = 0;
+            std::uint32_t holdings = 0;
+            if (!in.getShortString(p.name) || !in.get(flags) || !in.get(holdings)) return false;
+            if (holdings > in.remaining() / 20) return false;
+            p.watchlist = (flags & 1) != 0;
+            p.holdings.resize(holdings);
+            for (auto& h : p.holdings) {
+                if (!in.get(h.coin) || !in.get(h.quantity) || !in.get(h.costBasis) || h.coin >= coins) return false;
+            }
+            book.portfolios_.push_back(std::move(p));
+        }
+
+        book.rebuildIndex();
+        for (size_t i = 0; i < book.portfolios_.size(); ++i) book.revalue(i);
+        *this = std::move(book);
+        return true;
+    }
+
+private:
+    struct HolderRef {
+        std::uint32_t portfolio;
+        std::uint32_t holding;
+    };
+
+    struct Reader {
+        const char* at;
+        const char* end;
+
+        size_t remaining() const { return static_cast<size_t>(end - at); }
+
+        bool expect(const char* magic, size_t len) {
+            if (remaining() < len || std::memcmp(at, magic, len) != 0) return false;
+            at += len;
+            return true;
+        }
+
+        template <typename T>
+        bool get(T& value) {
+            if (remaining() < sizeof(T)) return false;
+            std::memcpy(&value, at, sizeof(T));
+            at += sizeof(T);
+            return true;
+        }
+
+        bool getShortString(std::string& s) {
+            std::uint8_t len = 0;
+            if (!get(len) || remaining() < len) return false;
+            s.assign(at, len);
+            at += len;
+            return true;
+        }
+    };
+
+    std::uint32_t intern(const std::string& coinId) {
+        auto it = coinIndex_.find(coinId);
+        if (it != coinIndex_.end()) return it->second;
+        const std::uint32_t coin = static_cast<std::uint32_t>(coinIds_.size());
+        coinIndex_.emplace(coinId, coin);
+        coinIds_.push_back(coinId);
+        prices_.push_back(0.0);
+        holders_.emplace_back();
+        return coin;
+    }
+
+    void rebuildIndex() {
+        for (auto& refs : holders_) refs.clear();
+        for (size_t p = 0; p < portfolios_.size(); ++p) {
+            const auto& holdings = portfolios_[p].holdings;
+            for (size_t h = 0; h < holdings.size(); ++h) {
+                holders_[holdings[h].coin].push_back({ static_cast<std::uint32_t>(p), static_cast<std::uint32_t>(h) });
+            }
+        }
+    }
+
+    std::vector<Portfolio> portfolios_;
+    std::unordered_map<std::string, std::uint32_t> coinIndex_;
+    std::vector<std::string> coinIds_;
+    std::vector<double> prices_;                      // last price by coin
+    std::vector<std::vector<HolderRef>> holders_;     // holdings by coin
+    unsigned long long updates_ = 0;
+};
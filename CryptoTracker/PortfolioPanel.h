@@ -0,0 +1,155 @@
+#pragma once
+
+#include "imgui.h"
+#include "CoinText.h"
+#include "Portfolio.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Portfolios & watchlists panel: totals per portfolio (value, P&L), the
+// holdings with their weights, and controls to create lists and add the
+// selected coin. Values come straight from PortfolioBook, which keeps them
+// current as prices arrive, so drawing never re-sums holdings.
+// -------------------------------------------------------------------------
+
+// Input state kept across frames (owned by the caller).
+struct PortfolioPanelState {
+    char newName[64] = "";
+    int target = 0;            // portfolio the selected coin is added to
+    double quantity = 1.0;
+    double costBasis = 0.0;
+};
+
+// `selectedSymbol` (may be empty) is looked up in `coins` only when it is
+// added. `changed` is called after every edit (so the caller can save); the
+// caller holds the lock guarding `book` and `coins`.
+inline void DrawPortfolioPanel(PortfolioBook& book, const std::vector<CryptoCoin>& coins,
+    const std::string& selectedSymbol, PortfolioPanelState& state, const NumberFormat& format, const std::function<void()>& changed) {
+    if (!ImGui::CollapsingHeader("Portfolios & Watchlists")) return;
+
+    char value[40], pnl[40], amount[40];
+    const auto& portfolios = book.portfolios();
+    for (size_t i = 0; i < portfolios.size(); ++i) {
+        const Portfolio& p = portfolios[i];
+        ImGui::PushID(static_cast<int>(i));
+        bool open;
+        if (p.watchlist) {
+            open = ImGui::TreeNode("list", "%s (watchlist, %d coins)", p.name.c_str(), static_cast<int>(p.holdings.size()));
+        }
+        else {
+            FormatNumber(value, sizeof(value), p.value, 2, format, "$");
+            FormatNumber(pnl, sizeof(pnl), p.pnl(), 2, format, "$", "", true);
+            open = ImGui::TreeNode("list", "%s  %s  P&L %s (%+.2f%%)", p.name.c_str(), value, pnl, p.pnlPercent());
+        }
+        ImGui::SameLine();
+        bool removed = ImGui::SmallButton("Delete");
+
+        if (open) {
+            if (ImGui::BeginTable("holdings", p.watchlist ? 3 : 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                ImGui::TableSetupColumn("Coin");
+                ImGui::TableSetupColumn("Price");
+                if (!p.watchlist) {
+                    ImGui::TableSetupColumn("Quantity");
+                    ImGui::TableSetupColumn("Value");
+                    ImGui::TableSetupColumn("Weight");
+                }
+                ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, 20.0f);
+                ImGui::TableHeadersRow();
+
+                int removeRow = -1;
+                for (size_t h = 0; h < p.holdings.size(); ++h) {
+                    const Holding& holding = p.holdings[h];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(book.coinId(holding.coin).c_str());
+                    ImGui::TableNextColumn();
+                    FormatNumber(amount, sizeof(amount), book.price(holding.coin), PriceDecimals(book.price(holding.coin)), format, "$");
+                    ImGui::TextUnformatted(amount);
+                    if (!p.watchlist) {
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%g", holding.quantity);
+                        ImGui::TableNextColumn();
+                        FormatNumber(amount, sizeof(amount), book.holdingValue(holding), 2, format, "$");
+                        ImGui::TextUnformatted(amount);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.1f%%", book.weight(p, holding) * 100.0);
+                    }
+                    ImGui::TableNextColumn();
+                    ImGui::PushID(static_cast<int>(h));
+                    if (ImGui::SmallButton("x")) removeRow = static_cast<int>(h);
+                    ImGui::PopID();
+                }
+                ImGui::EndTable();
+
+                if (removeRow >= 0) {
+                    book.removeHolding(i, static_cast<size_t>(removeRow));
+                    changed();
+                }
+            }
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+
+        if (removed) {
+            book.removePortfolio(i);
+            changed();
+            break;   // indices shifted; the list is redrawn next frame
+        }
+    }
+
+    // --- create ---
+    ImGui::SetNextItemWidth(160.0f);
+    ImGui::InputText("##name", state.newName, IM_ARRAYSIZE(state.newName));
+    ImGui::SameLine();
+    if (ImGui::Button("New Portfolio") && state.newName[0]) {
+        state.target = static_cast<int>(book.addPortfolio(state.newName));
+        state.newName[0] = '\0';
+        changed();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("New Watchlist") && state.newName[0]) {
+        state.target = static_cast<int>(book.addPortfolio(state.newName, true));
+        state.newName[0] = '\0';
+        changed();
+    }
+
+    // --- add the selected coin ---
+    if (portfolios.empty() || selectedSymbol.empty()) {
+        ImGui::TextDisabled("Select a coin in the table to add it to a portfolio or watchlist.");
+        return;
+    }
+    if (state.target >= static_cast<int>(portfolios.size())) state.target = 0;
+    const Portfolio& target = portfolios[state.target];
+
+    ImGui::SetNextItemWidth(160.0f);
+    if (ImGui::BeginCombo("##target", target.name.c_str())) {
+        for (size_t i = 0; i < portfolios.size(); ++i) {
+            ImGui::PushID(static_cast<int>(i));
+            if (ImGui::Selectable(portfolios[i].name.c_str(), static_cast<int>(i) == state.target)) state.target = static_cast<int>(i);
+            ImGui::PopID();
+        }
+        ImGui::EndCombo();
+    }
+    if (!target.watchlist) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::InputDouble("Qty", &state.quantity);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::InputDouble("Cost $", &state.costBasis);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Add Selected Coin")) {
+        auto coin = std::find_if(coins.begin(), coins.end(),
+            [&](const CryptoCoin& c) { return c.symbol == selectedSymbol; });
+        if (coin != coins.end()) {
+            book.addHolding(static_cast<size_t>(state.target), coin->id, state.quantity, state.costBasis);
+            book.updatePrice(coin->id, coin->current_price);
+            changed();
+        }
+    }
+}
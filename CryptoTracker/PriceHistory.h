@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One dated price, e.g. from /coins/{id}/market_chart (MarketChart.h).
+struct HistoryPoint {
+    std::int64_t quotedAt = 0;   // epoch nanoseconds
+    double price = 0.0;
+};
+
+// Appends one price point to a coin's history, dropping the oldest points
+// beyond `maxPoints`.
+inline void AppendPricePoint(std::vector<float>& history, double price, size_t maxPoints) {
+    history.push_back(static_cast<float>(price));
+    if (history.size() > maxPoints) {
+        size_t extra = history.size() - maxPoints;
+        history.erase(history.begin(), history.begin() + extra);
+    }
+}
+
+// Appends a quote unless its source time shows it is one the history
+// already has. CoinGecko serves the same quote (same last_updated) until it
+// recomputes it, and a lane can receive an older quote than the other lane
+// already recorded. `quotedAt` is epoch nanoseconds, 0 if unknown (always
+// appended); `lastQuotedAt` is the source time of the newest point and is
+// advanced. Returns whether the point was appended.
+inline bool AppendQuote(std::vector<float>& history, std::int64_t& lastQuotedAt, double price,
+    std::int64_t quotedAt, size_t maxPoints) {
+    if (quotedAt != 0) {
+        if (quotedAt <= lastQuotedAt) return false;
+        lastQuotedAt = quotedAt;
+    }
+    AppendPricePoint(history, price, maxPoints);
+    return true;
+}
+
+// Prepends backfilled points (oldest first) to a coin's live history.
+// Only points older than the oldest live point (`oldestQuotedAt`) are
+// taken, and each must be newer than the one before it, so a quote is
+// never in the history twice; if the history is full, the newest of them
+// are kept. Into an empty history the newest point also advances
+// `lastQuotedAt`, which keeps older live quotes from following it.
+// A history whose points are undated (`oldestQuotedAt` 0) is left alone.
+// Returns how many points were prepended.
+inline size_t MergeBackfill(std::vector<float>& history, std::int64_t& oldestQuotedAt,
+    std::int64_t& lastQuotedAt, const std::vector<HistoryPoint>& points, size_t maxPoints) {
+    if (history.size() >= maxPoints || (!history.empty() && oldestQuotedAt == 0)) return 0;
+    const std::int64_t before = history.empty() ? std::numeric_limits<std::int64_t>::max() : oldestQuotedAt;
+
+    std::vector<float> older;
+    std::vector<std::int64_t> olderAt;
+    for (const HistoryPoint& point : points) {
+        if (point.quotedAt <= 0 || point.quotedAt >= before) continue;
+        if (!olderAt.empty() && point.quotedAt <= olderAt.back()) continue;
+        older.push_back(static_cast<float>(point.price));
+        olderAt.push_back(point.quotedAt);
+    }
+    const size_t room = maxPoints - history.size();
+    const size_t skip = older.size() > room ? older.size() - room : 0;
+    if (skip == older.size()) return 0;
+
+    if (history.empty() && olderAt.back() > lastQuotedAt) lastQuotedAt = olderAt.back();
+    oldestQuotedAt = olderAt[skip];
+    history.insert(history.begin(), older.begin() + static_cast<std::ptrdiff_t>(skip), older.end());
+    return older.size() - skip;
+}
+
+// The coins whose history was backfilled, most recently selected first.
+// A backfilled history is allowed to grow past the live cap, so the app
+// keeps only the last few selections that way and drops the rest.
+class BackfillLru {
+public:
+    explicit BackfillLru(size_t capacity) : capacity_(capacity) {}
+
+    bool contains(const std::string& symbol) const { return where_.count(symbol) > 0; }
+
+    // Marks `symbol` as the most recently selected, if it is held.
+    void touch(const std::string& symbol) {
+        auto it = where_.find(symbol);
+        if (it != where_.end()) order_.splice(order_.begin(), order_, it->second);
+    }
+
+    // Adds `symbol` as the most recently selected. Returns the symbol that
+    // made room for it, or an empty string.
+    std::string insert(const std::string& symbol) {
+        if (contains(symbol)) {
+            touch(symbol);
+            return std::string();
+        }
+        order_.push_front(symbol);
+        where_[symbol] = order_.begin();
+        if (order_.size() <= capacity_) return std::string();
+        std::string evicted = std::move(order_.back());
+        order_.pop_back();
+        where_.erase(evicted);
+        return evicted;
+    }
+
+    size_t size() const { return order_.size(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    size_t capacity_;
+    std::list<std::string> order_;
+    std::unordered_map<std::string, std::list<std::string>::iterator> where_;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Per-coin refresh priorities.
+//
+// Each coin keeps a smoothed volatility estimate (EWMA of squared log
+// returns per second). Since a random walk drifts by about
+// sigma * sqrt(age), that product is the expected relative error of the
+// price we are showing. It is scaled up for favorites and for rows the UI
+// actually drew recently; coins whose score crosses the threshold are due
+// and get batched into one ids= request, most urgent first.
+//
+// Not thread-safe: the app only touches it while holding g_dataMutex.
+// -------------------------------------------------------------------------
+class RefreshScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings {
+        double dueThreshold = 0.001;        // expected relative move (0.1%)
+        double defaultSigma = 1.8e-4;       // per sqrt(second), until we've seen two prices
+        double smoothing = 0.7;             // weight of the old volatility estimate
+        double favoriteWeight = 4.0;
+        double visibleWeight = 2.0;
+        std::chrono::seconds visibleFor{ 2 };   // a row counts as visible this long after drawing
+        std::chrono::seconds maxAge{ 300 };     // always due after this long
+    };
+
+    RefreshScheduler() = default;
+    explicit RefreshScheduler(Settings settings) : settings_(settings) {}
+
+    // A fresh price arrived for `id` (full refresh or targeted batch).
+    void observe(const std::string& id, double price, Clock::time_point now) {
+        Entry& e = entries_[id];
+        if (e.lastPrice > 0.0 && price > 0.0 && now > e.lastRefresh) {
+            double dt = std::chrono::duration<double>(now - e.lastRefresh).count();
+            double r = std::log(price / e.lastPrice);
+            double variance = r * r / dt;
+            e.variance = e.samples == 0
+                ? variance
+                : settings_.smoothing * e.variance + (1.0 - settings_.smoothing) * variance;
+            ++e.samples;
+        }
+        e.lastPrice = price;
+        e.lastRefresh = now;
+    }
+
+    // Upstream confirmed `id` unchanged (a 304): its age restarts, but
+    // there is no new price to learn the volatility from.
+    void touched(const std::string& id, Clock::time_point now) {
+        auto it = entries_.find(id);
+        if (it != entries_.end() && now > it->second.lastRefresh) it->second.lastRefresh = now;
+    }
+
+    void markVisible(const std::string& id, Clock::time_point now) {
+        auto it = entries_.find(id);
+        if (it != entries_.end()) it->second.lastVisible = now;
+    }
+
+    void setFavorite(const std::string& id, bool favorite) {
+        auto it = entries_.find(id);
+        if (it != entries_.end()) it->second.favorite = favorite;
+    }
+
+    // Expected relative error of the shown price, weighted by importance.
+    double score(const std::string& id, Clock::time_point now) const {
+        auto it = entries_.find(id);
+        if (it == entries_.end()) return 0.0;
+        return scoreOf(it->second, now);
+    }
+
+    double sigma(const std::string& id) const {
+        auto it = entries_.find(id);
+        if (it == entries_.end() || it->second.samples == 0) return settings_.defaultSigma;
+        return std::sqrt(it->second.variance);
+    }
+
+    // Up to `maxIds` due coins, most urgent first.
+    std::vector<std::string> dueBatch(Clock::time_point now, size_t maxIds) const {
+        std::vector<std::pair<double, const std::string*>> due;
+        for (const auto& kv : entries_) {
+            const Entry& e = kv.second;
+            double s = scoreOf(e, now);
+            if (s >= settings_.dueThreshold || now - e.lastRefresh >= settings_.maxAge) {
+                due.emplace_back(s, &kv.first);
+            }
+        }
+
+        size_t count = std::min(maxIds, due.size());
+        std::partial_sort(due.begin(), due.begin() + count, due.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        std::vector<std::string> ids;
+        ids.reserve(count);
+        for (size_t i = 0; i < count; ++i) ids.push_back(*due[i].second);
+        return ids;
+    }
+
+    // Drop coins that are no longer part of the universe.
+    template <typename KeepFn>
+    void retain(KeepFn keep) {
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (keep(it->first)) ++it;
+            else it = entries_.erase(it);
+        }
+    }
+
+    size_t size() const { return entries_.size(); }
+    const Settings& settings() const { return settings_; }
+
+private:
+    struct Entry {
+        double lastPrice = 0.0;
+        double variance = 0.0;       // per second
+        int samples = 0;
+        bool favorite = false;
+        Clock::time_point lastRefresh{};
+        Clock::time_point lastVisible{};
+    };
+
+    double scoreOf(const Entry& e, Clock::time_point now) const {
+        double age = std::chrono::duration<double>(now - e.lastRefresh).count();
+        if (age <= 0.0) return 0.0;
+
+        double sigma = e.samples == 0 ? settings_.defaultSigma : std::sqrt(e.variance);
+        double weight = 1.0;
+        if (e.favorite) weight *= settings_.favoriteWeight;
+        if (now - e.lastVisible <= settings_.visibleFor) weight *= settings_.visibleWeight;
+        return sigma * std::sqrt(age) * weight;
+    }
+
+    Settings settings_;
+    std::unordered_map<std::string, Entry> entries_;
+};
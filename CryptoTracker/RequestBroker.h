@@ -0,0 +1,393 @@
+#pragma once
+
+#include "APIClient.h"
+#include "MarketChart.h"
+#include "TrackerMetrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------
+// Request broker in front of APIClient.
+//
+// The full refresh, the scheduler's ids= batches, history backfill and
+// whatever comes next all want CoinGecko data on their own schedule, and
+// they can ask for the same thing at the same time. The broker makes
+// sure each piece of data is requested once:
+//   - identical calls in flight share one request: the first caller
+//     sends it, the others wait for its reply (single-flight);
+//   - an ids= call only asks for the ids nobody is already fetching; ids
+//     that another call has in flight are taken from that call's reply.
+//     The ids of calls arriving within a short window go out together,
+//     so overlapping batches become one request with each id once;
+//   - replies are kept for a short TTL, and every coin row of a markets
+//     reply (full list or ids=) can answer a later ids= call for it.
+// Upstream calls are counted in stats() and in the tracker metrics.
+// -------------------------------------------------------------------------
+
+struct BrokerStats {
+    unsigned long long calls = 0;          // calls from the app
+    unsigned long long upstream = 0;       // requests actually sent
+    unsigned long long coalesced = 0;      // calls that waited on another call's request
+    unsigned long long cacheHits = 0;      // calls answered from the cache alone
+    unsigned long long idsRequested = 0;   // ids asked for by ids= calls
+    unsigned long long idsSent = 0;        // of those, ids put on an upstream request
+};
+
+// Where the broker's requests go: CoinGecko, or a plain-HTTP host (the
+// benchmarks' mock upstream).
+struct BrokerUpstream {
+    std::function<std::vector<CryptoCoin>(const std::string& path, std::string& statusMsg, FetchStats* stats)> coins;
+    std::function<bool(const std::string& id, std::vector<HistoryPoint>& points, std::string& statusMsg)> chart;
+
+    static BrokerUpstream coinGecko() {
+        return { APIClient::fetchPath, APIClient::fetchMarketChart };
+    }
+
+    static BrokerUpstream host(const std::string& host, int port) {
+        BrokerUpstream upstream;
+        upstream.coins = [host, port](const std::string& path, std::string& statusMsg, FetchStats* stats) {
+            return APIClient::fetchFromHost(host, port, path, statusMsg, stats);
+        };
+        upstream.chart = [host, port](const std::string& id, std::vector<HistoryPoint>& points, std::string& statusMsg) {
+            return APIClient::fetchMarketChartFromHost(host, port, id, points, statusMsg);
+        };
+        return upstream;
+    }
+};
+
+class RequestBroker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Asked once before a call goes upstream, e.g. for a request-budget
+    // token; false answers the call (and any that joined it) with
+    // NOT_ADMITTED instead. Calls answered without a request never ask.
+    using Admit = std::function<bool()>;
+    static constexpr const char* NOT_ADMITTED = "Request budget spent; not sent.";
+
+    // `batchWindow` is how long an ids= request waits for other calls to
+    // add their ids; `maxIdsPerRequest` caps one request (CoinGecko
+    // serves up to 250 rows per page).
+    explicit RequestBroker(BrokerUpstream upstream = BrokerUpstream::coinGecko(),
+        Clock::duration ttl = std::chrono::seconds(5),
+        Clock::duration batchWindow = std::chrono::milliseconds(2), size_t maxIdsPerRequest = 250)
+        : upstream_(std::move(upstream)), ttl_(ttl), batchWindow_(batchWindow), maxIdsPerRequest_(maxIdsPerRequest) {}
+
+    // A /coins/markets path (MARKETS_PATH), as APIClient::fetchPath.
+    std::vector<CryptoCoin> fetch(const std::string& path, std::string& statusMsg,
+        FetchStats* stats = nullptr, const Admit& admit = nullptr) {
+        bool shared = false;
+        auto reply = once<CoinReply>(path, coinFlights_, coinReplies_, admit, shared,
+            [this, &path](CoinReply& r) { r.coins = upstream_.coins(path, r.statusMsg, &r.stats); },
+            [](const CoinReply& r) { return !r.coins.empty(); });
+        if (!shared) rememberRows(reply->coins);
+        statusMsg = reply->statusMsg;
+        if (stats) {
+            *stats = reply->stats;
+            stats->shared = shared;
+        }
+        return reply->coins;
+    }
+
+    // Rows for `ids`, in that order, as APIClient::fetchCoinsByIds. Rows
+    // that could not be had (failed request, 304, unknown id) are missing.
+    // Only the call that opens a request asks `admit`; calls that add
+    // their ids to it share its fate.
+    std::vector<CryptoCoin> fetchIds(const std::vector<std::string>& ids, std::string& statusMsg,
+        FetchStats* stats = nullptr, const Admit& admit = nullptr) {
+        std::unordered_map<std::string, CryptoCoin> found;
+        std::vector<std::string> missing;
+        std::vector<std::shared_ptr<IdsFlight>> joined;
+        std::shared_ptr<IdsFlight> own;
+        std::promise<std::shared_ptr<const CoinReply>> promise;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.calls;
+            stats_.idsRequested += ids.size();
+            const auto now = Clock::now();
+            for (const auto& id : ids) {
+                if (found.count(id)) continue;
+                auto row = rows_.find(id);
+                if (row != rows_.end() && row->second.expires > now) {
+                    found.emplace(id, row->second.coin);
+                    continue;
+                }
+                auto flight = idFlights_.find(id);
+                if (flight != idFlights_.end()) {
+                    if (std::find(joined.begin(), joined.end(), flight->second) == joined.end()) {
+                        joined.push_back(flight->second);
+                    }
+                    continue;
+                }
+                if (std::find(missing.begin(), missing.end(), id) == missing.end()) missing.push_back(id);
+            }
+            if (!missing.empty()) {
+                stats_.idsSent += missing.size();
+                if (openBatch_ && openBatch_->ids.size() + missing.size() <= maxIdsPerRequest_) {
+                    // A request is still collecting ids: add ours to it
+                    for (const auto& id : missing) {
+                        openBatch_->ids.push_back(id);
+                        idFlights_[id] = openBatch_;
+                    }
+                    if (std::find(joined.begin(), joined.end(), openBatch_) == joined.end()) joined.push_back(openBatch_);
+                    missing.clear();
+                    ++stats_.coalesced;
+                    trackerMetrics().brokerCoalesced.add();
+                }
+                else {
+                    own = std::make_shared<IdsFlight>();
+                    own->ids = missing;
+                    own->reply = promise.get_future().share();
+                    for (const auto& id : missing) idFlights_[id] = own;
+                    openBatch_ = own;
+                }
+            }
+            else if (!joined.empty()) {
+                ++stats_.coalesced;
+                trackerMetrics().brokerCoalesced.add();
+            }
+            else {
+                ++stats_.cacheHits;
+                trackerMetrics().brokerCached.add();
+            }
+        }
+
+        std::shared_ptr<const CoinReply> ownReply;
+        if (own) {
+            if (batchWindow_ > Clock::duration::zero()) std::this_thread::sleep_for(batchWindow_);
+            std::vector<std::string> batch;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (openBatch_ == own) openBatch_.reset();   // closed to newcomers
+                batch = own->ids;
+            }
+            auto endFlight = [this, &own, &batch] {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (const auto& id : batch) {
+                    auto flight = idFlights_.find(id);
+                    if (flight != idFlights_.end() && flight->second == own) idFlights_.erase(flight);
+                }
+            };
+            auto reply = std::make_shared<CoinReply>();
+            try {
+                send(admit, [&] {
+                    reply->coins = upstream_.coins(APIClient::idsPath(batch), reply->statusMsg, &reply->stats);
+                }, reply->statusMsg);
+            }
+            catch (...) {
+                // The calls that joined get the exception too; later calls
+                // must not find this flight
+                endFlight();
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+            rememberRows(reply->coins);
+            endFlight();
+            promise.set_value(reply);
+            ownReply = reply;
+        }
+
+        // Rows from the calls we joined and from our own, filtered to what
+        // was asked for. Status and stats come from our request if we sent
+        // one, else from the first call we joined.
+        const CoinReply* source = ownReply.get();
+        if (ownReply) collect(*ownReply, ids, found);
+        for (const auto& flight : joined) {
+            const CoinReply& reply = *flight->reply.get();   // kept alive by the flight
+            collect(reply, ids, found);
+            if (!source) source = &reply;
+        }
+
+        std::vector<CryptoCoin> coins;
+        coins.reserve(found.size());
+        for (const auto& id : ids) {
+            auto row = found.find(id);
+            if (row == found.end()) continue;
+            coins.push_back(std::move(row->second));
+            found.erase(row);
+        }
+        if (source) statusMsg = source->statusMsg;
+        else statusMsg = "Live Data: answered from the request cache";
+        if (stats) {
+            *stats = source ? source->stats : FetchStats();
+            stats->shared = !ownReply;
+        }
+        return coins;
+    }
+
+    // One coin's last-day chart, as APIClient::fetchMarketChart.
+    bool fetchMarketChart(const std::string& id, std::vector<HistoryPoint>& points, std::string& statusMsg,
+        const Admit& admit = nullptr) {
+        bool shared = false;
+        auto reply = once<ChartReply>(id, chartFlights_, chartReplies_, admit, shared,
+            [this, &id](ChartReply& r) { r.ok = upstream_.chart(id, r.points, r.statusMsg); },
+            [](const ChartReply& r) { return r.ok; });
+        points = reply->points;
+        statusMsg = reply->statusMsg;
+        return reply->ok;
+    }
+
+    BrokerStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    // Drops every cached reply (calls in flight are unaffected).
+    void clearCache() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        coinReplies_.clear();
+        chartReplies_.clear();
+        rows_.clear();
+    }
+
+private:
+    struct CoinReply {
+        std::vector<CryptoCoin> coins;
+        std::string statusMsg;
+        FetchStats stats;
+    };
+
+    struct ChartReply {
+        bool ok = false;
+        std::vector<HistoryPoint> points;
+        std::string statusMsg;
+    };
+
+    template <typename Reply>
+    using Pending = std::shared_future<std::shared_ptr<const Reply>>;
+
+    template <typename Reply>
+    struct Cached {
+        Clock::time_point expires;
+        std::shared_ptr<const Reply> reply;
+    };
+
+    struct IdsFlight {
+        std::vector<std::string> ids;   // grows until the request is sent
+        Pending<CoinReply> reply;
+    };
+
+    struct CachedRow {
+        Clock::time_point expires;
+        CryptoCoin coin;
+    };
+
+    // Runs `request` unless `admit` says no. Caller does not hold mutex_.
+    template <typename Request>
+    void send(const Admit& admit, Request request, std::string& statusMsg) {
+        if (admit && !admit()) {
+            statusMsg = NOT_ADMITTED;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.upstream;
+        }
+        trackerMetrics().brokerUpstream.add();
+        request();
+    }
+
+    // Single-flight with a TTL cache, keyed by `key`: a fresh cached reply,
+    // else the reply of the identical call in flight, else our own request
+    // (cached if `cacheable`). `shared` tells whether the reply was someone
+    // else's.
+    template <typename Reply, typename Request, typename Cacheable>
+    std::shared_ptr<const Reply> once(const std::string& key,
+        std::unordered_map<std::string, Pending<Reply>>& flights,
+        std::unordered_map<std::string, Cached<Reply>>& replies,
+        const Admit& admit, bool& shared, Request request, Cacheable cacheable) {
+        std::promise<std::shared_ptr<const Reply>> promise;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++stats_.calls;
+            auto cached = replies.find(key);
+            if (cached != replies.end() && cached->second.expires > Clock::now()) {
+                ++stats_.cacheHits;
+                trackerMetrics().brokerCached.add();
+                shared = true;
+                return cached->second.reply;
+            }
+            auto flight = flights.find(key);
+            if (flight != flights.end()) {
+                ++stats_.coalesced;
+                trackerMetrics().brokerCoalesced.add();
+                Pending<Reply> pending = flight->second;
+                lock.unlock();
+                shared = true;
+                return pending.get();
+            }
+            flights.emplace(key, promise.get_future().share());
+        }
+
+        auto reply = std::make_shared<Reply>();
+        try {
+            send(admit, [&] { request(*reply); }, reply->statusMsg);
+        }
+        catch (...) {
+            // Waiters get the exception too; later calls start afresh
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                flights.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flights.erase(key);
+            const auto now = Clock::now();
+            for (auto it = replies.begin(); it != replies.end();) {
+                if (it->second.expires <= now) it = replies.erase(it);
+                else ++it;
+            }
+            if (cacheable(*reply) && ttl_ > Clock::duration::zero()) replies[key] = { now + ttl_, reply };
+        }
+        promise.set_value(reply);
+        shared = false;
+        return reply;
+    }
+
+    // Keeps the rows of a markets reply for later ids= calls.
+    void rememberRows(const std::vector<CryptoCoin>& coins) {
+        if (ttl_ <= Clock::duration::zero()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        for (auto it = rows_.begin(); it != rows_.end();) {
+            if (it->second.expires <= now) it = rows_.erase(it);
+            else ++it;
+        }
+        for (const auto& coin : coins) rows_[coin.id] = { now + ttl_, coin };
+    }
+
+    static void collect(const CoinReply& reply, const std::vector<std::string>& ids,
+        std::unordered_map<std::string, CryptoCoin>& found) {
+        for (const auto& coin : reply.coins) {
+            if (found.count(coin.id)) continue;
+            if (std::find(ids.begin(), ids.end(), coin.id) != ids.end()) found.emplace(coin.id, coin);
+        }
+    }
+
+    BrokerUpstream upstream_;
+    Clock::duration ttl_;
+    Clock::duration batchWindow_;
+    size_t maxIdsPerRequest_;
+    mutable std::mutex mutex_;
+    BrokerStats stats_;
+    std::unordered_map<std::string, Pending<CoinReply>> coinFlights_;       // by path
+    std::unordered_map<std::string, Cached<CoinReply>> coinReplies_;        // by path
+    std::unordered_map<std::string, std::shared_ptr<IdsFlight>> idFlights_; // by coin id
+    std::shared_ptr<IdsFlight> openBatch_;                                  // ids= request still collecting
+    std::unordered_map<std::string, CachedRow> rows_;                       // by coin id
+    std::unordered_map<std::string, Pending<ChartReply>> chartFlights_;     // by coin id
+    std::unordered_map<std::string, Cached<ChartReply>> chartReplies_;      // by coin id
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+// -------------------------------------------------------------------------
+// Token bucket shared by every thread that talks to CoinGecko, so all
+// fetch lanes together stay inside one request quota.
+//
+// Tokens refill continuously (capacity per window). A caller can ask to
+// leave a reserve behind: the scheduler lane's ids= batches, the chart
+// backfill and the exchange rates pass MAIN_LANE_RESERVE (one token), so the
+// full-universe refresh always finds a token when it is due.
+// -------------------------------------------------------------------------
+class RequestBudget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // `now` parameters default to the real clock; simulations pass their own.
+    RequestBudget(int requestsPerWindow, std::chrono::seconds window, Clock::time_point now = Clock::now())
+        : capacity_(requestsPerWindow),
+          refillPerSecond_(static_cast<double>(requestsPerWindow) / window.count()),
+          tokens_(requestsPerWindow),
+          lastRefill_(now) {}
+
+    // Takes one token if more than `reserve` tokens are available.
+    bool tryAcquire(int reserve = 0, Clock::time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refill(now);
+        if (tokens_ < 1.0 + reserve) {
+            return false;
+        }
+        tokens_ -= 1.0;
+        ++granted_;
+        return true;
+    }
+
+    // After a rate-limit answer: empty the bucket so every lane backs off.
+    void drain(Clock::time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refill(now);
+        tokens_ = 0.0;
+    }
+
+    unsigned long long granted() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return granted_;
+    }
+
+private:
+    void refill(Clock::time_point now) {
+        if (now < lastRefill_) return;
+        double seconds = std::chrono::duration<double>(now - lastRefill_).count();
+        tokens_ = std::min<double>(capacity_, tokens_ + seconds * refillPerSecond_);
+        lastRefill_ = now;
+    }
+
+    mutable std::mutex mutex_;
+    const int capacity_;
+    const double refillPerSecond_;
+    double tokens_;
+    Clock::time_point lastRefill_;
+    unsigned long long granted_ = 0;
+};
@@ -0,0 +1,438 @@
+#pragma once
+
+#include "MarketSnapshot.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// -------------------------------------------------------------------------
+// Market table in shared memory for co-located processes.
+//
+// The tracker maps a fixed-size segment and rewrites it after every
+// published snapshot. Readers in other processes map it read-only and copy
+// single coins out under a seqlock: the writer makes the sequence odd
+// while it writes and even when it is done, and a reader retries if the
+// sequence was odd or changed during its copy. Readers never block the
+// writer or each other.
+//
+// Coins keep their slot ("handle") for as long as they stay in the
+// universe, so a reader can look a coin up once and then poll its handle.
+// Once every slot has been handed out, slots of coins that left the
+// universe are given to new coins, so a handle whose coin went inactive
+// may later read another coin (check `id`). A coin that finds no free slot
+// is not published and is counted in droppedCoins(). Every field, id and
+// symbol included, is a relaxed atomic read under the seqlock, so the
+// seqlock is race-free without relying on the compiler leaving plain
+// copies alone.
+//
+// Readers give up with `false` after MAX_READ_WAIT of retries: a writer
+// that died mid-write leaves the sequence odd for good.
+//
+// POSIX shared memory on Linux/macOS, a named file mapping on Windows.
+// -------------------------------------------------------------------------
+namespace shm_market {
+
+#ifdef _WIN32
+constexpr const char* SEGMENT_NAME = "Local\\CryptoTrackerMarket";
+#else
+constexpr const char* SEGMENT_NAME = "/cryptotracker_market";
+#endif
+
+constexpr std::uint32_t MAGIC = 0x4D4B5443;   // "CTKM"
+constexpr std::uint32_t LAYOUT_VERSION = 2;
+constexpr std::uint32_t CAPACITY = 16384;
+constexpr auto MAX_READ_WAIT = std::chrono::milliseconds(50);
+
+constexpr size_t ID_WORDS = 8;       // 63 chars + NUL
+constexpr size_t SYMBOL_WORDS = 2;   // 15 chars + NUL
+
+struct Coin {
+    std::atomic<std::uint64_t> id[ID_WORDS];           // NUL-padded text
+    std::atomic<std::uint64_t> symbol[SYMBOL_WORDS];
+    std::atomic<double> price;
+    std::atomic<double> change24h;
+    std::atomic<double> marketCap;
+    std::atomic<std::uint32_t> active;  // 0 once the coin left the universe
+    std::uint32_t reserved;
+};
+
+struct Header {
+    std::uint32_t magic;
+    std::uint32_t layout;
+    std::uint32_t capacity;
+    std::atomic<std::uint32_t> used;    // slots ever assigned (scan bound)
+    std::atomic<std::uint64_t> seq;     // seqlock: odd while the writer is active
+    std::atomic<std::uint64_t> snapshotVersion;
+    std::atomic<std::int64_t> publishedAtMs;
+};
+
+struct Segment {
+    Header header;
+    Coin coins[CAPACITY];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+    std::atomic<double>::is_always_lock_free,
+    "shared fields must be lock-free atomics to live in shared memory");
+
+// Platform mapping of the segment.
+class Mapping {
+public:
+    Mapping() = default;
+    ~Mapping() { close(); }
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    bool create() { return map(true); }
+    bool openReadOnly() { return map(false); }
+
+    Segment* segment() const { return segment_; }
+
+    void close() {
+        if (!segment_) return;
+#ifdef _WIN32
+        UnmapViewOfFile(segment_);
+        CloseHandle(handle_);
+        handle_ = nullptr;
+#else
+        munmap(segment_, sizeof(Segment));
+        if (owner_) shm_unlink(SEGMENT_NAME);
+#endif
+        segment_ = nullptr;
+    }
+
+private:
+    bool map(bool writable) {
+        close();
+#ifdef _WIN32
+        if (writable) {
+            handle_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                0, static_cast<DWORD>(sizeof(Segment)), SEGMENT_NAME);
+        }
+        else {
+            handle_ = OpenFileMappingA(FILE_MAP_READ, FALSE, SEGMENT_NAME);
+        }
+        if (!handle_) return false;
+
+        void* view = MapViewOfFile(handle_, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ,
+            0, 0, sizeof(Segment));
+        if (!view) {
+            CloseHandle(handle_);
+            handle_ = nullptr;
+            return false;
+        }
+#else
+        int fd = writable
+            ? shm_open(SEGMENT_NAME, O_CREAT | O_RDWR, 0644)
+            : shm_open(SEGMENT_NAME, O_RDONLY, 0);
+        if (fd < 0) return false;
+
+        if (writable && ftruncate(fd, sizeof(Segment)) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, sizeof(Segment),
+            writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) return false;
+        owner_ = writable;
+#endif
+        segment_ = static_cast<Segment*>(view);
+        return true;
+    }
+
+    Segment* segment_ = nullptr;
+#ifdef _WIN32
+    HANDLE handle_ = nullptr;
+#else
+    bool owner_ = false;
+#endif
+};
+
+// Text packed into NUL-padded words, truncated to fit.
+template <size_t Words>
+struct PackedText {
+    std::uint64_t words[Words] = {};
+
+    explicit PackedText(const std::string& text) {
+        char bytes[Words * 8] = {};
+        std::memcpy(bytes, text.data(), text.size() < sizeof bytes - 1 ? text.size() : sizeof bytes - 1);
+        std::memcpy(words, bytes, sizeof bytes);
+    }
+};
+
+template <size_t Words>
+void storeText(std::atomic<std::uint64_t> (&dst)[Words], const PackedText<Words>& text) {
+    for (size_t i = 0; i < Words; ++i) dst[i].store(text.words[i], std::memory_order_relaxed);
+}
+
+template <size_t Words>
+void loadText(char* dst, const std::atomic<std::uint64_t> (&src)[Words]) {
+    std::uint64_t words[Words];
+    for (size_t i = 0; i < Words; ++i) words[i] = src[i].load(std::memory_order_relaxed);
+    std::memcpy(dst, words, sizeof words);
+    dst[sizeof words - 1] = '\0';
+}
+
+template <size_t Words>
+bool sameText(const std::atomic<std::uint64_t> (&stored)[Words], const PackedText<Words>& text) {
+    for (size_t i = 0; i < Words; ++i) {
+        if (stored[i].load(std::memory_order_relaxed) != text.words[i]) return false;
+    }
+    return true;
+}
+
+// Bounds a seqlock retry loop to MAX_READ_WAIT (the clock is only read
+// every 1024 retries).
+class RetryLimit {
+public:
+    bool exhausted() {
+        if (++spins_ < 1024) return false;
+        spins_ = 0;
+        const auto now = std::chrono::steady_clock::now();
+        if (!started_) {
+            started_ = true;
+            deadline_ = now + MAX_READ_WAIT;
+            return false;
+        }
+        return now >= deadline_;
+    }
+
+private:
+    unsigned spins_ = 0;
+    bool started_ = false;
+    std::chrono::steady_clock::time_point deadline_;
+};
+
+} // namespace shm_market
+
+// ---------------------------------------------------------------------
+// Writer side, owned by the tracker.
+// ---------------------------------------------------------------------
+class SharedMarketWriter {
+public:
+    bool open() {
+        if (!mapping_.create()) return false;
+
+        shm_market::Header& h = mapping_.segment()->header;
+        h.seq.store(0, std::memory_order_relaxed);
+        h.capacity = shm_market::CAPACITY;
+        h.layout = shm_market::LAYOUT_VERSION;
+        h.used.store(0, std::memory_order_relaxed);
+        h.snapshotVersion.store(0, std::memory_order_relaxed);
+        h.publishedAtMs.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        h.magic = shm_market::MAGIC;   // readers check this last
+        return true;
+    }
+
+    bool isOpen() const { return mapping_.segment() != nullptr; }
+
+    // Copies the snapshot's coin table into the segment. Called from the
+    // publishing thread only (single writer). Returns false if some coins
+    // found no free slot (see droppedCoins()).
+    bool publish(const MarketSnapshot& snap) {
+        shm_market::Segment* seg = mapping_.segment();
+        if (!seg) return false;
+        shm_market::Header& h = seg->header;
+
+        constexpr auto relaxed = std::memory_order_relaxed;
+        ++publishes_;
+
+        std::uint64_t seq = h.seq.load(relaxed);
+        h.seq.store(seq + 1, relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // Coins still in the universe keep their slot; the slots of those
+        // that left become free once the segment has run out of new ones
+        std::uint32_t used = h.used.load(relaxed);
+        newCoins_.clear();
+        for (size_t c = 0; c < snap.coins.size(); ++c) {
+            auto it = slots_.find(snap.coins[c].id);
+            if (it != slots_.end()) seenIn_[it->second] = publishes_;
+            else newCoins_.push_back(c);
+        }
+        if (newCoins_.size() > shm_market::CAPACITY - used) {
+            for (auto it = slots_.begin(); it != slots_.end();) {
+                if (seenIn_[it->second] == publishes_) {
+                    ++it;
+                    continue;
+                }
+                free_.push_back(it->second);
+                it = slots_.erase(it);
+            }
+        }
+
+        dropped_ = 0;
+        for (size_t c : newCoins_) {
+            const CryptoCoin& coin = snap.coins[c];
+            std::uint32_t slot;
+            if (used < shm_market::CAPACITY) slot = used++;
+            else if (!free_.empty()) {
+                slot = free_.back();
+                free_.pop_back();
+            }
+            else {
+                ++dropped_;
+                continue;
+            }
+            shm_market::Coin& out = seg->coins[slot];
+            shm_market::storeText(out.id, shm_market::PackedText<shm_market::ID_WORDS>(coin.id));
+            shm_market::storeText(out.symbol, shm_market::PackedText<shm_market::SYMBOL_WORDS>(coin.symbol));
+            slots_.emplace(coin.id, slot);
+            seenIn_[slot] = publishes_;
+        }
+        h.used.store(used, relaxed);
+
+        for (std::uint32_t i = 0; i < used; ++i) seg->coins[i].active.store(0, relaxed);
+
+        for (const auto& coin : snap.coins) {
+            auto it = slots_.find(coin.id);
+            if (it == slots_.end()) continue;   // segment full
+
+            shm_market::Coin& out = seg->coins[it->second];
+            out.price.store(coin.current_price, relaxed);
+            out.change24h.store(coin.price_change_24h, relaxed);
+            out.marketCap.store(coin.market_cap, relaxed);
+            out.active.store(1, relaxed);
+        }
+
+        h.snapshotVersion.store(snap.version, relaxed);
+        h.publishedAtMs.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+            snap.publishedAt.time_since_epoch()).count(), relaxed);
+
+        h.seq.store(seq + 2, std::memory_order_release);
+        return dropped_ == 0;
+    }
+
+    // Coins of the last publish that did not fit (more coins in the
+    // universe than CAPACITY).
+    size_t droppedCoins() const { return dropped_; }
+
+private:
+    shm_market::Mapping mapping_;
+    std::unordered_map<std::string, std::uint32_t> slots_;   // coin id -> handle
+    std::vector<std::uint64_t> seenIn_ = std::vector<std::uint64_t>(shm_market::CAPACITY);   // by slot: last publish with its coin
+    std::vector<std::uint32_t> free_;                        // slots of coins that left
+    std::vector<size_t> newCoins_;                           // scratch: snapshot indices without a slot
+    std::uint64_t publishes_ = 0;
+    size_t dropped_ = 0;
+};
+
+// ---------------------------------------------------------------------
+// Reader library for other processes on the same machine.
+// ---------------------------------------------------------------------
+struct SharedQuote {
+    char id[64];
+    char symbol[16];
+    double price;
+    double change24h;
+    double marketCap;
+    bool active;
+    std::uint64_t snapshotVersion;
+};
+
+class SharedMarketReader {
+public:
+    using Handle = std::uint32_t;
+
+    bool open() {
+        if (!mapping_.openReadOnly()) return false;
+        const shm_market::Header& h = mapping_.segment()->header;
+        if (h.magic != shm_market::MAGIC || h.layout != shm_market::LAYOUT_VERSION) {
+            mapping_.close();
+            return false;
+        }
+        return true;
+    }
+
+    // Current snapshot version (0 until the tracker has published). False
+    // if the writer stayed mid-write for MAX_READ_WAIT.
+    bool version(std::uint64_t& out) const {
+        const shm_market::Header& h = mapping_.segment()->header;
+        shm_market::RetryLimit limit;
+        do {
+            std::uint64_t s1 = h.seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            std::uint64_t v = h.snapshotVersion.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (h.seq.load(std::memory_order_relaxed) == s1) {
+                out = v;
+                return true;
+            }
+        } while (!limit.exhausted());
+        return false;
+    }
+
+    // Looks up a coin by CoinGecko id. Do this once and keep the handle.
+    bool find(const char* id, Handle& handle) const {
+        const shm_market::Segment* seg = mapping_.segment();
+        const shm_market::PackedText<shm_market::ID_WORDS> wanted{ std::string(id) };
+        shm_market::RetryLimit limit;
+        do {
+            std::uint64_t s1 = seg->header.seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            std::uint32_t used = seg->header.used.load(std::memory_order_relaxed);
+            std::uint32_t found = shm_market::CAPACITY;
+            for (std::uint32_t i = 0; i < used && i < shm_market::CAPACITY; ++i) {
+                if (shm_market::sameText(seg->coins[i].id, wanted)) {
+                    found = i;
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seg->header.seq.load(std::memory_order_relaxed) != s1) continue;
+            if (found == shm_market::CAPACITY) return false;
+            handle = found;
+            return true;
+        } while (!limit.exhausted());
+        return false;
+    }
+
+    // Consistent copy of one coin. Retries while the writer is active; false
+    // for a handle never assigned or if the writer stayed mid-write for
+    // MAX_READ_WAIT.
+    bool read(Handle handle, SharedQuote& out) const {
+        const shm_market::Segment* seg = mapping_.segment();
+        if (handle >= shm_market::CAPACITY) return false;
+        const shm_market::Coin& coin = seg->coins[handle];
+        constexpr auto relaxed = std::memory_order_relaxed;
+
+        shm_market::RetryLimit limit;
+        do {
+            std::uint64_t s1 = seg->header.seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            if (handle >= seg->header.used.load(relaxed)) return false;
+
+            shm_market::loadText(out.id, coin.id);
+            shm_market::loadText(out.symbol, coin.symbol);
+            out.price = coin.price.load(relaxed);
+            out.change24h = coin.change24h.load(relaxed);
+            out.marketCap = coin.marketCap.load(relaxed);
+            out.active = coin.active.load(relaxed) != 0;
+            out.snapshotVersion = seg->header.snapshotVersion.load(relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seg->header.seq.load(std::memory_order_relaxed) == s1) return true;
+        } while (!limit.exhausted());
+        return false;
+    }
+
+private:
+    shm_market::Mapping mapping_;
+};
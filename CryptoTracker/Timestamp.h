@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// -------------------------------------------------------------------------
+// ISO-8601 timestamps as CoinGecko writes them ("2026-02-07T21:30:57.686Z"),
+// parsed straight into nanoseconds since the Unix epoch (UTC).
+//
+// The layout is fixed, so the parser reads digits at known offsets and
+// converts the date with days-from-civil arithmetic: no locale, no
+// std::tm, no timegm. Accepted:
+//   YYYY-MM-DD(T| )hh:mm:ss[.fraction][Z | +hh:mm | -hh:mm | +hhmm | -hhmm]
+// A missing zone means UTC. Digits past nanoseconds are ignored.
+// -------------------------------------------------------------------------
+
+namespace timestamp_detail {
+
+inline bool digits(const char* p, int count, int& out) {
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        const unsigned d = static_cast<unsigned>(p[i] - '0');
+        if (d > 9) return false;
+        value = value * 10 + static_cast<int>(d);
+    }
+    out = value;
+    return true;
+}
+
+// Days from 1970-01-01 to y-m-d in the proleptic Gregorian calendar
+// (H. Hinnant's days_from_civil).
+constexpr std::int64_t daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<std::int64_t>(era) * 146097 + doe - 719468;
+}
+
+constexpr int daysInMonth(int y, int m) {
+    constexpr int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    return m == 2 && leap ? 29 : days[m - 1];
+}
+
+} // namespace timestamp_detail
+
+// Parses `length` characters at `text`. False (and `epochNanos` untouched)
+// unless the whole input is one valid timestamp within the int64 range
+// (years 1678-2261).
+inline bool ParseIso8601(const char* text, size_t length, std::int64_t& epochNanos) {
+    using namespace timestamp_detail;
+    if (length < 19) return false;
+    const char* p = text;
+    const char* end = text + length;
+
+    int year, month, day, hour, minute, second;
+    if (!digits(p, 4, year) || p[4] != '-' || !digits(p + 5, 2, month) || p[7] != '-' ||
+        !digits(p + 8, 2, day) || (p[10] != 'T' && p[10] != 't' && p[10] != ' ') ||
+        !digits(p + 11, 2, hour) || p[13] != ':' || !digits(p + 14, 2, minute) || p[16] != ':' ||
+        !digits(p + 17, 2, second)) {
+        return false;
+    }
+    if (year < 1678 || year > 2261 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) ||
+        hour > 23 || minute > 59 || second > 60) {   // 60: leap second
+        return false;
+    }
+    p += 19;
+
+    std::int64_t nanos = 0;
+    if (p < end && (*p == '.' || *p == ',')) {
+        ++p;
+        const char* first = p;
+        std::int64_t scale = 100000000;
+        for (; p < end && static_cast<unsigned>(*p - '0') <= 9; ++p) {
+            nanos += (*p - '0') * scale;
+            scale /= 10;
+        }
+        if (p == first) return false;
+    }
+
+    int offsetMinutes = 0;
+    if (p < end) {
+        if (*p == 'Z' || *p == 'z') {
+            ++p;
+        }
+        else if (*p == '+' || *p == '-') {
+            const int sign = *p == '-' ? -1 : 1;
+            ++p;
+            int hh, mm;
+            if (end - p == 5 && p[2] == ':' && digits(p, 2, hh) && digits(p + 3, 2, mm)) p += 5;
+            else if (end - p == 4 && digits(p, 2, hh) && digits(p + 2, 2, mm)) p += 4;
+            else return false;
+            if (hh > 23 || mm > 59) return false;
+            offsetMinutes = sign * (hh * 60 + mm);
+        }
+    }
+    if (p != end) return false;
+
+    const std::int64_t seconds = daysFromCivil(year, month, day) * 86400
+        + hour * 3600 + minute * 60 + second - offsetMinutes * 60;
+    epochNanos = seconds * 1000000000 + nanos;
+    return true;
+}
+
+// Nanoseconds since the Unix epoch, now (for ages of parsed timestamps).
+inline std::int64_t EpochNanosNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+// -------------------------------------------------------------------------
+// Scoped trace spans, dumped as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev).
+//
+// Each thread records into its own ring buffer, so recording takes no lock
+// and never allocates after the buffer exists: two clock reads plus a few
+// relaxed stores per span. The newest EVENTS_PER_THREAD spans per thread are
+// kept. dumpJson() can run at any time from any thread; a slot overwritten
+// while it is being copied is skipped, never torn.
+//
+// Build with CRYPTOTRACKER_TRACING=0 to compile every CT_TRACE_* macro away.
+// -------------------------------------------------------------------------
+
+#ifndef CRYPTOTRACKER_TRACING
+#define CRYPTOTRACKER_TRACING 1
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t EVENTS_PER_THREAD = 1 << 15;   // 1.25 MB per traced thread
+
+// Timestamps are nanoseconds since the first use of the tracer.
+inline Clock::time_point epoch() {
+    static const Clock::time_point start = Clock::now();
+    return start;
+}
+
+inline std::int64_t toNs(Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t - epoch()).count();
+}
+
+class ThreadBuffer {
+public:
+    explicit ThreadBuffer(int tid) : tid_(tid), slots_(EVENTS_PER_THREAD) {}
+
+    int tid() const { return tid_; }
+
+    void setName(const char* name) { name_.store(name, std::memory_order_release); }
+    const char* name() const { return name_.load(std::memory_order_acquire); }
+
+    // Owning thread only. `category` and `name` must be string literals.
+    void record(const char* category, const char* name, std::int64_t startNs, std::int64_t durNs) {
+        constexpr auto relaxed = std::memory_order_relaxed;
+        std::uint64_t index = head_.load(relaxed);
+        Slot& slot = slots_[index & (EVENTS_PER_THREAD - 1)];
+
+        // Per-slot seqlock: odd while the slot is being rewritten
+        slot.seq.store(2 * index + 1, relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.category.store(category, relaxed);
+        slot.name.store(name, relaxed);
+        slot.startNs.store(startNs, relaxed);
+        slot.durNs.store(durNs, relaxed);
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    struct Event {
+        const char* category;
+        const char* name;
+        std::int64_t startNs;
+        std::int64_t durNs;
+    };
+
+    // Copy of the retained events, oldest first. Safe from any thread.
+    void collect(std::vector<Event>& out) const {
+        constexpr auto relaxed = std::memory_order_relaxed;
+        std::uint64_t head = head_.load(std::memory_order_acquire);
+        std::uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+        for (std::uint64_t i = first; i < head; ++i) {
+            const Slot& slot = slots_[i & (EVENTS_PER_THREAD - 1)];
+            std::uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+            if (s1 != 2 * i + 2) continue;   // being rewritten or already reused
+
+            Event e{ slot.category.load(relaxed), slot.name.load(relaxed),
+                slot.startNs.load(relaxed), slot.durNs.load(relaxed) };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(relaxed) == s1) out.push_back(e);
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> seq{ 0 };
+        std::atomic<const char*> category{ nullptr };
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<std::int64_t> startNs{ 0 };
+        std::atomic<std::int64_t> durNs{ 0 };
+    };
+
+    const int tid_;
+    std::atomic<const char*> name_{ nullptr };
+    std::atomic<std::uint64_t> head_{ 0 };
+    std::vector<Slot> slots_;
+};
+
+// All thread buffers ever created. Buffers outlive their threads so a dump
+// still shows work done by threads that have exited; the buffer of an
+// exited thread is handed to the next new thread (continuing its ring on
+// the same track), so short-lived threads do not add 1.25 MB each.
+class Registry {
+public:
+    ThreadBuffer* acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            ThreadBuffer* buffer = free_.back();
+            free_.pop_back();
+            return buffer;
+        }
+        buffers_.push_back(std::make_shared<ThreadBuffer>(static_cast<int>(buffers_.size()) + 1));
+        return buffers_.back().get();
+    }
+
+    // The owning thread is exiting.
+    void release(ThreadBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(buffer);
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffers_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::vector<ThreadBuffer*> free_;   // of exited threads
+};
+
+inline Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// The calling thread's buffer, returned to the registry when it exits.
+struct ThreadBufferLease {
+    ThreadBuffer* buffer = registry().acquire();
+    ~ThreadBufferLease() { registry().release(buffer); }
+};
+
+inline ThreadBuffer& threadBuffer() {
+    thread_local ThreadBufferLease lease;
+    return *lease.buffer;
+}
+
+// Names the calling thread's track in the viewer (string literal).
+inline void setThreadName(const char* name) { threadBuffer().setName(name); }
+
+// Records a span that was timed by the caller.
+inline void complete(const char* category, const char* name, Clock::time_point begin, Clock::time_point end) {
+    std::int64_t durNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    threadBuffer().record(category, name, toNs(begin), durNs > 0 ? durNs : 0);
+}
+
+// Times the enclosing scope, or until end() is called.
+class Span {
+public:
+    Span(const char* category, const char* name)
+        : category_(category), name_(name), begin_(Clock::now()) {}
+    ~Span() { end(); }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    void end() {
+        if (!category_) return;
+        complete(category_, name_, begin_, Clock::now());
+        category_ = nullptr;
+    }
+
+private:
+    const char* category_;
+    const char* name_;
+    Clock::time_point begin_;
+};
+
+// Chrome trace-event JSON ("X" complete events plus thread names).
+inline std::string dumpJson() {
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char buf[320];
+
+    std::vector<ThreadBuffer::Event> events;
+    for (const auto& buffer : registry().buffers()) {
+        if (const char* name = buffer->name()) {
+            std::snprintf(buf, sizeof(buf),
+                "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", buffer->tid(), name);
+            out += buf;
+            first = false;
+        }
+
+        events.clear();
+        buffer->collect(events);
+        for (const auto& e : events) {
+            std::snprintf(buf, sizeof(buf),
+                "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"cat\":\"%s\",\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",", buffer->tid(), e.category, e.name, e.startNs / 1000.0, e.durNs / 1000.0);
+            out += buf;
+            first = false;
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+inline bool writeFile(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    std::string json = dumpJson();
+    bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+} // namespace trace
+
+#define CT_TRACE_CONCAT_INNER(a, b) a##b
+#define CT_TRACE_CONCAT(a, b) CT_TRACE_CONCAT_INNER(a, b)
+
+#if CRYPTOTRACKER_TRACING
+// Span over the rest of the enclosing scope.
+#define CT_TRACE_SCOPE(category, name) \
+    ::trace::Span CT_TRACE_CONCAT(ctTraceSpan_, __LINE__)(category, name)
+// Named span that can be closed early with CT_TRACE_END(var).
+#define CT_TRACE_BEGIN(var, category, name) ::trace::Span var(category, name)
+#define CT_TRACE_END(var) var.end()
+// Span between two steady_clock time points measured by the caller.
+#define CT_TRACE_COMPLETE(category, name, begin, end) ::trace::complete(category, name, begin, end)
+#define CT_TRACE_THREAD_NAME(name) ::trace::setThreadName(name)
+#else
+#define CT_TRACE_SCOPE(category, name) ((void)0)
+#define CT_TRACE_BEGIN(var, category, name) ((void)0)
+#define CT_TRACE_END(var) ((void)0)
+#define CT_TRACE_COMPLETE(category, name, begin, end) ((void)0)
+#define CT_TRACE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "AllocTracker.h"
+#include "Metrics.h"
+
+// -------------------------------------------------------------------------
+// The tracker's own metrics, registered once on first use and exported at
+// /metrics by LocalApiServer.
+// -------------------------------------------------------------------------
+struct TrackerMetrics {
+    // fetch phases (APIClient)
+    metrics::Histogram fetchDns;        // request start -> socket created (name lookup)
+    metrics::Histogram fetchConnect;    // socket -> response headers (TCP + TLS + server wait)
+    metrics::Histogram fetchTransfer;   // headers -> last byte, minus decode time
+    metrics::Histogram fetchParse;      // time spent inside the decoder
+
+    metrics::Counter fetchUpdated;
+    metrics::Counter fetchNotModified;
+    metrics::Counter fetchFailed;
+    metrics::Counter bytesOnWire;
+    metrics::Counter bytesDecoded;
+
+    // request broker: how each call from the app was answered
+    metrics::Counter brokerUpstream;    // sent a request of its own
+    metrics::Counter brokerCoalesced;   // waited on another caller's request
+    metrics::Counter brokerCached;      // answered from the short-TTL cache
+
+    // market providers (MarketProviders.h): extra requests and why
+    metrics::Counter providerHedges;     // first provider slow, second asked too
+    metrics::Counter providerFailovers;  // provider failed, next one asked
+
+    // publication and UI
+    metrics::Histogram snapshotPublish;  // serialize + swap + listeners (capture excluded)
+    metrics::Histogram frame;            // one UI frame, NewFrame -> draw data submitted
+    metrics::Gauge historyBytes;         // price history payload held by the app
+    metrics::Gauge coins;                // coins in the current snapshot
+
+    // heap allocations per cycle (only counted with CRYPTOTRACKER_ALLOC_TRACKING=1)
+    alloc::ScopeStats refreshAllocations;    // DataFetcher: fetch -> apply -> publish
+    alloc::ScopeStats schedulerAllocations;  // ScheduledFetcher tick
+    alloc::ScopeStats frameAllocations;      // UI frame, same span as `frame`
+
+    TrackerMetrics() {
+        metrics::Registry& r = metrics::registry();
+        const char* phaseHelp = "Duration of each phase of a CoinGecko market request.";
+        r.add("cryptotracker_fetch_phase_seconds", phaseHelp, "phase=\"dns\"", fetchDns);
+        r.add("cryptotracker_fetch_phase_seconds", phaseHelp, "phase=\"connect_tls\"", fetchConnect);
+        r.add("cryptotracker_fetch_phase_seconds", phaseHelp, "phase=\"transfer\"", fetchTransfer);
+        r.add("cryptotracker_fetch_phase_seconds", phaseHelp, "phase=\"parse\"", fetchParse);
+
+        const char* requestHelp = "Market requests by outcome.";
+        r.add("cryptotracker_fetch_requests_total", requestHelp, "outcome=\"updated\"", fetchUpdated);
+        r.add("cryptotracker_fetch_requests_total", requestHelp, "outcome=\"not_modified\"", fetchNotModified);
+        r.add("cryptotracker_fetch_requests_total", requestHelp, "outcome=\"failed\"", fetchFailed);
+
+        r.add("cryptotracker_fetch_bytes_on_wire_total", "Response body bytes received, before decompression.", "", bytesOnWire);
+        r.add("cryptotracker_fetch_bytes_decoded_total", "Response body bytes fed to the decoder.", "", bytesDecoded);
+
+        const char* brokerHelp = "Fetch-layer calls by how they were answered.";
+        r.add("cryptotracker_broker_calls_total", brokerHelp, "answer=\"upstream\"", brokerUpstream);
+        r.add("cryptotracker_broker_calls_total", brokerHelp, "answer=\"coalesced\"", brokerCoalesced);
+        r.add("cryptotracker_broker_calls_total", brokerHelp, "answer=\"cache\"", brokerCached);
+
+        const char* providerHelp = "Requests sent to another market provider, by reason.";
+        r.add("cryptotracker_provider_extra_requests_total", providerHelp, "reason=\"hedge\"", providerHedges);
+        r.add("cryptotracker_provider_extra_requests_total", providerHelp, "reason=\"failover\"", providerFailovers);
+
+        r.add("cryptotracker_snapshot_publish_seconds", "Time to serialize and publish a snapshot.", "", snapshotPublish);
+        r.add("cryptotracker_frame_seconds", "UI frame time.", "", frame);
+        r.add("cryptotracker_history_bytes", "Bytes of price history held in memory.", "", historyBytes);
+        r.add("cryptotracker_coins", "Coins in the current snapshot.", "", coins);
+
+        if (alloc::enabled()) {
+            refreshAllocations.registerMetrics(r, "refresh");
+            schedulerAllocations.registerMetrics(r, "scheduler");
+            frameAllocations.registerMetrics(r, "frame");
+        }
+    }
+};
+
+inline TrackerMetrics& trackerMetrics() {
+    static TrackerMetrics instance;
+    return instance;
+}
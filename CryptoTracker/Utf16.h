@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CT_UTF16_SSE2 1
+#endif
+
+// -------------------------------------------------------------------------
+// UTF-16LE to UTF-8, streaming.
+//
+// PowerShell saves captures (Invoke-RestMethod ... | ConvertTo-Json >
+// file) as UTF-16LE, and a market payload is almost all ASCII: keys,
+// numbers, ids and a lot of indentation. So the transcoder copies ASCII
+// runs in bulk - 16 code units per step with SSE2 (narrowed with one
+// pack), 4 per step with a 64-bit word elsewhere - and only drops to the
+// per-unit path for the rare non-ASCII name.
+//
+// Chunks may split a code unit or a surrogate pair anywhere. Unpaired
+// surrogates become U+FFFD. Assumes a little-endian host (x86, ARM).
+// -------------------------------------------------------------------------
+
+namespace utf16_detail {
+
+// Copies the leading run of ASCII code units of `in` to `out` as bytes.
+// Returns how many units were copied (a multiple of 4, possibly 0).
+inline size_t copyAsciiRun(const unsigned char* in, size_t units, char* out) {
+    size_t i = 0;
+#ifdef CT_UTF16_SSE2
+    const __m128i highBits = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= units; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 16));
+        const __m128i high = _mm_and_si128(_mm_or_si128(a, b), highBits);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, zero)) != 0xFFFF) break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+    }
+#endif
+    for (; i + 4 <= units; i += 4) {
+        std::uint64_t word;
+        std::memcpy(&word, in + 2 * i, sizeof word);
+        if (word & 0xFF80FF80FF80FF80ull) break;
+        out[i] = static_cast<char>(word);
+        out[i + 1] = static_cast<char>(word >> 16);
+        out[i + 2] = static_cast<char>(word >> 32);
+        out[i + 3] = static_cast<char>(word >> 48);
+    }
+    return i;
+}
+
+} // namespace utf16_detail
+
+class Utf16LeTranscoder {
+public:
+    // `asciiFastPath` false converts unit by unit (a baseline for benchmarks).
+    explicit Utf16LeTranscoder(bool asciiFastPath = true) : fastPath_(asciiFastPath) {}
+
+    // Appends the UTF-8 for `len` more bytes of UTF-16LE to `out`.
+    void feed(const char* data, size_t len, std::string& out) {
+        if (len == 0) return;
+        const size_t start = out.size();
+        // Worst case 3 bytes per unit, plus a pending surrogate or odd byte
+        out.resize(start + (len / 2 + 2) * 3);
+        char* o = &out[start];
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* end = in + len;
+
+        if (hasOddByte_) {
+            put(static_cast<std::uint16_t>(oddByte_ | (in[0] << 8)), o);
+            hasOddByte_ = false;
+            ++in;
+        }
+        while (end - in >= 2) {
+            if (fastPath_ && high_ == 0) {
+                const size_t copied = utf16_detail::copyAsciiRun(in, static_cast<size_t>(end - in) / 2, o);
+                in += 2 * copied;
+                o += copied;
+                if (end - in < 2) break;
+            }
+            put(static_cast<std::uint16_t>(in[0] | (in[1] << 8)), o);
+            in += 2;
+        }
+        if (in < end) {
+            oddByte_ = *in;
+            hasOddByte_ = true;
+        }
+        out.resize(static_cast<size_t>(o - out.data()));
+    }
+
+    // End of input: a dangling high surrogate or half unit becomes U+FFFD.
+    void finish(std::string& out) {
+        if (high_ != 0 || hasOddByte_) out += "\xEF\xBF\xBD";
+        high_ = 0;
+        hasOddByte_ = false;
+    }
+
+private:
+    static void put3(std::uint32_t cp, char*& o) {
+        *o++ = static_cast<char>(0xE0 | (cp >> 12));
+        *o++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+
+    void put(std::uint16_t unit, char*& o) {
+        if (high_ != 0) {
+            if (unit >= 0xDC00 && unit < 0xE000) {
+                const std::uint32_t cp = 0x10000 + ((high_ - 0xD800u) << 10) + (unit - 0xDC00u);
+                *o++ = static_cast<char>(0xF0 | (cp >> 18));
+                *o++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                *o++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                *o++ = static_cast<char>(0x80 | (cp & 0x3F));
+                high_ = 0;
+                return;
+            }
+            put3(0xFFFD, o);
+            high_ = 0;
+        }
+        if (unit < 0x80) {
+            *o++ = static_cast<char>(unit);
+        }
+        else if (unit < 0x800) {
+            *o++ = static_cast<char>(0xC0 | (unit >> 6));
+            *o++ = static_cast<char>(0x80 | (unit & 0x3F));
+        }
+        else if (unit >= 0xD800 && unit < 0xDC00) {
+            high_ = unit;
+        }
+        else {
+            put3(unit >= 0xDC00 && unit < 0xE000 ? 0xFFFD : unit, o);
+        }
+    }
+
+    bool fastPath_;
+    std::uint16_t high_ = 0;        // high surrogate waiting for its pair
+    unsigned char oddByte_ = 0;     // first byte of a unit split across chunks
+    bool hasOddByte_ = false;
+};